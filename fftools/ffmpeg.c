@@ -347,6 +347,7 @@ static void ffmpeg_cleanup(int ret)
     hw_device_free_all();
 
     av_freep(&filter_nbthreads);
+    av_freep(&filter_thread_type);
 
     av_freep(&print_graphs_file);
     av_freep(&print_graphs_format);
@@ -670,6 +670,8 @@ typedef struct OutputStream {
     int top_field_first;
 #endif
     int bitexact;
+    // the encoder thread count was set by the user
+    int threads_manual;
     int bits_per_raw_sample;
 
     AVRational frame_aspect_ratio;
@@ -782,8 +784,10 @@ extern AVIOContext *progress_avio;
 extern float max_error_rate;
 
 extern char *filter_nbthreads;
+extern char *filter_thread_type;
 extern int filter_complex_nbthreads;
 extern int filter_buffered_frames;
+extern int thread_budget;
 extern int vstats_version;
 extern int print_graphs;
 extern char *print_graphs_file;
@@ -341,6 +341,11 @@ int enc_open(void *opaque, const AVFrame *frame)
         return ret;
     }
 
+    // an explicit -threads, including 0, takes precedence over the budget
+    if (!ost->threads_manual)
+        enc_ctx->thread_count = sch_thread_share(ep->sch, SCH_NODE_TYPE_ENC,
+                                                 ep->sch_idx, thread_budget);
+
     if ((ret = avcodec_open2(enc_ctx, enc, NULL)) < 0) {
         if (ret != AVERROR_EXPERIMENTAL)
             av_log(e, AV_LOG_ERROR, "Error while opening encoder - maybe "
@@ -2086,6 +2086,12 @@ static int configure_filtergraph(FilterGraph *fg, FilterGraphThread *fgt)
             ret = av_opt_set_int(fgt->graph, "threads", fgp->nb_threads, 0);
             if (ret < 0)
                 return ret;
+        } else if (thread_budget > 0) {
+            ret = av_opt_set_int(fgt->graph, "threads",
+                                 sch_thread_share(fgp->sch, SCH_NODE_TYPE_FILTER_IN,
+                                                  fgp->sch_idx, thread_budget), 0);
+            if (ret < 0)
+                goto fail;
         }
 
         if (av_dict_count(ofp->sws_opts)) {
@@ -2105,7 +2111,9 @@ static int configure_filtergraph(FilterGraph *fg, FilterGraphThread *fgt)
             av_free(args);
         }
     } else {
-        fgt->graph->nb_threads = filter_complex_nbthreads;
+        fgt->graph->nb_threads = filter_complex_nbthreads ? filter_complex_nbthreads :
+                                 sch_thread_share(fgp->sch, SCH_NODE_TYPE_FILTER_IN,
+                                                  fgp->sch_idx, thread_budget);
     }
 
     if (filter_buffered_frames) {
@@ -2114,6 +2122,12 @@ static int configure_filtergraph(FilterGraph *fg, FilterGraphThread *fgt)
             return ret;
     }
 
+    if (filter_thread_type) {
+        ret = av_opt_set(fgt->graph, "thread_type", filter_thread_type, 0);
+        if (ret < 0)
+            goto fail;
+    }
+
     hw_device = hw_device_for_filter();
 
     ret = graph_parse(fg, fgt->graph, graph_desc, &inputs, &outputs, hw_device);
@@ -1436,6 +1436,7 @@ static int ost_add(Muxer *mux, const OptionsContext *o, enum AVMediaType type,
         // default to automatic thread count
         if (!threads_manual)
             ost->enc->enc_ctx->thread_count = 0;
+        ost->threads_manual = threads_manual;
     } else {
         ret = filter_codec_opts(o->g->codec_opts, AV_CODEC_ID_NONE, oc, st,
                                 NULL, &encoder_opts,
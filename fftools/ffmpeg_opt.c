@@ -74,8 +74,10 @@ int print_stats       = -1;
 int stdin_interaction = 1;
 float max_error_rate  = 2.0/3;
 char *filter_nbthreads;
+char *filter_thread_type = NULL;
 int filter_complex_nbthreads = 0;
 int filter_buffered_frames = 0;
+int thread_budget = 0;
 int vstats_version = 2;
 int print_graphs = 0;
 char *print_graphs_file = NULL;
@@ -1813,6 +1815,9 @@ const OptionDef options[] = {
     { "filter_threads",         OPT_TYPE_FUNC, OPT_FUNC_ARG | OPT_EXPERT,
         { .func_arg = opt_filter_threads },
         "number of non-complex filter threads" },
+    { "filter_thread_type",     OPT_TYPE_STRING, OPT_EXPERT,
+        { &filter_thread_type },
+        "threading types allowed in filter graphs", "flags" },
     { "filter_buffered_frames", OPT_TYPE_INT, OPT_EXPERT,
         { &filter_buffered_frames },
         "maximum number of buffered frames in a filter graph" },
@@ -1833,6 +1838,9 @@ const OptionDef options[] = {
     { "filter_complex_threads", OPT_TYPE_INT, OPT_EXPERT,
         { &filter_complex_nbthreads },
         "number of threads for -filter_complex" },
+    { "thread_budget",          OPT_TYPE_INT, OPT_EXPERT,
+        { &thread_budget },
+        "total number of threads shared by all decoders, encoders and filtergraphs", "nb_threads" },
     { "lavfi",               OPT_TYPE_FUNC, OPT_FUNC_ARG | OPT_EXPERT,
         { .func_arg = opt_filter_complex },
         "create a complex filtergraph", "graph_description" },
@@ -95,6 +95,9 @@ typedef struct SchDec {
 
     // temporary storage used by sch_dec_send()
     AVFrame            *send_frame;
+
+    // share of the thread budget, 0 if not allocated yet
+    int                 nb_threads;
 } SchDec;
 
 typedef struct SchSyncQueue {
@@ -145,6 +148,9 @@ typedef struct SchEnc {
 
     // temporary storage used by sch_enc_send()
     AVPacket           *send_pkt;
+
+    // share of the thread budget, 0 if not allocated yet
+    int                 nb_threads;
 } SchEnc;
 
 typedef struct SchDemuxStream {
@@ -262,6 +268,9 @@ typedef struct SchFilterGraph {
     // protected by schedule_lock
     unsigned            best_input;
     int                 task_exited;
+
+    // share of the thread budget, 0 if not allocated yet
+    int                 nb_threads;
 } SchFilterGraph;
 
 enum SchedulerState {
@@ -303,6 +312,11 @@ struct Scheduler {
     char               *sdp_filename;
     int                 sdp_auto;
 
+    // thread budget already handed out by sch_thread_share()
+    pthread_mutex_t     thread_share_lock;
+    unsigned         nb_thread_shares;
+    int                 threads_shared;
+
     enum SchedulerState state;
     atomic_int          terminate;
 
@@ -598,6 +612,7 @@ void sch_free(Scheduler **psch)
     av_freep(&sch->sdp_filename);
 
     pthread_mutex_destroy(&sch->schedule_lock);
+    pthread_mutex_destroy(&sch->thread_share_lock);
 
     pthread_mutex_destroy(&sch->mux_ready_lock);
 
@@ -632,6 +647,10 @@ Scheduler *sch_alloc(void)
     if (ret)
         goto fail;
 
+    ret = pthread_mutex_init(&sch->thread_share_lock, NULL);
+    if (ret)
+        goto fail;
+
     ret = pthread_mutex_init(&sch->finish_lock, NULL);
     if (ret)
         goto fail;
@@ -653,6 +672,65 @@ int sch_sdp_filename(Scheduler *sch, const char *sdp_filename)
     return sch->sdp_filename ? 0 : AVERROR(ENOMEM);
 }
 
+int sch_thread_share(Scheduler *sch, enum SchedulerNodeType type,
+                     unsigned idx, int budget)
+{
+    const unsigned nb_nodes = sch->nb_dec + sch->nb_enc + sch->nb_filters;
+    int *nb_threads;
+    int ret;
+
+    if (budget <= 0)
+        return 0;
+
+    switch (type) {
+    case SCH_NODE_TYPE_DEC:
+        av_assert0(idx < sch->nb_dec);
+        nb_threads = &sch->dec[idx].nb_threads;
+        break;
+    case SCH_NODE_TYPE_ENC:
+        av_assert0(idx < sch->nb_enc);
+        nb_threads = &sch->enc[idx].nb_threads;
+        break;
+    case SCH_NODE_TYPE_FILTER_IN:
+    case SCH_NODE_TYPE_FILTER_OUT:
+        av_assert0(idx < sch->nb_filters);
+        nb_threads = &sch->filters[idx].nb_threads;
+        break;
+    default:
+        av_assert0(0);
+    }
+
+    pthread_mutex_lock(&sch->thread_share_lock);
+
+    if (!*nb_threads) {
+        // split what is left of the budget among the nodes that do not have
+        // a share yet, including this one; nodes added later can then still
+        // get at least one thread without exceeding the budget
+        const unsigned nb_left = nb_nodes - sch->nb_thread_shares;
+        int share = (budget - sch->threads_shared) / FFMAX(nb_left, 1);
+
+        // a single thread is the node's own, not taken from the budget
+        if (share > 1)
+            sch->threads_shared += share;
+        else
+            share = 1;
+
+        *nb_threads = share;
+        sch->nb_thread_shares++;
+
+        av_log(sch, AV_LOG_VERBOSE, "Thread budget: %d thread(s) for %s %u, "
+               "%d of %d in use\n", share,
+               type == SCH_NODE_TYPE_DEC ? "decoder" :
+               type == SCH_NODE_TYPE_ENC ? "encoder" : "filtergraph",
+               idx, sch->threads_shared, budget);
+    }
+    ret = *nb_threads;
+
+    pthread_mutex_unlock(&sch->thread_share_lock);
+
+    return ret;
+}
+
 static const AVClass sch_mux_class = {
     .class_name                = "SchMux",
     .version                   = LIBAVUTIL_VERSION_INT,
@@ -300,6 +300,32 @@ int sch_mux_stream_ready(Scheduler *sch, unsigned mux_idx, unsigned stream_idx);
  */
 int sch_sdp_filename(Scheduler *sch, const char *sdp_filename);
 
+/**
+ * Get the number of worker threads a single decoder, encoder or filtergraph
+ * should use so that all the nodes together stay within a global thread
+ * budget.
+ *
+ * Since every node already runs in its own thread, this only accounts for the
+ * additional threads spawned by libavcodec/libavfilter; a share of one thread
+ * is not taken from the budget. A node's share is allocated by the first call
+ * for it, by dividing what is left of the budget among all the nodes without
+ * a share. Decoders are opened before the graph is complete and so may get
+ * larger shares than nodes opened later, but the sum of all the shares never
+ * exceeds the budget. Later calls for the same node return the same share.
+ *
+ * @param type   SCH_NODE_TYPE_DEC, SCH_NODE_TYPE_ENC or
+ *               SCH_NODE_TYPE_FILTER_IN/OUT
+ * @param idx    index of the node, as returned by sch_add_dec(),
+ *               sch_add_enc() or sch_add_filtergraph()
+ * @param budget total number of threads to be shared among all the nodes;
+ *               when <= 0 there is no limit
+ *
+ * @return thread count for the node (>= 1), or 0 when budget <= 0, meaning
+ *         the caller should use its default (automatic) thread count
+ */
+int sch_thread_share(Scheduler *sch, enum SchedulerNodeType type,
+                     unsigned idx, int budget);
+
 /**
  * Add an encoder to the scheduler.
  *
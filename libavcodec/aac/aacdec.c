@@ -1129,6 +1129,19 @@ static int decode_audio_specific_config(AACDecContext *ac,
                                            sync_extension);
 }
 
+static av_cold void uninit_dsp(AACDecContext *ac)
+{
+    av_tx_uninit(&ac->mdct96);
+    av_tx_uninit(&ac->mdct120);
+    av_tx_uninit(&ac->mdct128);
+    av_tx_uninit(&ac->mdct480);
+    av_tx_uninit(&ac->mdct512);
+    av_tx_uninit(&ac->mdct768);
+    av_tx_uninit(&ac->mdct960);
+    av_tx_uninit(&ac->mdct1024);
+    av_tx_uninit(&ac->mdct_ltp);
+}
+
 static av_cold int decode_close(AVCodecContext *avctx)
 {
     AACDecContext *ac = avctx->priv_data;
@@ -1153,15 +1166,13 @@ static av_cold int decode_close(AVCodecContext *avctx)
         }
     }
 
-    av_tx_uninit(&ac->mdct96);
-    av_tx_uninit(&ac->mdct120);
-    av_tx_uninit(&ac->mdct128);
-    av_tx_uninit(&ac->mdct480);
-    av_tx_uninit(&ac->mdct512);
-    av_tx_uninit(&ac->mdct768);
-    av_tx_uninit(&ac->mdct960);
-    av_tx_uninit(&ac->mdct1024);
-    av_tx_uninit(&ac->mdct_ltp);
+    uninit_dsp(ac);
+    for (int i = 0; i < ac->nb_slice_ctx; i++) {
+        uninit_dsp(ac->slice_ctx[i]);
+        av_free(ac->slice_ctx[i]);
+    }
+    av_freep(&ac->slice_ctx);
+    ac->nb_slice_ctx = 0;
 
     // Compiler will optimize this branch away.
     if (ac->is_fixed)
@@ -1172,9 +1183,8 @@ static av_cold int decode_close(AVCodecContext *avctx)
     return 0;
 }
 
-static av_cold int init_dsp(AVCodecContext *avctx)
+static av_cold int init_dsp(AACDecContext *ac)
 {
-    AACDecContext *ac = avctx->priv_data;
     int is_fixed = ac->is_fixed, ret;
     float scale_fixed, scale_float;
     const float *const scalep = is_fixed ? &scale_fixed : &scale_float;
@@ -1264,7 +1274,7 @@ av_cold int ff_aac_decode_init(AVCodecContext *avctx)
 
     ac->random_state = 0x1f2e3d4c;
 
-    return init_dsp(avctx);
+    return init_dsp(ac);
 }
 
 /**
@@ -2034,72 +2044,172 @@ static void apply_channel_coupling(AACDecContext *ac, ChannelElement *cc,
     }
 }
 
+typedef void (*imdct_and_window_fn)(AACDecContext *ac, SingleChannelElement *sce);
+
+/**
+ * Convert the spectral data of a single channel element to samples.
+ */
+static void spectral_to_sample_che(AACDecContext *ac, ChannelElement *che,
+                                   int type, int elem_id, int samples,
+                                   imdct_and_window_fn imdct_and_window)
+{
+    if (type <= TYPE_CPE)
+        apply_channel_coupling(ac, che, type, elem_id, BEFORE_TNS, ac->dsp.apply_dependent_coupling);
+    if (ac->oc[1].m4ac.object_type == AOT_AAC_LTP) {
+        if (che->ch[0].ics.predictor_present) {
+            if (che->ch[0].ics.ltp.present)
+                ac->dsp.apply_ltp(ac, &che->ch[0]);
+            if (che->ch[1].ics.ltp.present && type == TYPE_CPE)
+                ac->dsp.apply_ltp(ac, &che->ch[1]);
+        }
+    }
+    if (che->ch[0].tns.present)
+        ac->dsp.apply_tns(che->ch[0].coeffs,
+                          &che->ch[0].tns, &che->ch[0].ics, 1);
+    if (che->ch[1].tns.present)
+        ac->dsp.apply_tns(che->ch[1].coeffs,
+                          &che->ch[1].tns, &che->ch[1].ics, 1);
+    if (type <= TYPE_CPE)
+        apply_channel_coupling(ac, che, type, elem_id, BETWEEN_TNS_AND_IMDCT, ac->dsp.apply_dependent_coupling);
+    if (type != TYPE_CCE || che->coup.coupling_point == AFTER_IMDCT) {
+        imdct_and_window(ac, &che->ch[0]);
+        if (ac->oc[1].m4ac.object_type == AOT_AAC_LTP)
+            ac->dsp.update_ltp(ac, &che->ch[0]);
+        if (type == TYPE_CPE) {
+            imdct_and_window(ac, &che->ch[1]);
+            if (ac->oc[1].m4ac.object_type == AOT_AAC_LTP)
+                ac->dsp.update_ltp(ac, &che->ch[1]);
+        }
+        if (ac->oc[1].m4ac.sbr > 0) {
+            ac->proc.sbr_apply(ac, che, type,
+                               che->ch[0].output,
+                               che->ch[1].output);
+        }
+    }
+    if (type <= TYPE_CCE)
+        apply_channel_coupling(ac, che, type, elem_id, AFTER_IMDCT, ac->dsp.apply_independent_coupling);
+    ac->dsp.clip_output(ac, che, type, samples);
+    che->present = 0;
+}
+
+typedef struct SpectralToSampleJobs {
+    AACDecContext *ac;
+    imdct_and_window_fn imdct_and_window;
+    int samples;
+    int nb_elems;
+    uint8_t elems[4 * MAX_ELEM_ID][2]; ///< type and id of each present element
+} SpectralToSampleJobs;
+
+static int spectral_to_sample_job(AVCodecContext *avctx, void *arg,
+                                  int jobnr, int threadnr)
+{
+    const SpectralToSampleJobs *jobs = arg;
+    AACDecContext *ac = jobs->ac;
+    const int type    = jobs->elems[jobnr][0];
+    const int elem_id = jobs->elems[jobnr][1];
+
+    /* Every job needs its own transforms and scratch buffers */
+    spectral_to_sample_che(jobnr ? ac->slice_ctx[jobnr - 1] : ac,
+                           ac->che[type][elem_id], type, elem_id,
+                           jobs->samples, jobs->imdct_and_window);
+    return 0;
+}
+
+/**
+ * Make sure there are enough per-job contexts to process nb_jobs channel
+ * elements concurrently. Only the parts used by spectral_to_sample_che()
+ * are set up.
+ */
+static int alloc_slice_contexts(AACDecContext *ac, int nb_jobs)
+{
+    AACDecContext **tmp;
+    int ret;
+
+    if (nb_jobs - 1 <= ac->nb_slice_ctx)
+        return 0;
+
+    tmp = av_realloc_array(ac->slice_ctx, nb_jobs - 1, sizeof(*tmp));
+    if (!tmp)
+        return AVERROR(ENOMEM);
+    ac->slice_ctx = tmp;
+
+    while (ac->nb_slice_ctx < nb_jobs - 1) {
+        AACDecContext *s = av_mallocz(sizeof(*s));
+        if (!s)
+            return AVERROR(ENOMEM);
+        s->avctx    = ac->avctx;
+        s->dsp      = ac->dsp;
+        s->proc     = ac->proc;
+        s->is_fixed = ac->is_fixed;
+        if (ac->is_fixed)
+            s->RENAME_FIXED(fdsp) = ac->RENAME_FIXED(fdsp);
+        else
+            s->fdsp = ac->fdsp;
+
+        ret = init_dsp(s);
+        if (ret < 0) {
+            uninit_dsp(s);
+            av_free(s);
+            return ret;
+        }
+        ac->slice_ctx[ac->nb_slice_ctx++] = s;
+    }
+
+    return 0;
+}
+
 /**
  * Convert spectral data to samples, applying all supported tools as appropriate.
  */
 static void spectral_to_sample(AACDecContext *ac, int samples)
 {
-    int i, type;
-    void (*imdct_and_window)(AACDecContext *ac, SingleChannelElement *sce);
+    SpectralToSampleJobs jobs = { .ac = ac, .samples = samples };
+    int i, type, has_cce = 0;
+
     switch (ac->oc[1].m4ac.object_type) {
     case AOT_ER_AAC_LD:
-        imdct_and_window = ac->dsp.imdct_and_windowing_ld;
+        jobs.imdct_and_window = ac->dsp.imdct_and_windowing_ld;
         break;
     case AOT_ER_AAC_ELD:
-        imdct_and_window = ac->dsp.imdct_and_windowing_eld;
+        jobs.imdct_and_window = ac->dsp.imdct_and_windowing_eld;
         break;
     default:
         if (ac->oc[1].m4ac.frame_length_short)
-            imdct_and_window = ac->dsp.imdct_and_windowing_960;
+            jobs.imdct_and_window = ac->dsp.imdct_and_windowing_960;
         else
-            imdct_and_window = ac->dsp.imdct_and_windowing;
+            jobs.imdct_and_window = ac->dsp.imdct_and_windowing;
     }
     for (type = 3; type >= 0; type--) {
         for (i = 0; i < MAX_ELEM_ID; i++) {
             ChannelElement *che = ac->che[type][i];
+            if (che && type == TYPE_CCE)
+                has_cce = 1;
             if (che && che->present) {
-                if (type <= TYPE_CPE)
-                    apply_channel_coupling(ac, che, type, i, BEFORE_TNS, ac->dsp.apply_dependent_coupling);
-                if (ac->oc[1].m4ac.object_type == AOT_AAC_LTP) {
-                    if (che->ch[0].ics.predictor_present) {
-                        if (che->ch[0].ics.ltp.present)
-                            ac->dsp.apply_ltp(ac, &che->ch[0]);
-                        if (che->ch[1].ics.ltp.present && type == TYPE_CPE)
-                            ac->dsp.apply_ltp(ac, &che->ch[1]);
-                    }
-                }
-                if (che->ch[0].tns.present)
-                    ac->dsp.apply_tns(che->ch[0].coeffs,
-                                      &che->ch[0].tns, &che->ch[0].ics, 1);
-                if (che->ch[1].tns.present)
-                    ac->dsp.apply_tns(che->ch[1].coeffs,
-                                      &che->ch[1].tns, &che->ch[1].ics, 1);
-                if (type <= TYPE_CPE)
-                    apply_channel_coupling(ac, che, type, i, BETWEEN_TNS_AND_IMDCT, ac->dsp.apply_dependent_coupling);
-                if (type != TYPE_CCE || che->coup.coupling_point == AFTER_IMDCT) {
-                    imdct_and_window(ac, &che->ch[0]);
-                    if (ac->oc[1].m4ac.object_type == AOT_AAC_LTP)
-                        ac->dsp.update_ltp(ac, &che->ch[0]);
-                    if (type == TYPE_CPE) {
-                        imdct_and_window(ac, &che->ch[1]);
-                        if (ac->oc[1].m4ac.object_type == AOT_AAC_LTP)
-                            ac->dsp.update_ltp(ac, &che->ch[1]);
-                    }
-                    if (ac->oc[1].m4ac.sbr > 0) {
-                        ac->proc.sbr_apply(ac, che, type,
-                                           che->ch[0].output,
-                                           che->ch[1].output);
-                    }
-                }
-                if (type <= TYPE_CCE)
-                    apply_channel_coupling(ac, che, type, i, AFTER_IMDCT, ac->dsp.apply_independent_coupling);
-                ac->dsp.clip_output(ac, che, type, samples);
-                che->present = 0;
+                jobs.elems[jobs.nb_elems][0] = type;
+                jobs.elems[jobs.nb_elems][1] = i;
+                jobs.nb_elems++;
             } else if (che) {
                 av_log(ac->avctx, AV_LOG_VERBOSE, "ChannelElement %d.%d missing \n", type, i);
             }
         }
     }
+
+    /* Without coupling channels, all elements are independent of each other
+     * and can be processed concurrently */
+    if (ac->avctx->active_thread_type & FF_THREAD_SLICE && !has_cce &&
+        jobs.nb_elems > 1 && alloc_slice_contexts(ac, jobs.nb_elems) >= 0) {
+        for (i = 0; i < jobs.nb_elems - 1; i++)
+            ac->slice_ctx[i]->oc[1].m4ac = ac->oc[1].m4ac;
+        ac->avctx->execute2(ac->avctx, spectral_to_sample_job, &jobs,
+                            NULL, jobs.nb_elems);
+        return;
+    }
+
+    for (i = 0; i < jobs.nb_elems; i++) {
+        type = jobs.elems[i][0];
+        spectral_to_sample_che(ac, ac->che[type][jobs.elems[i][1]], type,
+                               jobs.elems[i][1], samples, jobs.imdct_and_window);
+    }
 }
 
 static int parse_adts_frame_header(AACDecContext *ac, GetBitContext *gb)
@@ -2580,7 +2690,8 @@ const FFCodec ff_aac_decoder = {
     .close           = decode_close,
     FF_CODEC_DECODE_CB(aac_decode_frame),
     CODEC_SAMPLEFMTS(AV_SAMPLE_FMT_FLTP),
-    .p.capabilities  = AV_CODEC_CAP_CHANNEL_CONF | AV_CODEC_CAP_DR1,
+    .p.capabilities  = AV_CODEC_CAP_CHANNEL_CONF | AV_CODEC_CAP_DR1 |
+                       AV_CODEC_CAP_SLICE_THREADS,
     .caps_internal   = FF_CODEC_CAP_INIT_CLEANUP,
     CODEC_CH_LAYOUTS_ARRAY(ff_aac_ch_layout),
     .flush = flush,
@@ -2600,7 +2711,8 @@ const FFCodec ff_aac_fixed_decoder = {
     .close           = decode_close,
     FF_CODEC_DECODE_CB(aac_decode_frame),
     CODEC_SAMPLEFMTS(AV_SAMPLE_FMT_S32P),
-    .p.capabilities  = AV_CODEC_CAP_CHANNEL_CONF | AV_CODEC_CAP_DR1,
+    .p.capabilities  = AV_CODEC_CAP_CHANNEL_CONF | AV_CODEC_CAP_DR1 |
+                       AV_CODEC_CAP_SLICE_THREADS,
     .caps_internal   = FF_CODEC_CAP_INIT_CLEANUP,
     CODEC_CH_LAYOUTS_ARRAY(ff_aac_ch_layout),
     .p.profiles      = NULL_IF_CONFIG_SMALL(ff_aac_profiles),
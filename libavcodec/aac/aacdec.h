@@ -563,6 +563,14 @@ struct AACDecContext {
     int warned_he_aac_mono;
 
     int is_fixed;
+
+    /**
+     * Contexts used by the additional jobs when decoding the channel
+     * elements of a frame with slice threading. Only the transforms,
+     * scratch buffers and MPEG4AudioConfig of these are used.
+     */
+    struct AACDecContext **slice_ctx;
+    int nb_slice_ctx;
 };
 
 #if defined(USE_FIXED) && USE_FIXED
@@ -340,7 +340,8 @@ const FFCodec ff_aac_latm_decoder = {
     .close           = decode_close,
     FF_CODEC_DECODE_CB(latm_decode_frame),
     CODEC_SAMPLEFMTS(AV_SAMPLE_FMT_FLTP),
-    .p.capabilities  = AV_CODEC_CAP_CHANNEL_CONF | AV_CODEC_CAP_DR1,
+    .p.capabilities  = AV_CODEC_CAP_CHANNEL_CONF | AV_CODEC_CAP_DR1 |
+                       AV_CODEC_CAP_SLICE_THREADS,
     .caps_internal   = FF_CODEC_CAP_INIT_CLEANUP,
     CODEC_CH_LAYOUTS_ARRAY(ff_aac_ch_layout),
     .flush = flush,
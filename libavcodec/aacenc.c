@@ -821,19 +821,183 @@ static void copy_input_samples(AACEncContext *s, const AVFrame *frame)
     }
 }
 
+/**
+ * Decide the window sequence of a channel element, evaluate its clipping
+ * risk and transform it.
+ */
+static int window_and_mdct_element(AVCodecContext *avctx, AACEncContext *s,
+                                   int elem, int start_ch, FFPsyWindowInfo *wi,
+                                   int have_la)
+{
+    float **samples = s->planar_samples, *samples2, *la, *overlap;
+    const int tag   = s->chan_map[elem + 1];
+    const int chans = tag == TYPE_CPE ? 2 : 1;
+    ChannelElement *cpe = &s->cpe[elem];
+    SingleChannelElement *sce;
+    IndividualChannelStream *ics;
+    int ch, w;
+
+    for (ch = 0; ch < chans; ch++) {
+        int k;
+        float clip_avoidance_factor;
+        sce = &cpe->ch[ch];
+        ics = &sce->ics;
+        s->cur_channel = start_ch + ch;
+        overlap  = &samples[s->cur_channel][0];
+        samples2 = overlap + 1024;
+        la       = samples2 + (448+64);
+        if (!have_la)
+            la = NULL;
+        if (tag == TYPE_LFE) {
+            wi[ch].window_type[0] = wi[ch].window_type[1] = ONLY_LONG_SEQUENCE;
+            wi[ch].window_shape   = 0;
+            wi[ch].num_windows    = 1;
+            wi[ch].grouping[0]    = 1;
+            wi[ch].clipping[0]    = 0;
+
+            /* Only the lowest 12 coefficients are used in a LFE channel.
+             * The expression below results in only the bottom 8 coefficients
+             * being used for 11.025kHz to 16kHz sample rates.
+             */
+            ics->num_swb = s->samplerate_index >= 8 ? 1 : 3;
+        } else {
+            wi[ch] = s->psy.model->window(&s->psy, samples2, la, s->cur_channel,
+                                          ics->window_sequence[0]);
+        }
+        ics->window_sequence[1] = ics->window_sequence[0];
+        ics->window_sequence[0] = wi[ch].window_type[0];
+        ics->use_kb_window[1]   = ics->use_kb_window[0];
+        ics->use_kb_window[0]   = wi[ch].window_shape;
+        ics->num_windows        = wi[ch].num_windows;
+        ics->swb_sizes          = s->psy.bands    [ics->num_windows == 8];
+        ics->num_swb            = tag == TYPE_LFE ? ics->num_swb : s->psy.num_bands[ics->num_windows == 8];
+        ics->max_sfb            = FFMIN(ics->max_sfb, ics->num_swb);
+        ics->swb_offset         = wi[ch].window_type[0] == EIGHT_SHORT_SEQUENCE ?
+                                    ff_swb_offset_128 [s->samplerate_index]:
+                                    ff_swb_offset_1024[s->samplerate_index];
+        ics->tns_max_bands      = wi[ch].window_type[0] == EIGHT_SHORT_SEQUENCE ?
+                                    ff_tns_max_bands_128 [s->samplerate_index]:
+                                    ff_tns_max_bands_1024[s->samplerate_index];
+
+        for (w = 0; w < ics->num_windows; w++)
+            ics->group_len[w] = wi[ch].grouping[w];
+
+        /* Calculate input sample maximums and evaluate clipping risk */
+        clip_avoidance_factor = 0.0f;
+        for (w = 0; w < ics->num_windows; w++) {
+            const float *wbuf = overlap + w * 128;
+            const int wlen = 2048 / ics->num_windows;
+            float max = 0;
+            int j;
+            /* mdct input is 2 * output */
+            for (j = 0; j < wlen; j++)
+                max = FFMAX(max, fabsf(wbuf[j]));
+            wi[ch].clipping[w] = max;
+        }
+        for (w = 0; w < ics->num_windows; w++) {
+            if (wi[ch].clipping[w] > CLIP_AVOIDANCE_FACTOR) {
+                ics->window_clipping[w] = 1;
+                clip_avoidance_factor = FFMAX(clip_avoidance_factor, wi[ch].clipping[w]);
+            } else {
+                ics->window_clipping[w] = 0;
+            }
+        }
+        if (clip_avoidance_factor > CLIP_AVOIDANCE_FACTOR) {
+            ics->clip_avoidance_factor = CLIP_AVOIDANCE_FACTOR / clip_avoidance_factor;
+        } else {
+            ics->clip_avoidance_factor = 1.0f;
+        }
+
+        apply_window_and_mdct(s, sce, overlap);
+
+        for (k = 0; k < 1024; k++) {
+            if (!(fabs(cpe->ch[ch].coeffs[k]) < 1E16)) { // Ensure headroom for energy calculation
+                av_log(avctx, AV_LOG_ERROR, "Input contains (near) NaN/+-Inf\n");
+                return AVERROR(EINVAL);
+            }
+        }
+        avoid_clipping(s, sce);
+    }
+    return 0;
+}
+
+/**
+ * Search the quantizers of all channels of a channel element.
+ * psy.bitres.alloc must hold the per-channel allocation of the element.
+ */
+static void search_element(AVCodecContext *avctx, AACEncContext *s,
+                           int elem, int start_ch)
+{
+    ChannelElement *cpe = &s->cpe[elem];
+    const int chans = s->chan_map[elem + 1] == TYPE_CPE ? 2 : 1;
+
+    s->cur_type = s->chan_map[elem + 1];
+    for (int ch = 0; ch < chans; ch++) {
+        s->cur_channel = start_ch + ch;
+        if (s->options.pns && s->coder->mark_pns)
+            s->coder->mark_pns(s, avctx, &cpe->ch[ch]);
+        s->coder->search_for_quantizers(avctx, s, &cpe->ch[ch], s->lambda);
+    }
+}
+
+typedef struct AACEncElementJobs {
+    AACEncContext *s;
+    FFPsyWindowInfo *windows;
+    int have_la;
+    int first_elem;                              ///< first element to search
+    int cutoff;                                  ///< psy cutoff after the last element
+    int start_ch[AAC_MAX_CHANNELS];              ///< first channel of each element
+    int bitres_alloc[AAC_MAX_CHANNELS];          ///< per-channel psy allocation of each element
+} AACEncElementJobs;
+
+static AACEncContext *job_context(const AACEncElementJobs *jobs, int threadnr)
+{
+    av_assert1(threadnr <= jobs->s->nb_slice_ctx);
+    return threadnr ? jobs->s->slice_ctx[threadnr - 1] : jobs->s;
+}
+
+static int window_and_mdct_job(AVCodecContext *avctx, void *arg,
+                               int jobnr, int threadnr)
+{
+    const AACEncElementJobs *jobs = arg;
+
+    return window_and_mdct_element(avctx, job_context(jobs, threadnr), jobnr,
+                                   jobs->start_ch[jobnr],
+                                   jobs->windows + jobs->start_ch[jobnr],
+                                   jobs->have_la);
+}
+
+static int search_element_job(AVCodecContext *avctx, void *arg,
+                              int jobnr, int threadnr)
+{
+    AACEncElementJobs *jobs = arg;
+    AACEncContext *s = job_context(jobs, threadnr);
+    const int elem = jobs->first_elem + jobnr;
+
+    s->psy.bitres.alloc = jobs->bitres_alloc[elem];
+    search_element(avctx, s, elem, jobs->start_ch[elem]);
+    if (elem == jobs->s->chan_map[0] - 1)
+        jobs->cutoff = s->psy.cutoff;
+    return 0;
+}
+
 static int aac_encode_frame(AVCodecContext *avctx, AVPacket *avpkt,
                             const AVFrame *frame, int *got_packet_ptr)
 {
     AACEncContext *s = avctx->priv_data;
-    float **samples = s->planar_samples, *samples2, *la, *overlap;
     ChannelElement *cpe;
     SingleChannelElement *sce;
-    IndividualChannelStream *ics;
     int i, its, ch, w, chans, tag, start_ch, ret, frame_bits;
     int target_bits, rate_bits, too_many_bits, too_few_bits;
     int ms_mode = 0, is_mode = 0, tns_mode = 0, pred_mode = 0;
     int chan_el_counter[4];
+    int job_ret[AAC_MAX_CHANNELS];
     FFPsyWindowInfo windows[AAC_MAX_CHANNELS];
+    AACEncElementJobs jobs = { .s = s, .windows = windows, .have_la = !!frame };
+    /* Channel elements are independent of each other until they get
+     * written out, so window decision, MDCT and quantizer search can be
+     * run concurrently if there are contexts to do so */
+    const int threaded = s->nb_slice_ctx > 0;
 
     /* add current frame to queue */
     if (frame) {
@@ -851,92 +1015,22 @@ static int aac_encode_frame(AVCodecContext *avctx, AVPacket *avpkt,
 
     start_ch = 0;
     for (i = 0; i < s->chan_map[0]; i++) {
-        FFPsyWindowInfo* wi = windows + start_ch;
-        tag      = s->chan_map[i+1];
-        chans    = tag == TYPE_CPE ? 2 : 1;
-        cpe      = &s->cpe[i];
-        for (ch = 0; ch < chans; ch++) {
-            int k;
-            float clip_avoidance_factor;
-            sce = &cpe->ch[ch];
-            ics = &sce->ics;
-            s->cur_channel = start_ch + ch;
-            overlap  = &samples[s->cur_channel][0];
-            samples2 = overlap + 1024;
-            la       = samples2 + (448+64);
-            if (!frame)
-                la = NULL;
-            if (tag == TYPE_LFE) {
-                wi[ch].window_type[0] = wi[ch].window_type[1] = ONLY_LONG_SEQUENCE;
-                wi[ch].window_shape   = 0;
-                wi[ch].num_windows    = 1;
-                wi[ch].grouping[0]    = 1;
-                wi[ch].clipping[0]    = 0;
-
-                /* Only the lowest 12 coefficients are used in a LFE channel.
-                 * The expression below results in only the bottom 8 coefficients
-                 * being used for 11.025kHz to 16kHz sample rates.
-                 */
-                ics->num_swb = s->samplerate_index >= 8 ? 1 : 3;
-            } else {
-                wi[ch] = s->psy.model->window(&s->psy, samples2, la, s->cur_channel,
-                                              ics->window_sequence[0]);
-            }
-            ics->window_sequence[1] = ics->window_sequence[0];
-            ics->window_sequence[0] = wi[ch].window_type[0];
-            ics->use_kb_window[1]   = ics->use_kb_window[0];
-            ics->use_kb_window[0]   = wi[ch].window_shape;
-            ics->num_windows        = wi[ch].num_windows;
-            ics->swb_sizes          = s->psy.bands    [ics->num_windows == 8];
-            ics->num_swb            = tag == TYPE_LFE ? ics->num_swb : s->psy.num_bands[ics->num_windows == 8];
-            ics->max_sfb            = FFMIN(ics->max_sfb, ics->num_swb);
-            ics->swb_offset         = wi[ch].window_type[0] == EIGHT_SHORT_SEQUENCE ?
-                                        ff_swb_offset_128 [s->samplerate_index]:
-                                        ff_swb_offset_1024[s->samplerate_index];
-            ics->tns_max_bands      = wi[ch].window_type[0] == EIGHT_SHORT_SEQUENCE ?
-                                        ff_tns_max_bands_128 [s->samplerate_index]:
-                                        ff_tns_max_bands_1024[s->samplerate_index];
-
-            for (w = 0; w < ics->num_windows; w++)
-                ics->group_len[w] = wi[ch].grouping[w];
-
-            /* Calculate input sample maximums and evaluate clipping risk */
-            clip_avoidance_factor = 0.0f;
-            for (w = 0; w < ics->num_windows; w++) {
-                const float *wbuf = overlap + w * 128;
-                const int wlen = 2048 / ics->num_windows;
-                float max = 0;
-                int j;
-                /* mdct input is 2 * output */
-                for (j = 0; j < wlen; j++)
-                    max = FFMAX(max, fabsf(wbuf[j]));
-                wi[ch].clipping[w] = max;
-            }
-            for (w = 0; w < ics->num_windows; w++) {
-                if (wi[ch].clipping[w] > CLIP_AVOIDANCE_FACTOR) {
-                    ics->window_clipping[w] = 1;
-                    clip_avoidance_factor = FFMAX(clip_avoidance_factor, wi[ch].clipping[w]);
-                } else {
-                    ics->window_clipping[w] = 0;
-                }
-            }
-            if (clip_avoidance_factor > CLIP_AVOIDANCE_FACTOR) {
-                ics->clip_avoidance_factor = CLIP_AVOIDANCE_FACTOR / clip_avoidance_factor;
-            } else {
-                ics->clip_avoidance_factor = 1.0f;
-            }
-
-            apply_window_and_mdct(s, sce, overlap);
+        jobs.start_ch[i] = start_ch;
+        start_ch += s->chan_map[i+1] == TYPE_CPE ? 2 : 1;
+    }
 
-            for (k = 0; k < 1024; k++) {
-                if (!(fabs(cpe->ch[ch].coeffs[k]) < 1E16)) { // Ensure headroom for energy calculation
-                    av_log(avctx, AV_LOG_ERROR, "Input contains (near) NaN/+-Inf\n");
-                    return AVERROR(EINVAL);
-                }
-            }
-            avoid_clipping(s, sce);
+    if (threaded) {
+        avctx->execute2(avctx, window_and_mdct_job, &jobs, job_ret, s->chan_map[0]);
+        for (i = 0; i < s->chan_map[0]; i++)
+            if (job_ret[i] < 0)
+                return job_ret[i];
+    } else {
+        for (i = 0; i < s->chan_map[0]; i++) {
+            ret = window_and_mdct_element(avctx, s, i, jobs.start_ch[i],
+                                          windows + jobs.start_ch[i], !!frame);
+            if (ret < 0)
+                return ret;
         }
-        start_ch += chans;
     }
     if ((ret = ff_alloc_packet(avctx, avpkt, 8192 * s->channels)) < 0)
         return ret;
@@ -946,20 +1040,21 @@ static int aac_encode_frame(AVCodecContext *avctx, AVPacket *avpkt,
 
         if ((avctx->frame_num & 0xFF)==1 && !(avctx->flags & AV_CODEC_FLAG_BITEXACT))
             put_bitstream_info(s, LIBAVCODEC_IDENT);
-        start_ch = 0;
         target_bits = 0;
         memset(chan_el_counter, 0, sizeof(chan_el_counter));
+        /* The very first quantizer search settles the psy cutoff, which the
+         * analysis of the following elements depends on */
+        jobs.first_elem = avctx->frame_num == 1 && !its;
         for (i = 0; i < s->chan_map[0]; i++) {
-            FFPsyWindowInfo* wi = windows + start_ch;
+            FFPsyWindowInfo* wi = windows + jobs.start_ch[i];
             const float *coeffs[2];
+            start_ch = jobs.start_ch[i];
             tag      = s->chan_map[i+1];
             chans    = tag == TYPE_CPE ? 2 : 1;
             cpe      = &s->cpe[i];
             cpe->common_window = 0;
             memset(cpe->is_mask, 0, sizeof(cpe->is_mask));
             memset(cpe->ms_mask, 0, sizeof(cpe->ms_mask));
-            put_bits(&s->pb, 3, tag);
-            put_bits(&s->pb, 4, chan_el_counter[tag]++);
             for (ch = 0; ch < chans; ch++) {
                 sce = &cpe->ch[ch];
                 coeffs[ch] = sce->coeffs;
@@ -977,13 +1072,29 @@ static int aac_encode_frame(AVCodecContext *avctx, AVPacket *avpkt,
                     * (s->lambda / (avctx->global_quality ? avctx->global_quality : 120));
                 s->psy.bitres.alloc /= chans;
             }
+            jobs.bitres_alloc[i] = s->psy.bitres.alloc;
+            if (!threaded || (!i && jobs.first_elem))
+                search_element(avctx, s, i, start_ch);
+        }
+        if (threaded) {
+            /* The psy model keeps a bit reservoir across elements, so only
+             * the quantizer search is done in parallel */
+            for (i = 0; i < s->nb_slice_ctx; i++)
+                s->slice_ctx[i]->lambda = s->lambda;
+            jobs.cutoff = s->psy.cutoff;
+            avctx->execute2(avctx, search_element_job, &jobs, NULL,
+                            s->chan_map[0] - jobs.first_elem);
+            s->psy.cutoff = jobs.cutoff;
+        }
+        for (i = 0; i < s->chan_map[0]; i++) {
+            FFPsyWindowInfo* wi = windows + jobs.start_ch[i];
+            start_ch = jobs.start_ch[i];
+            tag      = s->chan_map[i+1];
+            chans    = tag == TYPE_CPE ? 2 : 1;
+            cpe      = &s->cpe[i];
+            put_bits(&s->pb, 3, tag);
+            put_bits(&s->pb, 4, chan_el_counter[tag]++);
             s->cur_type = tag;
-            for (ch = 0; ch < chans; ch++) {
-                s->cur_channel = start_ch + ch;
-                if (s->options.pns && s->coder->mark_pns)
-                    s->coder->mark_pns(s, avctx, &cpe->ch[ch]);
-                s->coder->search_for_quantizers(avctx, s, &cpe->ch[ch], s->lambda);
-            }
             if (chans > 1
                 && wi[0].window_type[0] == wi[1].window_type[0]
                 && wi[0].window_shape   == wi[1].window_shape) {
@@ -1035,7 +1146,6 @@ static int aac_encode_frame(AVCodecContext *avctx, AVPacket *avpkt,
                 s->cur_channel = start_ch + ch;
                 encode_individual_channel(avctx, s, &cpe->ch[ch], cpe->common_window);
             }
-            start_ch += chans;
         }
 
         if (avctx->flags & AV_CODEC_FLAG_QSCALE) {
@@ -1129,19 +1239,31 @@ static int aac_encode_frame(AVCodecContext *avctx, AVPacket *avpkt,
     return 0;
 }
 
+static av_cold void dsp_uninit(AACEncContext *s)
+{
+    av_tx_uninit(&s->mdct1024);
+    av_tx_uninit(&s->mdct128);
+    av_freep(&s->fdsp);
+}
+
 static av_cold int aac_encode_end(AVCodecContext *avctx)
 {
     AACEncContext *s = avctx->priv_data;
 
     av_log(avctx, AV_LOG_INFO, "Qavg: %.3f\n", s->lambda_count ? s->lambda_sum / s->lambda_count : NAN);
 
-    av_tx_uninit(&s->mdct1024);
-    av_tx_uninit(&s->mdct128);
+    for (int i = 0; i < s->nb_slice_ctx; i++) {
+        dsp_uninit(s->slice_ctx[i]);
+        av_free(s->slice_ctx[i]);
+    }
+    av_freep(&s->slice_ctx);
+    s->nb_slice_ctx = 0;
+
+    dsp_uninit(s);
     ff_psy_end(&s->psy);
     ff_lpc_end(&s->lpc);
     av_freep(&s->buffer.samples);
     av_freep(&s->cpe);
-    av_freep(&s->fdsp);
     ff_af_queue_close(&s->afq);
     return 0;
 }
@@ -1178,6 +1300,51 @@ static av_cold int alloc_buffers(AVCodecContext *avctx, AACEncContext *s)
     return 0;
 }
 
+/**
+ * Set up one context per additional slice thread, used to process channel
+ * elements concurrently. Only the parts touched by window_and_mdct_element()
+ * and search_element() are initialized; the psy model and the channel
+ * elements are shared with the main context.
+ */
+static av_cold int alloc_slice_contexts(AVCodecContext *avctx, AACEncContext *s)
+{
+    int ret;
+
+    if (!(avctx->active_thread_type & FF_THREAD_SLICE) ||
+        avctx->thread_count <= 1 || s->chan_map[0] <= 1)
+        return 0;
+
+    s->slice_ctx = av_calloc(avctx->thread_count - 1, sizeof(*s->slice_ctx));
+    if (!s->slice_ctx)
+        return AVERROR(ENOMEM);
+
+    while (s->nb_slice_ctx < avctx->thread_count - 1) {
+        AACEncContext *c = av_mallocz(sizeof(*c));
+        if (!c)
+            return AVERROR(ENOMEM);
+        s->slice_ctx[s->nb_slice_ctx++] = c;
+
+        c->av_class         = s->av_class;
+        c->options          = s->options;
+        c->profile          = s->profile;
+        c->samplerate_index = s->samplerate_index;
+        c->channels         = s->channels;
+        c->reorder_map      = s->reorder_map;
+        c->chan_map         = s->chan_map;
+        c->cpe              = s->cpe;
+        c->psy              = s->psy;
+        c->coder            = s->coder;
+        c->lambda           = s->lambda;
+        c->aacdsp           = s->aacdsp;
+        memcpy(c->planar_samples, s->planar_samples, sizeof(c->planar_samples));
+
+        if ((ret = dsp_init(avctx, c)) < 0)
+            return ret;
+    }
+
+    return 0;
+}
+
 static av_cold int aac_encode_init(AVCodecContext *avctx)
 {
     AACEncContext *s = avctx->priv_data;
@@ -1295,6 +1462,9 @@ static av_cold int aac_encode_init(AVCodecContext *avctx)
 
     ff_aacenc_dsp_init(&s->aacdsp);
 
+    if ((ret = alloc_slice_contexts(avctx, s)) < 0)
+        return ret;
+
     ff_af_queue_init(avctx, &s->afq);
 
     return 0;
@@ -1332,7 +1502,7 @@ const FFCodec ff_aac_encoder = {
     .p.type         = AVMEDIA_TYPE_AUDIO,
     .p.id           = AV_CODEC_ID_AAC,
     .p.capabilities = AV_CODEC_CAP_DR1 | AV_CODEC_CAP_DELAY |
-                      AV_CODEC_CAP_SMALL_LAST_FRAME,
+                      AV_CODEC_CAP_SMALL_LAST_FRAME | AV_CODEC_CAP_SLICE_THREADS,
     .priv_data_size = sizeof(AACEncContext),
     .init           = aac_encode_init,
     FF_CODEC_ENCODE_CB(aac_encode_frame),
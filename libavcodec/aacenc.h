@@ -220,6 +220,13 @@ typedef struct AACEncContext {
     struct {
         float *samples;
     } buffer;
+
+    /**
+     * Contexts used by the additional slice threads to process channel
+     * elements concurrently, one per thread beyond the first.
+     */
+    struct AACEncContext **slice_ctx;
+    int nb_slice_ctx;
 } AACEncContext;
 
 void ff_quantize_band_cost_cache_init(struct AACEncContext *s);
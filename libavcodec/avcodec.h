@@ -1583,9 +1583,19 @@ typedef struct AVCodecContext {
     int thread_type;
 #define FF_THREAD_FRAME   1 ///< Decode more than one frame at once
 #define FF_THREAD_SLICE   2 ///< Decode more than one part of a single frame at once
+/**
+ * Combined with FF_THREAD_FRAME and FF_THREAD_SLICE, let decoders supporting
+ * it additionally split each frame being decoded into slice jobs, which run
+ * on a pool with one thread per additional CPU core shared by all frame
+ * threads. thread_count keeps setting the number of frame threads.
+ * Not enabled by default.
+ */
+#define FF_THREAD_HYBRID  4
 
     /**
-     * Which multithreading methods are in use by the codec.
+     * Which multithreading methods are in use by the codec. Both
+     * FF_THREAD_FRAME and FF_THREAD_SLICE are set if FF_THREAD_HYBRID
+     * is in use.
      * - encoding: Set by libavcodec.
      * - decoding: Set by libavcodec.
      */
@@ -87,6 +87,11 @@
  * encoders do.
  */
 #define FF_CODEC_CAP_EOF_FLUSH              (1 << 10)
+/**
+ * The decoder supports slice threading within each frame thread, i.e. both
+ * FF_THREAD_FRAME and FF_THREAD_SLICE being set in active_thread_type.
+ */
+#define FF_CODEC_CAP_FRAME_SLICE_THREADS    (1 << 11)
 
 /**
  * FFCodec.codec_tags termination value
@@ -177,6 +182,15 @@ typedef struct FFCodec {
      * Copy variables back to the user-facing context
      */
     int (*update_thread_context_for_user)(struct AVCodecContext *dst, const struct AVCodecContext *src);
+
+    /**
+     * Frame-threaded encoders only: called on the user-facing context for
+     * every packet in output order, together with the frame it was encoded
+     * from, to maintain stream-wide state (checksums, statistics) that the
+     * worker contexts each only see a part of.
+     */
+    int (*merge_thread_packet)(struct AVCodecContext *avctx, const struct AVPacket *pkt,
+                               const struct AVFrame *frame);
     /** @} */
 
     /**
@@ -337,11 +351,15 @@ int ff_default_get_supported_config(const struct AVCodecContext *avctx,
         .update_thread_context          = (func)
 #define UPDATE_THREAD_CONTEXT_FOR_USER(func) \
         .update_thread_context_for_user = (func)
+#define MERGE_THREAD_PACKET(func) \
+        .merge_thread_packet            = (func)
 #else
 #define UPDATE_THREAD_CONTEXT(func) \
         .update_thread_context          = NULL
 #define UPDATE_THREAD_CONTEXT_FOR_USER(func) \
         .update_thread_context_for_user = NULL
+#define MERGE_THREAD_PACKET(func) \
+        .merge_thread_packet            = NULL
 #endif
 
 #define FF_CODEC_DECODE_CB(func)                          \
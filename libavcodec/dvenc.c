@@ -1145,7 +1145,9 @@ static inline int dv_write_ssyb_id(uint8_t syb_num, uint8_t fr, uint8_t *buf)
 static void dv_format_frame(DVEncContext *c, uint8_t *buf)
 {
     int chan, i, j, k;
-    /* We work with 720p frames split in half. The odd half-frame is chan 2,3 */
+    /* We work with 720p frames split in half. The odd half-frame is chan 2,3.
+     * With frame threading, frame_num is the index of the frame being encoded
+     * in the worker context too, so the output matches a single thread. */
     int chan_offset = 2*(c->sys->height == 720 && c->avctx->frame_num & 1);
 
     for (chan = 0; chan < c->sys->n_difchan; chan++) {
@@ -66,6 +66,9 @@ struct FFExecutor {
     int die;
 
     Queue *q;
+
+    // see ff_executor_rotate_priorities()
+    int ring_first, ring_size, ring_base;
 };
 
 static FFTask* remove_task(Queue *q)
@@ -89,13 +92,20 @@ static void add_task(Queue *q, FFTask *t)
         q->tail = q->tail->next = t;
 }
 
+static Queue *priority_queue(FFExecutor *e, int i)
+{
+    if (i >= e->ring_first && i < e->ring_first + e->ring_size)
+        i = e->ring_first + (i - e->ring_first + e->ring_base) % e->ring_size;
+    return e->q + i;
+}
+
 static int run_one_task(FFExecutor *e, void *lc)
 {
     FFTaskCallbacks *cb = &e->cb;
     FFTask *t = NULL;
 
     for (int i = 0; i < e->cb.priorities && !t; i++)
-        t = remove_task(e->q + i);
+        t = remove_task(priority_queue(e, i));
 
     if (t) {
         if (e->thread_count > 0)
@@ -231,3 +241,14 @@ void ff_executor_execute(FFExecutor *e, FFTask *t)
         e->recursive = false;
     }
 }
+
+void ff_executor_rotate_priorities(FFExecutor *e, int first, int nb, int base)
+{
+    if (e->thread_count)
+        ff_mutex_lock(&e->lock);
+    e->ring_first = first;
+    e->ring_size  = nb;
+    e->ring_base  = nb ? base % nb : 0;
+    if (e->thread_count)
+        ff_mutex_unlock(&e->lock);
+}
@@ -68,4 +68,13 @@ void ff_executor_free(FFExecutor **e);
  */
 void ff_executor_execute(FFExecutor *e, FFTask *t);
 
+/**
+ * Serve the priorities [first, first + nb) as a ring starting at
+ * first + base % nb, instead of in increasing order. The other priorities
+ * are not affected. This lets callers tie priorities to a sequence number,
+ * e.g. the decode order of a frame, and move the start of the ring as the
+ * sequence advances, without queued tasks going stale.
+ */
+void ff_executor_rotate_priorities(FFExecutor *e, int first, int nb, int base);
+
 #endif //AVCODEC_EXECUTOR_H
@@ -29,6 +29,7 @@
 #include "libavutil/thread.h"
 #include "avcodec.h"
 #include "avcodec_internal.h"
+#include "codec_internal.h"
 #include "codec_par.h"
 #include "encode.h"
 #include "internal.h"
@@ -43,7 +44,9 @@
 
 typedef struct{
     AVFrame  *indata;
+    AVFrame  *merge_frame; ///< reference to indata for FFCodec.merge_thread_packet
     AVPacket *outdata;
+    int64_t   frame_num;
     int       return_code;
     int       finished;
     int       got_packet;
@@ -64,6 +67,7 @@ typedef struct{
     unsigned next_task_index;
     unsigned task_index;
     unsigned finished_task_index;
+    int64_t  frame_num;
 
     pthread_t worker[MAX_THREADS];
     atomic_int exit;
@@ -105,6 +109,7 @@ static void * attribute_align_arg worker(void *v){
         frame = task->indata;
         pkt   = task->outdata;
 
+        avctx->frame_num = task->frame_num;
         ret = ff_encode_encode_cb(avctx, pkt, frame, &task->got_packet);
         pthread_mutex_lock(&c->finished_task_mutex);
         task->return_code = ret;
@@ -194,6 +199,11 @@ av_cold int ff_frame_thread_encoder_init(AVCodecContext *avctx)
             ret = AVERROR(ENOMEM);
             goto fail;
         }
+        if (ffcodec(avctx->codec)->merge_thread_packet &&
+            !(c->tasks[j].merge_frame = av_frame_alloc())) {
+            ret = AVERROR(ENOMEM);
+            goto fail;
+        }
     }
 
     par = avcodec_parameters_alloc();
@@ -252,6 +262,7 @@ av_cold int ff_frame_thread_encoder_init(AVCodecContext *avctx)
             goto fail;
         av_assert0(!thread_avctx->internal->frame_thread_encoder);
         thread_avctx->internal->frame_thread_encoder = c;
+        thread_avctx->internal->is_copy              = 1;
         if ((ret = pthread_create(&c->worker[i], NULL, worker, thread_avctx))) {
             ret = AVERROR(ret);
             goto fail;
@@ -291,6 +302,7 @@ av_cold void ff_frame_thread_encoder_free(AVCodecContext *avctx)
 
     for (unsigned i = 0; i < c->max_tasks; i++) {
         av_frame_free(&c->tasks[i].indata);
+        av_frame_free(&c->tasks[i].merge_frame);
         av_packet_free(&c->tasks[i].outdata);
     }
 
@@ -301,13 +313,25 @@ av_cold void ff_frame_thread_encoder_free(AVCodecContext *avctx)
 int ff_thread_video_encode_frame(AVCodecContext *avctx, AVPacket *pkt,
                                  AVFrame *frame, int *got_packet_ptr)
 {
+    const FFCodec *const codec = ffcodec(avctx->codec);
     ThreadContext *c = avctx->internal->frame_thread_encoder;
     Task *outtask;
+    int ret;
 
     av_assert1(!*got_packet_ptr);
 
     if(frame){
-        av_frame_move_ref(c->tasks[c->task_index].indata, frame);
+        Task *task = &c->tasks[c->task_index];
+
+        av_frame_move_ref(task->indata, frame);
+        if (task->merge_frame) {
+            ret = av_frame_ref(task->merge_frame, task->indata);
+            if (ret < 0) {
+                av_frame_unref(task->indata);
+                return ret;
+            }
+        }
+        task->frame_num = c->frame_num++;
 
         pthread_mutex_lock(&c->task_fifo_mutex);
         c->task_index = (c->task_index + 1) % c->max_tasks;
@@ -323,6 +347,11 @@ int ff_thread_video_encode_frame(AVCodecContext *avctx, AVPacket *pkt,
         (frame && !outtask->finished &&
          (c->task_index - c->finished_task_index + c->max_tasks) % c->max_tasks <= avctx->thread_count)) {
             pthread_mutex_unlock(&c->finished_task_mutex);
+            /* All workers are drained; let the user-facing context, which
+             * has seen every packet through merge_thread_packet(), flush. */
+            if (!frame && c->task_index == c->finished_task_index &&
+                (codec->caps_internal & FF_CODEC_CAP_EOF_FLUSH))
+                return ff_encode_encode_cb(avctx, pkt, NULL, got_packet_ptr);
             return 0;
         }
     while (!outtask->finished) {
@@ -336,5 +365,17 @@ int ff_thread_video_encode_frame(AVCodecContext *avctx, AVPacket *pkt,
     *got_packet_ptr = outtask->got_packet;
     c->finished_task_index = (c->finished_task_index + 1) % c->max_tasks;
 
-    return outtask->return_code;
+    ret = outtask->return_code;
+    if (outtask->merge_frame) {
+        if (ret >= 0 && *got_packet_ptr) {
+            ret = codec->merge_thread_packet(avctx, pkt, outtask->merge_frame);
+            if (ret < 0) {
+                av_packet_unref(pkt);
+                *got_packet_ptr = 0;
+            }
+        }
+        av_frame_unref(outtask->merge_frame);
+    }
+
+    return ret;
 }
@@ -40,14 +40,42 @@
 #include "encode.h"
 #include "lzw.h"
 #include "gif.h"
+#include "put_bits.h"
 
 #define DEFAULT_TRANSPARENCY_INDEX 0x1f
 
-typedef struct GIFContext {
-    const AVClass *class;
+/* every code stream restarts with an empty table, so keep them long enough */
+#define MIN_SLICE_ROWS 16
+
+typedef struct GIFSlice {
     LZWState *lzw;
     uint8_t *buf;
-    uint8_t *shrunk_buf;
+    int buf_size;
+    int bits;                           ///< size of the code stream in bits
+    uint8_t *tmpl;                      ///< temporary line buffer
+} GIFSlice;
+
+/**
+ * The image data is cut into horizontal slices, each compressed into its
+ * own LZW code stream. All but the last stream end with a clear code
+ * instead of an end code, so that their concatenation is one valid stream.
+ */
+typedef struct GIFImage {
+    const uint8_t *buf;                 ///< top-left pixel of the image
+    int linesize;
+    const uint8_t *ref;                 ///< same for the previous frame if transparency is honored, or NULL
+    int ref_linesize;
+    const uint8_t *map;                 ///< palette remapping, or NULL
+    int width, height;
+    int trans;
+    int nb_slices;
+} GIFImage;
+
+typedef struct GIFContext {
+    const AVClass *class;
+    GIFSlice *slices;
+    int nb_slices;
+    uint8_t *buf;                       ///< concatenated code streams
     int buf_size;
     AVFrame *last_frame;
     int flags;
@@ -56,7 +84,6 @@ typedef struct GIFContext {
     uint32_t palette[AVPALETTE_COUNT];  ///< local reference palette for !pal8
     int palette_loaded;
     int transparent_index;
-    uint8_t *tmpl;                      ///< temporary line buffer
 } GIFContext;
 
 enum {
@@ -87,15 +114,6 @@ static void shrink_palette(const uint32_t *src, uint8_t *map,
     *palette_count = colors_seen;
 }
 
-static void remap_frame_to_palette(const uint8_t *src, int src_linesize,
-                                   uint8_t *dst, int dst_linesize,
-                                   int w, int h, uint8_t *map)
-{
-    for (int i = 0; i < h; i++)
-        for (int j = 0; j < w; j++)
-            dst[i * dst_linesize + j] = map[src[i * src_linesize + j]];
-}
-
 static int is_image_translucent(AVCodecContext *avctx,
                                 const uint8_t *buf, const int linesize)
 {
@@ -289,6 +307,49 @@ static void gif_crop_opaque(AVCodecContext *avctx,
     }
 }
 
+static int gif_encode_slice(AVCodecContext *avctx, void *arg, int jobnr, int threadnr)
+{
+    GIFContext *s = avctx->priv_data;
+    const GIFImage *img = arg;
+    GIFSlice *sl = &s->slices[jobnr];
+    const int y_begin = img->height *  jobnr      / img->nb_slices;
+    const int y_end   = img->height * (jobnr + 1) / img->nb_slices;
+    const uint8_t *ptr = img->buf + y_begin * img->linesize;
+    const uint8_t *ref = img->ref ? img->ref + y_begin * img->ref_linesize : NULL;
+    int len = 0;
+
+    ff_lzw_encode_init(sl->lzw, sl->buf, sl->buf_size,
+                       12, FF_LZW_GIF, 1);
+
+    for (int y = y_begin; y < y_end; y++) {
+        const uint8_t *line = ptr;
+
+        if (img->map) {
+            for (int x = 0; x < img->width; x++)
+                sl->tmpl[x] = img->map[ptr[x]];
+            line = sl->tmpl;
+        }
+        if (ref) {
+            if (line != sl->tmpl)
+                memcpy(sl->tmpl, line, img->width);
+            for (int x = 0; x < img->width; x++)
+                if (ref[x] == sl->tmpl[x])
+                    sl->tmpl[x] = img->trans;
+            line = sl->tmpl;
+            ref += img->ref_linesize;
+        }
+        len += ff_lzw_encode(sl->lzw, line, img->width);
+        ptr += img->linesize;
+    }
+
+    if (jobnr == img->nb_slices - 1)
+        sl->bits = (len + ff_lzw_encode_flush(sl->lzw)) * 8;
+    else
+        sl->bits = ff_lzw_encode_flush_clear(sl->lzw);
+
+    return 0;
+}
+
 static int gif_image_write_image(AVCodecContext *avctx,
                                  uint8_t **bytestream, uint8_t *end,
                                  const uint32_t *palette,
@@ -296,13 +357,14 @@ static int gif_image_write_image(AVCodecContext *avctx,
                                  AVPacket *pkt)
 {
     GIFContext *s = avctx->priv_data;
-    int disposal, len = 0, height = avctx->height, width = avctx->width, x, y;
+    int disposal, len, height = avctx->height, width = avctx->width;
     int x_start = 0, y_start = 0, trans = s->transparent_index;
     int bcid = -1, honor_transparency = (s->flags & GF_TRANSDIFF) && s->last_frame && !palette;
     const uint8_t *ptr;
     uint32_t shrunk_palette[AVPALETTE_COUNT];
     uint8_t map[AVPALETTE_COUNT] = { 0 };
     size_t shrunk_palette_count = 0;
+    GIFImage img;
 
     /*
      * We memset to 0xff instead of 0x00 so that the transparency detection
@@ -397,44 +459,42 @@ static int gif_image_write_image(AVCodecContext *avctx,
 
     bytestream_put_byte(bytestream, 0x08);
 
-    ff_lzw_encode_init(s->lzw, s->buf, s->buf_size,
-                       12, FF_LZW_GIF, 1);
-
-    if (shrunk_palette_count) {
-        if (!s->shrunk_buf) {
-            s->shrunk_buf = av_malloc(avctx->height * linesize);
-            if (!s->shrunk_buf) {
-                av_log(avctx, AV_LOG_ERROR, "Could not allocated remapped frame buffer.\n");
-                return AVERROR(ENOMEM);
-            }
-        }
-        remap_frame_to_palette(buf, linesize, s->shrunk_buf, linesize, avctx->width, avctx->height, map);
-        ptr = s->shrunk_buf + y_start*linesize + x_start;
-    } else {
-        ptr = buf + y_start*linesize + x_start;
-    }
+    img.buf          = buf + y_start * linesize + x_start;
+    img.linesize     = linesize;
+    img.ref          = NULL;
+    img.map          = shrunk_palette_count ? map : NULL;
+    img.width        = width;
+    img.height       = height;
+    img.trans        = trans;
+    img.nb_slices    = av_clip(height / MIN_SLICE_ROWS, 1, s->nb_slices);
     if (honor_transparency) {
-        const int ref_linesize = s->last_frame->linesize[0];
-        const uint8_t *ref = s->last_frame->data[0] + y_start*ref_linesize + x_start;
-
-        for (y = 0; y < height; y++) {
-            memcpy(s->tmpl, ptr, width);
-            for (x = 0; x < width; x++)
-                if (ref[x] == ptr[x])
-                    s->tmpl[x] = trans;
-            len += ff_lzw_encode(s->lzw, s->tmpl, width);
-            ptr += linesize;
-            ref += ref_linesize;
+        img.ref_linesize = s->last_frame->linesize[0];
+        img.ref          = s->last_frame->data[0] + y_start * img.ref_linesize + x_start;
+    }
+
+    avctx->execute2(avctx, gif_encode_slice, &img, NULL, img.nb_slices);
+
+    if (img.nb_slices > 1) {
+        PutBitContext pb;
+
+        init_put_bits(&pb, s->buf, s->buf_size);
+        for (int i = 0; i < img.nb_slices; i++) {
+            const uint8_t *src = s->slices[i].buf;
+            int bits = s->slices[i].bits;
+
+            for (; bits >= 8; bits -= 8)
+                put_bits_le(&pb, 8, *src++);
+            if (bits)
+                put_bits_le(&pb, bits, *src & ((1 << bits) - 1));
         }
+        flush_put_bits_le(&pb);
+        ptr = s->buf;
+        len = put_bytes_output(&pb);
     } else {
-        for (y = 0; y < height; y++) {
-            len += ff_lzw_encode(s->lzw, ptr, width);
-            ptr += linesize;
-        }
+        ptr = s->slices[0].buf;
+        len = s->slices[0].bits >> 3;
     }
-    len += ff_lzw_encode_flush(s->lzw);
 
-    ptr = s->buf;
     while (len > 0) {
         int size = FFMIN(255, len);
         bytestream_put_byte(bytestream, size);
@@ -451,6 +511,7 @@ static int gif_image_write_image(AVCodecContext *avctx,
 static av_cold int gif_encode_init(AVCodecContext *avctx)
 {
     GIFContext *s = avctx->priv_data;
+    int slice_rows;
 
     if (avctx->width > 65535 || avctx->height > 65535) {
         av_log(avctx, AV_LOG_ERROR, "GIF does not support resolutions above 65535x65535\n");
@@ -459,13 +520,35 @@ static av_cold int gif_encode_init(AVCodecContext *avctx)
 
     s->transparent_index = -1;
 
-    s->lzw = av_mallocz(ff_lzw_encode_state_size);
-    s->buf_size = avctx->width*avctx->height*2 + 1000;
-    s->buf = av_malloc(s->buf_size);
-    s->tmpl = av_malloc(avctx->width);
-    if (!s->tmpl || !s->buf || !s->lzw)
+    /* The strips change the code stream, so their number is set by the
+     * user and not derived from the thread count, which would make the
+     * output depend on the machine. */
+    s->nb_slices = av_clip(avctx->slices, 1, FFMAX(avctx->height / MIN_SLICE_ROWS, 1));
+    s->slices = av_calloc(s->nb_slices, sizeof(*s->slices));
+    if (!s->slices)
         return AVERROR(ENOMEM);
 
+    /* slices are at least MIN_SLICE_ROWS high, see gif_image_write_image() */
+    slice_rows = s->nb_slices > 1 ? FFMAX((avctx->height + s->nb_slices - 1) / s->nb_slices,
+                                          2 * MIN_SLICE_ROWS) : avctx->height;
+    slice_rows = FFMIN(slice_rows, avctx->height);
+    for (int i = 0; i < s->nb_slices; i++) {
+        GIFSlice *sl = &s->slices[i];
+
+        sl->lzw      = av_mallocz(ff_lzw_encode_state_size);
+        sl->buf_size = avctx->width * slice_rows * 2 + 1000;
+        sl->buf      = av_malloc(sl->buf_size);
+        sl->tmpl     = av_malloc(avctx->width);
+        if (!sl->lzw || !sl->buf || !sl->tmpl)
+            return AVERROR(ENOMEM);
+        s->buf_size += sl->buf_size;
+    }
+    if (s->nb_slices > 1) {
+        s->buf = av_malloc(s->buf_size);
+        if (!s->buf)
+            return AVERROR(ENOMEM);
+    }
+
     if (avpriv_set_systematic_pal2(s->palette, avctx->pix_fmt) < 0)
         av_assert0(avctx->pix_fmt == AV_PIX_FMT_PAL8);
 
@@ -525,12 +608,15 @@ static av_cold int gif_encode_close(AVCodecContext *avctx)
 {
     GIFContext *s = avctx->priv_data;
 
-    av_freep(&s->lzw);
+    for (int i = 0; s->slices && i < s->nb_slices; i++) {
+        av_freep(&s->slices[i].lzw);
+        av_freep(&s->slices[i].buf);
+        av_freep(&s->slices[i].tmpl);
+    }
+    av_freep(&s->slices);
     av_freep(&s->buf);
-    av_freep(&s->shrunk_buf);
     s->buf_size = 0;
     av_frame_free(&s->last_frame);
-    av_freep(&s->tmpl);
     return 0;
 }
 
@@ -557,7 +643,8 @@ const FFCodec ff_gif_encoder = {
     CODEC_LONG_NAME("GIF (Graphics Interchange Format)"),
     .p.type         = AVMEDIA_TYPE_VIDEO,
     .p.id           = AV_CODEC_ID_GIF,
-    .p.capabilities = AV_CODEC_CAP_DR1 | AV_CODEC_CAP_ENCODER_REORDERED_OPAQUE,
+    .p.capabilities = AV_CODEC_CAP_DR1 | AV_CODEC_CAP_SLICE_THREADS |
+                      AV_CODEC_CAP_ENCODER_REORDERED_OPAQUE,
     .priv_data_size = sizeof(GIFContext),
     .init           = gif_encode_init,
     FF_CODEC_ENCODE_CB(gif_encode_frame),
@@ -23,12 +23,15 @@
 
 #include "libavutil/mem.h"
 #include "libavutil/opt.h"
+#include "libavutil/refstruct.h"
 #include "avcodec.h"
 #include "bytestream.h"
 #include "codec_internal.h"
 #include "decode.h"
 #include "lzw.h"
 #include "gif.h"
+#include "progressframe.h"
+#include "thread.h"
 
 /* This value is intentionally set to "transparent white" color.
  * It is much better to have white background instead of black
@@ -38,7 +41,8 @@
 
 typedef struct GifState {
     const AVClass *class;
-    AVFrame *frame;
+    ProgressFrame picture;      ///< canvas being decoded
+    ProgressFrame last_picture; ///< canvas of the previous frame
     int screen_width;
     int screen_height;
     int has_global_palette;
@@ -47,10 +51,10 @@ typedef struct GifState {
     int background_color_index;
     int transparent_color_index;
     int color_resolution;
-    /* intermediate buffer for storing color indices
-     * obtained from lzw-encoded data stream */
-    uint8_t *idx_line;
-    int idx_line_size;
+    /* intermediate buffer for storing the color indices of the whole
+     * image obtained from lzw-encoded data stream, in coded line order */
+    uint8_t *idx_buf;
+    unsigned idx_buf_size;
 
     /* after the frame is displayed, the disposal method is used */
     int gce_prev_disposal;
@@ -59,11 +63,25 @@ typedef struct GifState {
     int gce_l, gce_t, gce_w, gce_h;
     /* depending on disposal method we store either part of the image
      * drawn on the canvas or background color that
-     * should be used upon disposal */
+     * should be used upon disposal; stored_img is a RefStruct shared
+     * with the next frame, with a linesize of 4 * screen_width */
     uint8_t *stored_img;
     int stored_img_size;
     int stored_bg_color;
 
+    /* the image of the current frame, as parsed by gif_read_image()
+     * and drawn by gif_draw_image() once the previous canvas is known */
+    int img_left, img_top, img_width, img_pw, img_height;
+    int img_interlaced;
+    int img_trans;
+    const uint32_t *img_pal;
+    int img_fill;               ///< fill the whole canvas with img_fill_color first
+    uint32_t img_fill_color;
+    int dispose;                ///< disposal of the previous frame to apply
+    int dispose_l, dispose_t, dispose_w, dispose_h;
+    uint32_t dispose_color;
+    uint8_t *restore_img;       ///< RefStruct reference to the image to restore
+
     GetByteContext gb;
     LZWState *lzw;
 
@@ -130,14 +148,11 @@ static void gif_copy_img_rect(const uint8_t *src, uint8_t *dst,
     }
 }
 
-static int gif_read_image(GifState *s, AVFrame *frame)
+static int gif_read_image(GifState *s)
 {
-    int left, top, width, height, bits_per_pixel, code_size, flags, pw;
-    int is_interleaved, has_local_palette, y, pass, y1, pal_size, lzwed_len;
-    uint32_t *ptr, *pal, *px, *pr, *ptr1;
-    ptrdiff_t linesize;
-    int ret;
-    uint8_t *idx;
+    int left, top, width, height, bits_per_pixel, flags, pw;
+    int has_local_palette, pal_size;
+    const uint32_t *pal;
 
     /* At least 9 bytes of Image Descriptor. */
     if (bytestream2_get_bytes_left(&s->gb) < 9)
@@ -148,7 +163,7 @@ static int gif_read_image(GifState *s, AVFrame *frame)
     width  = bytestream2_get_le16u(&s->gb);
     height = bytestream2_get_le16u(&s->gb);
     flags  = bytestream2_get_byteu(&s->gb);
-    is_interleaved = flags & 0x40;
+    s->img_interlaced = flags & 0x40;
     has_local_palette = flags & 0x80;
     bits_per_pixel = (flags & 0x07) + 1;
 
@@ -171,15 +186,14 @@ static int gif_read_image(GifState *s, AVFrame *frame)
         pal = s->global_palette;
     }
 
-    if (s->keyframe) {
-        if (s->transparent_color_index == -1 && s->has_global_palette) {
-            /* transparency wasn't set before the first frame, fill with background color */
-            gif_fill(frame, s->bg_color);
-        } else {
-            /* otherwise fill with transparent color.
-             * this is necessary since by default picture filled with 0x80808080. */
-            gif_fill(frame, s->trans_color);
-        }
+    s->img_fill = s->keyframe;
+    if (s->transparent_color_index == -1 && s->has_global_palette) {
+        /* transparency wasn't set before the first frame, fill with background color */
+        s->img_fill_color = s->bg_color;
+    } else {
+        /* otherwise fill with transparent color.
+         * this is necessary since by default picture filled with 0x80808080. */
+        s->img_fill_color = s->trans_color;
     }
 
     /* verify that all the image is inside the screen dimensions */
@@ -214,13 +228,20 @@ static int gif_read_image(GifState *s, AVFrame *frame)
         height = s->screen_height - top;
     }
 
+    /* Expect at least 2 bytes: 1 for lzw code size and 1 for block size. */
+    if (bytestream2_get_bytes_left(&s->gb) < 2)
+        return AVERROR_INVALIDDATA;
+
+    av_fast_malloc(&s->idx_buf, &s->idx_buf_size, (size_t)width * height);
+    if (!s->idx_buf)
+        return AVERROR(ENOMEM);
+
     /* process disposal method */
-    if (s->gce_prev_disposal == GCE_DISPOSAL_BACKGROUND) {
-        gif_fill_rect(frame, s->stored_bg_color, s->gce_l, s->gce_t, s->gce_w, s->gce_h);
-    } else if (s->gce_prev_disposal == GCE_DISPOSAL_RESTORE) {
-        gif_copy_img_rect(s->stored_img, frame->data[0],
-            FFABS(frame->linesize[0]), frame->linesize[0], s->gce_l, s->gce_t, s->gce_w, s->gce_h);
-    }
+    s->dispose   = s->gce_prev_disposal;
+    s->dispose_l = s->gce_l;  s->dispose_t = s->gce_t;
+    s->dispose_w = s->gce_w;  s->dispose_h = s->gce_h;
+    s->dispose_color = s->stored_bg_color;
+    av_refstruct_unref(&s->restore_img);
 
     s->gce_prev_disposal = s->gce_disposal;
 
@@ -234,18 +255,49 @@ static int gif_read_image(GifState *s, AVFrame *frame)
             else
                 s->stored_bg_color = s->bg_color;
         } else if (s->gce_disposal == GCE_DISPOSAL_RESTORE) {
-            av_fast_malloc(&s->stored_img, &s->stored_img_size, FFABS(frame->linesize[0]) * frame->height);
-            if (!s->stored_img)
-                return AVERROR(ENOMEM);
-
-            gif_copy_img_rect(frame->data[0], s->stored_img,
-                frame->linesize[0], FFABS(frame->linesize[0]), left, top, pw, height);
+            const int size = 4 * s->screen_width * s->screen_height;
+
+            /* the previous buffer may still be needed by other frames,
+             * and by this one as the image to restore */
+            if (!s->stored_img || s->stored_img_size != size ||
+                !av_refstruct_exclusive(s->stored_img)) {
+                FFSWAP(uint8_t *, s->restore_img, s->stored_img);
+                s->stored_img = av_refstruct_alloc_ext(size, 0, NULL, NULL);
+                if (!s->stored_img)
+                    return AVERROR(ENOMEM);
+                s->stored_img_size = size;
+            }
         }
     }
+    /* the image stored for a previous frame is restored before this one is
+     * stored, so a buffer that is not shared can be used for both */
+    if (!s->restore_img)
+        av_refstruct_replace(&s->restore_img, s->stored_img);
+
+    s->img_left   = left;
+    s->img_top    = top;
+    s->img_width  = width;
+    s->img_pw     = pw;
+    s->img_height = height;
+    s->img_trans  = s->transparent_color_index;
+    s->img_pal    = pal;
 
-    /* Expect at least 2 bytes: 1 for lzw code size and 1 for block size. */
-    if (bytestream2_get_bytes_left(&s->gb) < 2)
-        return AVERROR_INVALIDDATA;
+    /* Graphic Control Extension's scope is single frame.
+     * Remove its influence. */
+    s->transparent_color_index = -1;
+    s->gce_disposal = GCE_DISPOSAL_NONE;
+
+    return 0;
+}
+
+/**
+ * Decode the color indices of the image, which does not depend on the
+ * previous canvas.
+ * @return number of decoded lines or a negative error code
+ */
+static int gif_decode_image(GifState *s)
+{
+    int y, code_size, lzwed_len, ret;
 
     /* now get the image data */
     code_size = bytestream2_get_byteu(&s->gb);
@@ -256,27 +308,65 @@ static int gif_read_image(GifState *s, AVFrame *frame)
     }
 
     /* read all the image */
-    linesize = frame->linesize[0];
-    ptr1 = (uint32_t *)(frame->data[0] + top * linesize) + left;
-    ptr = ptr1;
-    pass = 0;
-    y1 = 0;
-    for (y = 0; y < height; y++) {
-        int count = ff_lzw_decode(s->lzw, s->idx_line, width);
-        if (count != width) {
+    for (y = 0; y < s->img_height; y++) {
+        uint8_t *idx = s->idx_buf + (size_t)y * s->img_width;
+        int count = ff_lzw_decode(s->lzw, idx, s->img_width);
+        if (count != s->img_width) {
             if (count)
                 av_log(s->avctx, AV_LOG_ERROR, "LZW decode failed\n");
-            goto decode_tail;
+            break;
         }
+    }
+
+    /* read the garbage data until end marker is found */
+    lzwed_len = ff_lzw_decode_tail(s->lzw);
+    bytestream2_skipu(&s->gb, lzwed_len);
+
+    return y;
+}
+
+/**
+ * Apply the disposal of the previous frame, then draw the first nb_lines
+ * decoded lines of the image on the canvas.
+ */
+static void gif_draw_image(GifState *s, AVFrame *frame, int nb_lines)
+{
+    const ptrdiff_t linesize = frame->linesize[0];
+    const int stored_linesize = 4 * s->screen_width;
+    uint32_t *ptr, *ptr1, *px, *pr;
+    int y, y1, pass;
+    const uint8_t *idx;
+
+    if (s->img_fill)
+        gif_fill(frame, s->img_fill_color);
+
+    if (s->dispose == GCE_DISPOSAL_BACKGROUND) {
+        gif_fill_rect(frame, s->dispose_color, s->dispose_l, s->dispose_t, s->dispose_w, s->dispose_h);
+    } else if (s->dispose == GCE_DISPOSAL_RESTORE) {
+        gif_copy_img_rect(s->restore_img, frame->data[0], stored_linesize, linesize,
+                          s->dispose_l, s->dispose_t, s->dispose_w, s->dispose_h);
+    }
 
-        pr = ptr + pw;
+    /* store the area of this image if its own disposal restores it */
+    if (s->gce_prev_disposal == GCE_DISPOSAL_RESTORE) {
+        gif_copy_img_rect(frame->data[0], s->stored_img, linesize, stored_linesize,
+                          s->img_left, s->img_top, s->img_pw, s->img_height);
+    }
+
+    ptr1 = (uint32_t *)(frame->data[0] + s->img_top * linesize) + s->img_left;
+    ptr = ptr1;
+    pass = 0;
+    y1 = 0;
+    for (y = 0; y < nb_lines; y++) {
+        idx = s->idx_buf + (size_t)y * s->img_width;
+        pr  = ptr + s->img_pw;
 
-        for (px = ptr, idx = s->idx_line; px < pr; px++, idx++) {
-            if (*idx != s->transparent_color_index)
-                *px = pal[*idx];
+        for (px = ptr; px < pr; px++, idx++) {
+            if (*idx != s->img_trans)
+                *px = s->img_pal[*idx];
         }
 
-        if (is_interleaved) {
+        if (s->img_interlaced) {
             switch(pass) {
             default:
             case 0:
@@ -293,7 +383,7 @@ static int gif_read_image(GifState *s, AVFrame *frame)
                 ptr += linesize / 2;
                 break;
             }
-            while (y1 >= height) {
+            while (y1 >= s->img_height) {
                 y1  = 4 >> pass;
                 ptr = ptr1 + linesize / 4 * y1;
                 pass++;
@@ -302,18 +392,6 @@ static int gif_read_image(GifState *s, AVFrame *frame)
             ptr += linesize / 4;
         }
     }
-
- decode_tail:
-    /* read the garbage data until end marker is found */
-    lzwed_len = ff_lzw_decode_tail(s->lzw);
-    bytestream2_skipu(&s->gb, lzwed_len);
-
-    /* Graphic Control Extension's scope is single frame.
-     * Remove its influence. */
-    s->transparent_color_index = -1;
-    s->gce_disposal = GCE_DISPOSAL_NONE;
-
-    return 0;
 }
 
 static int gif_read_extension(GifState *s)
@@ -426,7 +504,7 @@ static int gif_read_header1(GifState *s)
     return 0;
 }
 
-static int gif_parse_next_image(GifState *s, AVFrame *frame)
+static int gif_parse_next_image(GifState *s)
 {
     while (bytestream2_get_bytes_left(&s->gb) > 0) {
         int code = bytestream2_get_byte(&s->gb);
@@ -436,7 +514,7 @@ static int gif_parse_next_image(GifState *s, AVFrame *frame)
 
         switch (code) {
         case GIF_IMAGE_SEPARATOR:
-            return gif_read_image(s, frame);
+            return gif_read_image(s);
         case GIF_EXTENSION_INTRODUCER:
             if ((ret = gif_read_extension(s)) < 0)
                 return ret;
@@ -459,9 +537,6 @@ static av_cold int gif_decode_init(AVCodecContext *avctx)
     s->avctx = avctx;
 
     avctx->pix_fmt = AV_PIX_FMT_RGB32;
-    s->frame = av_frame_alloc();
-    if (!s->frame)
-        return AVERROR(ENOMEM);
     ff_lzw_decode_open(&s->lzw);
     if (!s->lzw)
         return AVERROR(ENOMEM);
@@ -472,7 +547,7 @@ static int gif_decode_frame(AVCodecContext *avctx, AVFrame *rframe,
                             int *got_frame, AVPacket *avpkt)
 {
     GifState *s = avctx->priv_data;
-    int ret;
+    int ret, nb_lines;
 
     bytestream2_init(&s->gb, avpkt->data, avpkt->size);
 
@@ -483,52 +558,112 @@ static int gif_decode_frame(AVCodecContext *avctx, AVFrame *rframe,
         s->keyframe = 0;
     }
 
+    ff_progress_frame_unref(&s->picture);
+
     if (s->keyframe) {
         s->keyframe_ok = 0;
         s->gce_prev_disposal = GCE_DISPOSAL_NONE;
+        ff_progress_frame_unref(&s->last_picture);
         if ((ret = gif_read_header1(s)) < 0)
             return ret;
 
         if ((ret = ff_set_dimensions(avctx, s->screen_width, s->screen_height)) < 0)
             return ret;
-
-        av_frame_unref(s->frame);
-        av_fast_malloc(&s->idx_line, &s->idx_line_size, s->screen_width);
-        if (!s->idx_line)
-            return AVERROR(ENOMEM);
-    } else if (!s->keyframe_ok) {
+    } else if (!s->keyframe_ok || !s->last_picture.f) {
         av_log(avctx, AV_LOG_ERROR, "cannot decode frame without keyframe\n");
         return AVERROR_INVALIDDATA;
     }
 
-    ret = ff_reget_buffer(avctx, s->frame, 0);
+    ret = gif_parse_next_image(s);
     if (ret < 0)
         return ret;
 
-    ret = gif_parse_next_image(s, s->frame);
+    ret = ff_progress_frame_get_buffer(avctx, &s->picture, 0);
+    if (ret < 0)
+        return ret;
+    s->keyframe_ok |= !!s->keyframe;
+
+    /* everything the next frame needs is known, except for the pixels */
+    ff_thread_finish_setup(avctx);
+
+    nb_lines = gif_decode_image(s);
+
+    if (!s->keyframe) {
+        ff_progress_frame_await(&s->last_picture, INT_MAX);
+        ret = av_frame_copy(s->picture.f, s->last_picture.f);
+    }
+    if (ret >= 0)
+        gif_draw_image(s, s->picture.f, FFMAX(nb_lines, 0));
+    ff_progress_frame_report(&s->picture, INT_MAX);
+
+    if (!(avctx->active_thread_type & FF_THREAD_FRAME))
+        ff_progress_frame_replace(&s->last_picture, &s->picture);
+    av_refstruct_unref(&s->restore_img);
+
     if (ret < 0)
         return ret;
+    if (nb_lines < 0)
+        return nb_lines;
 
-    if ((ret = av_frame_ref(rframe, s->frame)) < 0)
+    if ((ret = av_frame_ref(rframe, s->picture.f)) < 0)
         return ret;
 
     rframe->pict_type = s->keyframe ? AV_PICTURE_TYPE_I : AV_PICTURE_TYPE_P;
     rframe->flags     = AV_FRAME_FLAG_KEY * s->keyframe;
-    s->keyframe_ok   |= !!s->keyframe;
 
     *got_frame = 1;
 
     return bytestream2_tell(&s->gb);
 }
 
+#if HAVE_THREADS
+static int update_thread_context(AVCodecContext *dst, const AVCodecContext *src)
+{
+    GifState *sdst = dst->priv_data;
+    const GifState *ssrc = src->priv_data;
+
+    if (dst == src)
+        return 0;
+
+    sdst->screen_width            = ssrc->screen_width;
+    sdst->screen_height           = ssrc->screen_height;
+    sdst->has_global_palette      = ssrc->has_global_palette;
+    sdst->bits_per_pixel          = ssrc->bits_per_pixel;
+    sdst->bg_color                = ssrc->bg_color;
+    sdst->background_color_index  = ssrc->background_color_index;
+    sdst->transparent_color_index = ssrc->transparent_color_index;
+    sdst->color_resolution        = ssrc->color_resolution;
+    sdst->gce_prev_disposal       = ssrc->gce_prev_disposal;
+    sdst->gce_disposal            = ssrc->gce_disposal;
+    sdst->gce_l                   = ssrc->gce_l;
+    sdst->gce_t                   = ssrc->gce_t;
+    sdst->gce_w                   = ssrc->gce_w;
+    sdst->gce_h                   = ssrc->gce_h;
+    sdst->stored_bg_color         = ssrc->stored_bg_color;
+    sdst->stored_img_size         = ssrc->stored_img_size;
+    sdst->keyframe_ok             = ssrc->keyframe_ok;
+    memcpy(sdst->global_palette, ssrc->global_palette, sizeof(sdst->global_palette));
+
+    av_refstruct_replace(&sdst->stored_img, ssrc->stored_img);
+
+    /* a frame that failed before allocating its canvas left it unchanged */
+    ff_progress_frame_replace(&sdst->last_picture,
+                              ssrc->picture.f ? &ssrc->picture : &ssrc->last_picture);
+
+    return 0;
+}
+#endif
+
 static av_cold int gif_decode_close(AVCodecContext *avctx)
 {
     GifState *s = avctx->priv_data;
 
     ff_lzw_decode_close(&s->lzw);
-    av_frame_free(&s->frame);
-    av_freep(&s->idx_line);
-    av_freep(&s->stored_img);
+    ff_progress_frame_unref(&s->picture);
+    ff_progress_frame_unref(&s->last_picture);
+    av_freep(&s->idx_buf);
+    av_refstruct_unref(&s->stored_img);
+    av_refstruct_unref(&s->restore_img);
 
     return 0;
 }
@@ -558,7 +693,9 @@ const FFCodec ff_gif_decoder = {
     .init           = gif_decode_init,
     .close          = gif_decode_close,
     FF_CODEC_DECODE_CB(gif_decode_frame),
-    .p.capabilities = AV_CODEC_CAP_DR1,
-    .caps_internal  = FF_CODEC_CAP_INIT_CLEANUP,
+    UPDATE_THREAD_CONTEXT(update_thread_context),
+    .p.capabilities = AV_CODEC_CAP_DR1 | AV_CODEC_CAP_FRAME_THREADS,
+    .caps_internal  = FF_CODEC_CAP_INIT_CLEANUP |
+                      FF_CODEC_CAP_USES_PROGRESSFRAMES,
     .p.priv_class   = &decoder_class,
 };
@@ -2488,8 +2488,11 @@ static void loop_filter(const H264Context *h, H264SliceContext *sl, int start_x,
                     linesize   = sl->mb_linesize   = sl->linesize;
                     uvlinesize = sl->mb_uvlinesize = sl->uvlinesize;
                 }
-                backup_mb_border(h, sl, dest_y, dest_cb, dest_cr, linesize,
-                                 uvlinesize, 0);
+                if (!sl->deblock_only)
+                    backup_mb_border(h, sl, dest_y, dest_cb, dest_cr, linesize,
+                                     uvlinesize, 0);
+                if (sl->deblock_progress)
+                    continue;
                 if (fill_filter_caches(h, sl, mb_type))
                     continue;
                 sl->chroma_qp[0] = get_chroma_qp(h->ps.pps, 0, h->cur_pic.qscale_table[mb_xy]);
@@ -2531,6 +2534,11 @@ static void decode_finish_row(const H264Context *h, H264SliceContext *sl)
     int height         =  16      << FRAME_MBAFF(h);
     int deblock_border = (16 + 4) << FRAME_MBAFF(h);
 
+    if (sl->deblock_progress) {
+        ff_thread_progress_report(sl->deblock_progress, sl->mb_y + 1);
+        return;
+    }
+
     if (sl->deblocking_filter) {
         if ((top + height) >= pic_height)
             height += deblock_border;
@@ -2774,6 +2782,83 @@ finish:
     return 0;
 }
 
+static int decode_slice_deblock_job(AVCodecContext *avctx, void *arg,
+                                    int jobnr, int threadnr)
+{
+    H264Context      *h  = arg;
+    H264SliceContext *sl = &h->slice_ctx[0];
+    H264SliceContext *lf = &h->slice_ctx[1];
+    int mb_y, ret;
+
+    if (!jobnr) {
+        ret = decode_slice(avctx, sl);
+
+        /* hand whatever was decoded over to the deblocking job */
+        h->deblock_end_x = ret >= 0 && sl->mb_y < h->mb_height ? sl->mb_x : 0;
+        atomic_store(&h->deblock_end_row, sl->mb_y);
+        ff_thread_progress_report(sl->deblock_progress, INT_MAX);
+        return ret;
+    }
+
+    for (mb_y = 0;; mb_y++) {
+        /* Deblocking a row modifies the bottom lines of the row above and
+         * must wait until the row below has been decoded, as its intra
+         * prediction temporarily swaps the unfiltered borders back in. */
+        ff_thread_progress_await(&h->deblock_progress, mb_y + 2);
+        if (mb_y >= atomic_load(&h->deblock_end_row))
+            break;
+        lf->mb_y = mb_y;
+        loop_filter(h, lf, 0, h->mb_width);
+        decode_finish_row(h, lf);
+    }
+    if (h->deblock_end_x) {
+        lf->mb_y = mb_y;
+        loop_filter(h, lf, 0, h->deblock_end_x);
+    }
+
+    return 0;
+}
+
+/**
+ * Decode a single slice covering the whole picture on two slice threads:
+ * one decodes the macroblocks while the other deblocks the finished rows,
+ * trailing it by one row.
+ */
+static int decode_slice_deblock_pipelined(H264Context *h)
+{
+    H264SliceContext *sl = &h->slice_ctx[0];
+    H264SliceContext *lf = &h->slice_ctx[1];
+    int ret[2];
+
+    /* only what the loop filter needs, lf keeps its own buffers */
+    lf->slice_num             = sl->slice_num;
+    lf->slice_type            = sl->slice_type;
+    lf->slice_type_nos        = sl->slice_type_nos;
+    lf->list_count            = sl->list_count;
+    lf->qscale                = sl->qscale;
+    lf->qp_thresh             = sl->qp_thresh;
+    lf->deblocking_filter     = sl->deblocking_filter;
+    lf->slice_alpha_c0_offset = sl->slice_alpha_c0_offset;
+    lf->slice_beta_offset     = sl->slice_beta_offset;
+    lf->mb_mbaff              =
+    lf->mb_field_decoding_flag = 0;
+    lf->linesize              = h->cur_pic_ptr->f->linesize[0];
+    lf->uvlinesize            = h->cur_pic_ptr->f->linesize[1];
+    lf->deblock_progress      = NULL;
+    lf->deblock_only          = 1;
+
+    ff_thread_progress_reset(&h->deblock_progress);
+    atomic_init(&h->deblock_end_row, INT_MAX);
+    sl->deblock_progress = &h->deblock_progress;
+
+    h->avctx->execute2(h->avctx, decode_slice_deblock_job, h, ret, 2);
+
+    sl->deblock_progress = NULL;
+    lf->deblock_only     = 0;
+
+    return ret[0];
+}
+
 /**
  * Call decode_slice() for each context.
  *
@@ -2796,10 +2881,19 @@ int ff_h264_execute_decode_slices(H264Context *h)
 
     if (context_count == 1) {
 
-        h->slice_ctx[0].next_slice_idx = h->mb_width * h->mb_height;
+        sl = &h->slice_ctx[0];
+        sl->next_slice_idx = h->mb_width * h->mb_height;
         h->postpone_filter = 0;
 
-        ret = decode_slice(avctx, &h->slice_ctx[0]);
+        /* With a single slice for the whole picture the other slice threads
+         * would be idle, so let one of them do the deblocking. */
+        if (h->nb_slice_ctx > 1 && sl->deblocking_filter &&
+            !sl->mb_x && !sl->mb_y &&
+            h->picture_structure == PICT_FRAME && !FRAME_MBAFF(h) &&
+            !(CONFIG_GRAY && (h->flags & AV_CODEC_FLAG_GRAY)))
+            ret = decode_slice_deblock_pipelined(h);
+        else
+            ret = decode_slice(avctx, sl);
         h->mb_y = h->slice_ctx[0].mb_y;
         if (ret < 0)
             goto finish;
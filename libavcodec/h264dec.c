@@ -324,6 +324,12 @@ static int h264_init_context(AVCodecContext *avctx, H264Context *h)
         return AVERROR(ENOMEM);
     }
 
+    if (avctx->active_thread_type & FF_THREAD_SLICE) {
+        ret = ff_thread_progress_init(&h->deblock_progress, 1);
+        if (ret < 0)
+            return ret;
+    }
+
     for (i = 0; i < H264_MAX_PICTURE_COUNT; i++) {
         if ((ret = h264_init_pic(&h->DPB[i])) < 0)
             return ret;
@@ -367,6 +373,7 @@ static av_cold int h264_decode_end(AVCodecContext *avctx)
 
     av_freep(&h->slice_ctx);
     h->nb_slice_ctx = 0;
+    ff_thread_progress_destroy(&h->deblock_progress);
 
     ff_h264_sei_uninit(&h->sei);
     ff_h264_ps_uninit(&h->ps);
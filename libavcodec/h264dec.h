@@ -42,6 +42,7 @@
 #include "h264qpel.h"
 #include "mpegutils.h"
 #include "threadframe.h"
+#include "threadprogress.h"
 #include "videodsp.h"
 
 #define H264_MAX_PICTURE_COUNT 36
@@ -194,6 +195,13 @@ typedef struct H264SliceContext {
     int deblocking_filter;          ///< disable_deblocking_filter_idc with 1 <-> 0
     int slice_alpha_c0_offset;
     int slice_beta_offset;
+    /**
+     * If set, the MB rows of this slice are deblocked by another slice
+     * thread: only the unfiltered borders are saved while decoding, and
+     * the number of finished rows is reported here.
+     */
+    ThreadProgress *deblock_progress;
+    int deblock_only;               ///< only deblock the rows decoded by another slice context
 
     H264PredWeightTable pwt;
 
@@ -372,6 +380,14 @@ typedef struct H264Context {
      */
     int postpone_filter;
 
+    /**
+     * MB rows decoded by slice_ctx[0] when a single slice is deblocked on a
+     * second slice thread, see ff_h264_execute_decode_slices().
+     */
+    ThreadProgress deblock_progress;
+    atomic_int deblock_end_row; ///< row at which decoding stopped, INT_MAX while still decoding
+    int deblock_end_x;          ///< number of MBs of deblock_end_row to deblock
+
     /*
      * Set to 1 when the current picture is IDR, 0 otherwise.
      */
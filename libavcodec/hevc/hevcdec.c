@@ -2038,7 +2038,7 @@ static void chroma_mc_bi(HEVCLocalContext *lc,
 static void hevc_await_progress(const HEVCContext *s, const HEVCFrame *ref,
                                 const Mv *mv, int y0, int height)
 {
-    if (s->avctx->active_thread_type == FF_THREAD_FRAME ) {
+    if (s->avctx->active_thread_type & FF_THREAD_FRAME ) {
         int y = FFMAX(0, (mv->y >> 2) + y0 + height + 9);
 
         ff_progress_frame_await(&ref->tf, y);
@@ -2748,7 +2748,25 @@ static void hls_decode_neighbour(HEVCLocalContext *lc,
     lc->ctb_up_left_flag = ((x_ctb > 0) && (y_ctb > 0)  && (ctb_addr_in_slice-1 >= sps->ctb_width) && (pps->tile_id[ctb_addr_ts] == pps->tile_id[pps->ctb_addr_rs_to_ts[ctb_addr_rs-1 - sps->ctb_width]]));
 }
 
-static int hls_decode_entry(HEVCContext *s, GetBitContext *gb)
+/**
+ * State shared by the entropy decoder and the loop filter when the latter
+ * runs on its own thread, trailing the former by one CTB row.
+ */
+typedef struct LoopFilterPipeline {
+    HEVCContext    *s;
+    GetBitContext  *gb;
+    ThreadProgress *progress;     ///< number of CTBs (in tile scan) decoded
+    int             ctb_addr_start;
+    /**
+     * Tile scan address of the first CTB not decoded, INT_MAX while the
+     * entropy decoder is still running.
+     */
+    atomic_int      ctb_addr_end;
+    int             filter_last;  ///< whether the last CTB of the picture was decoded successfully
+} LoopFilterPipeline;
+
+static int hls_decode_entry(HEVCContext *s, GetBitContext *gb,
+                            LoopFilterPipeline *lfp)
 {
     HEVCLocalContext *const lc = &s->local_ctx[0];
     const HEVCLayerContext *const l = &s->layers[s->cur_layer];
@@ -2773,7 +2791,7 @@ static int hls_decode_entry(HEVCContext *s, GetBitContext *gb)
         ret = ff_hevc_cabac_init(lc, pps, ctb_addr_ts, slice_data, slice_size, 0);
         if (ret < 0) {
             l->tab_slice_address[ctb_addr_rs] = -1;
-            return ret;
+            goto end;
         }
 
         hls_sao_param(lc, l, pps, sps,
@@ -2786,20 +2804,82 @@ static int hls_decode_entry(HEVCContext *s, GetBitContext *gb)
         more_data = hls_coding_quadtree(lc, l, pps, sps, x_ctb, y_ctb, sps->log2_ctb_size, 0);
         if (more_data < 0) {
             l->tab_slice_address[ctb_addr_rs] = -1;
-            return more_data;
+            ret = more_data;
+            goto end;
         }
 
 
         ctb_addr_ts++;
         ff_hevc_save_states(lc, pps, ctb_addr_ts);
+        if (lfp)
+            ff_thread_progress_report(lfp->progress, ctb_addr_ts);
+        else
+            ff_hevc_hls_filters(lc, l, pps, x_ctb, y_ctb, ctb_size);
+    }
+
+    if (!lfp &&
+        x_ctb + ctb_size >= sps->width &&
+        y_ctb + ctb_size >= sps->height)
+        ff_hevc_hls_filter(lc, l, pps, x_ctb, y_ctb, ctb_size);
+
+    ret = ctb_addr_ts;
+end:
+    if (lfp) {
+        /* let the loop filter catch up with everything decoded so far */
+        lfp->filter_last = ret >= 0;
+        atomic_store(&lfp->ctb_addr_end, ctb_addr_ts);
+        ff_thread_progress_report(lfp->progress, INT_MAX);
+    }
+    return ret;
+}
+
+static void loop_filter_pipelined(HEVCLocalContext *lc, LoopFilterPipeline *lfp)
+{
+    const HEVCContext *const s = lc->parent;
+    const HEVCLayerContext *const l = &s->layers[s->cur_layer];
+    const HEVCPPS   *const pps = s->pps;
+    const HEVCSPS   *const sps = pps->sps;
+    int ctb_size    = 1 << sps->log2_ctb_size;
+    int ctb_addr_ts = lfp->ctb_addr_start;
+    int x_ctb       = 0;
+    int y_ctb       = 0;
+
+    for (;; ctb_addr_ts++) {
+        int ctb_addr_rs;
+
+        /* Filtering after a CTB only modifies and reads the CTB rows above
+         * it (the bottom row is only filtered at the end), so it must not
+         * start before the entropy decoder is done with the CTB below,
+         * whose intra prediction still needs unfiltered samples. */
+        ff_thread_progress_await(lfp->progress, ctb_addr_ts + 1 + sps->ctb_width);
+        if (ctb_addr_ts >= atomic_load(&lfp->ctb_addr_end))
+            break;
+
+        ctb_addr_rs = pps->ctb_addr_ts_to_rs[ctb_addr_ts];
+        x_ctb = (ctb_addr_rs % sps->ctb_width) << sps->log2_ctb_size;
+        y_ctb = (ctb_addr_rs / sps->ctb_width) << sps->log2_ctb_size;
         ff_hevc_hls_filters(lc, l, pps, x_ctb, y_ctb, ctb_size);
     }
 
-    if (x_ctb + ctb_size >= sps->width &&
+    if (ctb_addr_ts > lfp->ctb_addr_start && lfp->filter_last &&
+        x_ctb + ctb_size >= sps->width &&
         y_ctb + ctb_size >= sps->height)
         ff_hevc_hls_filter(lc, l, pps, x_ctb, y_ctb, ctb_size);
+}
+
+static int hls_decode_entry_pipelined_job(AVCodecContext *avctx, void *arg,
+                                          int job, int thread)
+{
+    LoopFilterPipeline *lfp = arg;
+    HEVCContext *s = lfp->s;
+
+    /* Jobs are started in order, so the entropy decoder is always running
+     * (or done) by the time the loop filter waits for it. */
+    if (!job)
+        return hls_decode_entry(s, lfp->gb, lfp);
 
-    return ctb_addr_ts;
+    loop_filter_pipelined(&s->local_ctx[1], lfp);
+    return 0;
 }
 
 static int hls_decode_entry_wpp(AVCodecContext *avctx, void *hevc_lclist,
@@ -2923,27 +3003,10 @@ static int wpp_progress_init(HEVCContext *s, unsigned count)
     return 0;
 }
 
-static int hls_slice_data_wpp(HEVCContext *s, const H2645NAL *nal)
+static int local_ctx_alloc(HEVCContext *s, unsigned count)
 {
-    const HEVCPPS *const pps = s->pps;
-    const HEVCSPS *const sps = pps->sps;
-    const uint8_t *data = nal->data;
-    int length          = nal->size;
-    int *ret;
-    int64_t offset;
-    int64_t startheader, cmpt = 0;
-    int i, j, res = 0;
-
-    if (s->sh.slice_ctb_addr_rs + s->sh.num_entry_point_offsets * sps->ctb_width >= sps->ctb_width * sps->ctb_height) {
-        av_log(s->avctx, AV_LOG_ERROR, "WPP ctb addresses are wrong (%d %d %d %d)\n",
-            s->sh.slice_ctb_addr_rs, s->sh.num_entry_point_offsets,
-            sps->ctb_width, sps->ctb_height
-        );
-        return AVERROR_INVALIDDATA;
-    }
-
-    if (s->avctx->thread_count > s->nb_local_ctx) {
-        HEVCLocalContext *tmp = av_malloc_array(s->avctx->thread_count, sizeof(*s->local_ctx));
+    if (count > s->nb_local_ctx) {
+        HEVCLocalContext *tmp = av_malloc_array(count, sizeof(*s->local_ctx));
 
         if (!tmp)
             return AVERROR(ENOMEM);
@@ -2952,7 +3015,7 @@ static int hls_slice_data_wpp(HEVCContext *s, const H2645NAL *nal)
         av_free(s->local_ctx);
         s->local_ctx = tmp;
 
-        for (unsigned i = s->nb_local_ctx; i < s->avctx->thread_count; i++) {
+        for (unsigned i = s->nb_local_ctx; i < count; i++) {
             tmp = &s->local_ctx[i];
 
             memset(tmp, 0, sizeof(*tmp));
@@ -2962,9 +3025,35 @@ static int hls_slice_data_wpp(HEVCContext *s, const H2645NAL *nal)
             tmp->common_cabac_state = &s->cabac;
         }
 
-        s->nb_local_ctx = s->avctx->thread_count;
+        s->nb_local_ctx = count;
     }
 
+    return 0;
+}
+
+static int hls_slice_data_wpp(HEVCContext *s, const H2645NAL *nal)
+{
+    const HEVCPPS *const pps = s->pps;
+    const HEVCSPS *const sps = pps->sps;
+    const uint8_t *data = nal->data;
+    int length          = nal->size;
+    int *ret;
+    int64_t offset;
+    int64_t startheader, cmpt = 0;
+    int i, j, res = 0;
+
+    if (s->sh.slice_ctb_addr_rs + s->sh.num_entry_point_offsets * sps->ctb_width >= sps->ctb_width * sps->ctb_height) {
+        av_log(s->avctx, AV_LOG_ERROR, "WPP ctb addresses are wrong (%d %d %d %d)\n",
+            s->sh.slice_ctb_addr_rs, s->sh.num_entry_point_offsets,
+            sps->ctb_width, sps->ctb_height
+        );
+        return AVERROR_INVALIDDATA;
+    }
+
+    res = local_ctx_alloc(s, s->avctx->thread_count);
+    if (res < 0)
+        return res;
+
     offset = s->sh.data_offset;
 
     for (j = 0, cmpt = 0, startheader = offset + s->sh.entry_point_offset[0]; j < nal->skipped_bytes; j++) {
@@ -3025,6 +3114,31 @@ static int hls_slice_data_wpp(HEVCContext *s, const H2645NAL *nal)
     return res;
 }
 
+static int hls_decode_entry_pipelined(HEVCContext *s, GetBitContext *gb)
+{
+    LoopFilterPipeline lfp = {
+        .s              = s,
+        .gb             = gb,
+        .ctb_addr_start = s->pps->ctb_addr_rs_to_ts[s->sh.slice_ctb_addr_rs],
+    };
+    int ret[2], res;
+
+    res = local_ctx_alloc(s, 2);
+    if (res < 0)
+        return res;
+
+    res = wpp_progress_init(s, 1);
+    if (res < 0)
+        return res;
+
+    lfp.progress = &s->wpp_progress[0];
+    atomic_init(&lfp.ctb_addr_end, INT_MAX);
+
+    s->avctx->execute2(s->avctx, hls_decode_entry_pipelined_job, &lfp, ret, 2);
+
+    return ret[0];
+}
+
 static int decode_slice_data(HEVCContext *s, const HEVCLayerContext *l,
                              const H2645NAL *nal, GetBitContext *gb)
 {
@@ -3071,12 +3185,18 @@ static int decode_slice_data(HEVCContext *s, const HEVCLayerContext *l,
     s->local_ctx[0].tu.cu_qp_offset_cb = 0;
     s->local_ctx[0].tu.cu_qp_offset_cr = 0;
 
-    if (s->avctx->active_thread_type == FF_THREAD_SLICE  &&
+    if (s->avctx->active_thread_type & FF_THREAD_SLICE &&
         s->sh.num_entry_point_offsets > 0                &&
         pps->num_tile_rows == 1 && pps->num_tile_columns == 1)
         return hls_slice_data_wpp(s, nal);
 
-    return hls_decode_entry(s, gb);
+    /* Without WPP or tiles the slice threads would be idle, so let one
+     * of them do the loop filtering behind the entropy decoder. */
+    if (s->avctx->active_thread_type & FF_THREAD_SLICE &&
+        !pps->tiles_enabled_flag)
+        return hls_decode_entry_pipelined(s, gb);
+
+    return hls_decode_entry(s, gb, NULL);
 }
 
 static int set_side_data(HEVCContext *s)
@@ -3563,7 +3683,7 @@ static int decode_slice(HEVCContext *s, unsigned nal_idx, GetBitContext *gb)
     // switching to a new layer, mark previous layer's frame (if any) as done
     if (s->cur_layer != layer_idx &&
         s->layers[s->cur_layer].cur_frame &&
-        s->avctx->active_thread_type == FF_THREAD_FRAME)
+        s->avctx->active_thread_type & FF_THREAD_FRAME)
         ff_progress_frame_report(&s->layers[s->cur_layer].cur_frame->tf, INT_MAX);
 
     s->cur_layer = layer_idx;
@@ -3792,7 +3912,7 @@ fail:
         if (ret >= 0)
             ret = hevc_frame_end(s, l);
 
-        if (s->avctx->active_thread_type == FF_THREAD_FRAME)
+        if (s->avctx->active_thread_type & FF_THREAD_FRAME)
             ff_progress_frame_report(&l->cur_frame->tf, INT_MAX);
     }
 
@@ -4251,6 +4371,7 @@ const FFCodec ff_hevc_decoder = {
                              AV_CODEC_CAP_SLICE_THREADS | AV_CODEC_CAP_FRAME_THREADS,
     .caps_internal         = FF_CODEC_CAP_EXPORTS_CROPPING |
                              FF_CODEC_CAP_USES_PROGRESSFRAMES |
+                             FF_CODEC_CAP_FRAME_SLICE_THREADS |
                              FF_CODEC_CAP_INIT_CLEANUP,
     .p.profiles            = NULL_IF_CONFIG_SMALL(ff_hevc_profiles),
     .hw_configs            = (const AVCodecHWConfigInternal *const []) {
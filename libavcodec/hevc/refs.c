@@ -487,7 +487,7 @@ static HEVCFrame *generate_missing_ref(HEVCContext *s, HEVCLayerContext *l, int
     frame->poc      = poc;
     frame->flags    = HEVC_FRAME_FLAG_UNAVAILABLE;
 
-    if (s->avctx->active_thread_type == FF_THREAD_FRAME)
+    if (s->avctx->active_thread_type & FF_THREAD_FRAME)
         ff_progress_frame_report(&frame->tf, INT_MAX);
 
     return frame;
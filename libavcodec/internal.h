@@ -50,6 +50,8 @@ typedef struct AVCodecInternal {
     /**
      * When using frame-threaded decoding, this field is set for the first
      * worker thread (e.g. to decode extradata just once).
+     * When using frame-threaded encoding, it is set for all worker contexts;
+     * their frame_num is then the index of the frame being encoded.
      */
     int is_copy;
 
@@ -110,6 +110,13 @@ typedef struct {
    double *layer_rates;
 } Jpeg2000Tile;
 
+/** a row of codeblocks of one band, the unit of parallel tier-1 coding */
+typedef struct {
+    uint16_t tileno;
+    uint8_t compno, reslevelno, bandno;
+    int cblky;
+} Jpeg2000CblkRow;
+
 typedef struct {
     AVClass *class;
     AVCodecContext *avctx;
@@ -135,6 +142,9 @@ typedef struct {
     Jpeg2000QuantStyle  qntsty;
 
     Jpeg2000Tile *tile;
+    Jpeg2000CblkRow *cblk_rows;
+    int nb_cblk_rows;
+    int *job_ret;
     int layer_rates[100];
     uint8_t compression_rate_enc; ///< Is compression done using compression ratio?
 
@@ -379,6 +389,65 @@ static void compute_rates(Jpeg2000EncoderContext* s)
 
 }
 
+/**
+ * allocate the codeblock buffers and list the rows of codeblocks of
+ * all tiles, which are tier-1 coded in parallel
+ */
+static int init_cblk_rows(Jpeg2000EncoderContext *s)
+{
+    Jpeg2000CodingStyle *codsty = &s->codsty;
+    Jpeg2000CblkRow *row = NULL;
+
+    for (int pass = 0; pass < 2; pass++) {
+        for (int tileno = 0; tileno < s->numXtiles * s->numYtiles; tileno++)
+            for (int compno = 0; compno < s->ncomponents; compno++) {
+                Jpeg2000Component *comp = s->tile[tileno].comp + compno;
+
+                for (int reslevelno = 0; reslevelno < codsty->nreslevels; reslevelno++) {
+                    Jpeg2000ResLevel *reslevel = comp->reslevel + reslevelno;
+
+                    for (int bandno = 0; bandno < reslevel->nbands; bandno++) {
+                        Jpeg2000Band *band = reslevel->band + bandno;
+                        Jpeg2000Prec *prec = band->prec;
+
+                        if (band->coord[0][0] == band->coord[0][1] || band->coord[1][0] == band->coord[1][1])
+                            continue;
+
+                        if (!row) {
+                            s->nb_cblk_rows += prec->nb_codeblocks_height;
+                            continue;
+                        }
+
+                        for (int cblky = 0; cblky < prec->nb_codeblocks_height; cblky++, row++) {
+                            row->tileno     = tileno;
+                            row->compno     = compno;
+                            row->reslevelno = reslevelno;
+                            row->bandno     = bandno;
+                            row->cblky      = cblky;
+                        }
+
+                        for (int cblkno = 0; cblkno < prec->nb_codeblocks_width * prec->nb_codeblocks_height; cblkno++) {
+                            Jpeg2000Cblk *cblk = prec->cblk + cblkno;
+
+                            cblk->data   = av_malloc(1 + 8192);
+                            cblk->passes = av_malloc_array(JPEG2000_MAX_PASSES, sizeof(*cblk->passes));
+                            if (!cblk->data || !cblk->passes)
+                                return AVERROR(ENOMEM);
+                        }
+                    }
+                }
+            }
+
+        if (!pass) {
+            row = s->cblk_rows = av_malloc_array(s->nb_cblk_rows + 1, sizeof(*s->cblk_rows));
+            if (!s->cblk_rows)
+                return AVERROR(ENOMEM);
+        }
+    }
+
+    return 0;
+}
+
 /**
  * compute the sizes of tiles, resolution levels, bands, etc.
  * allocate memory for them
@@ -386,7 +455,7 @@ static void compute_rates(Jpeg2000EncoderContext* s)
  */
 static int init_tiles(Jpeg2000EncoderContext *s)
 {
-    int tileno, tilex, tiley, compno;
+    int tileno, tilex, tiley, compno, ret;
     Jpeg2000CodingStyle *codsty = &s->codsty;
     Jpeg2000QuantStyle  *qntsty = &s->qntsty;
 
@@ -410,7 +479,7 @@ static int init_tiles(Jpeg2000EncoderContext *s)
 
             for (compno = 0; compno < s->ncomponents; compno++){
                 Jpeg2000Component *comp = tile->comp + compno;
-                int ret, i, j;
+                int i, j;
 
                 comp->coord[0][0] = comp->coord_o[0][0] = tilex * s->tile_width;
                 comp->coord[0][1] = comp->coord_o[0][1] = FFMIN((tilex+1)*s->tile_width, s->width);
@@ -432,6 +501,14 @@ static int init_tiles(Jpeg2000EncoderContext *s)
                     return ret;
             }
         }
+
+    if ((ret = init_cblk_rows(s)) < 0)
+        return ret;
+
+    s->job_ret = av_calloc(s->numXtiles * s->numYtiles, s->ncomponents * sizeof(*s->job_ret));
+    if (!s->job_ret)
+        return AVERROR(ENOMEM);
+
     compute_rates(s);
     return 0;
 }
@@ -1333,84 +1410,106 @@ static void truncpasses(Jpeg2000EncoderContext *s, Jpeg2000Tile *tile)
     }
 }
 
-static int encode_tile(Jpeg2000EncoderContext *s, Jpeg2000Tile *tile, int tileno)
+static int dwt_tile_comp(AVCodecContext *avctx, void *td, int jobnr, int threadnr)
 {
-    int compno, reslevelno, bandno, ret;
-    Jpeg2000T1Context t1;
-    Jpeg2000CodingStyle *codsty = &s->codsty;
-    for (compno = 0; compno < s->ncomponents; compno++){
-        Jpeg2000Component *comp = s->tile[tileno].comp + compno;
+    Jpeg2000EncoderContext *s = avctx->priv_data;
+    Jpeg2000Component *comp = s->tile[jobnr / s->ncomponents].comp + jobnr % s->ncomponents;
 
-        t1.stride = (1<<codsty->log2_cblk_width) + 2;
+    return ff_dwt_encode(&comp->dwt, comp->i_data);
+}
 
-        av_log(s->avctx, AV_LOG_DEBUG,"dwt\n");
-        if ((ret = ff_dwt_encode(&comp->dwt, comp->i_data)) < 0)
-            return ret;
-        av_log(s->avctx, AV_LOG_DEBUG,"after dwt -> tier1\n");
+/**
+ * Get the range of the cblkno-th codeblock along one dimension of a band,
+ * relative to the start of the component's coefficients.
+ */
+static void get_cblk_range(const Jpeg2000Band *band, int dim, int origin, int log2_size,
+                           int cblkno, int *start, int *end)
+{
+    const int band_end = band->coord[dim][1] - band->coord[dim][0] + origin;
+    const int first_end = FFMIN(ff_jpeg2000_ceildivpow2(band->coord[dim][0] + 1, log2_size) << log2_size,
+                                band->coord[dim][1]) - band->coord[dim][0] + origin;
 
-        for (reslevelno = 0; reslevelno < codsty->nreslevels; reslevelno++){
-            Jpeg2000ResLevel *reslevel = comp->reslevel + reslevelno;
+    *start = cblkno ? first_end + ((cblkno - 1) << log2_size) : origin;
+    *end   = cblkno ? FFMIN(*start + (1 << log2_size), band_end) : first_end;
+}
 
-            for (bandno = 0; bandno < reslevel->nbands ; bandno++){
-                Jpeg2000Band *band = reslevel->band + bandno;
-                Jpeg2000Prec *prec = band->prec; // we support only 1 precinct per band ATM in the encoder
-                int cblkx, cblky, cblkno=0, xx0, x0, xx1, y0, yy0, yy1, bandpos;
-                yy0 = bandno == 0 ? 0 : comp->reslevel[reslevelno-1].coord[1][1] - comp->reslevel[reslevelno-1].coord[1][0];
-                y0 = yy0;
-                yy1 = FFMIN(ff_jpeg2000_ceildivpow2(band->coord[1][0] + 1, band->log2_cblk_height) << band->log2_cblk_height,
-                            band->coord[1][1]) - band->coord[1][0] + yy0;
+static int encode_cblk_row(AVCodecContext *avctx, void *td, int jobnr, int threadnr)
+{
+    Jpeg2000EncoderContext *s = avctx->priv_data;
+    const Jpeg2000CblkRow *row = &s->cblk_rows[jobnr];
+    Jpeg2000CodingStyle *codsty = &s->codsty;
+    Jpeg2000Tile *tile = s->tile + row->tileno;
+    Jpeg2000Component *comp = tile->comp + row->compno;
+    const int reslevelno = row->reslevelno, bandno = row->bandno;
+    Jpeg2000Band *band = comp->reslevel[reslevelno].band + bandno;
+    Jpeg2000Prec *prec = band->prec; // we support only 1 precinct per band ATM in the encoder
+    const int bandpos = bandno + (reslevelno > 0);
+    int cblkno = row->cblky * prec->nb_codeblocks_width;
+    int x0, y0, xx0, xx1, yy0, yy1;
+    Jpeg2000T1Context t1;
 
-                if (band->coord[0][0] == band->coord[0][1] || band->coord[1][0] == band->coord[1][1])
-                    continue;
+    t1.stride = (1<<codsty->log2_cblk_width) + 2;
 
-                bandpos = bandno + (reslevelno > 0);
-
-                for (cblky = 0; cblky < prec->nb_codeblocks_height; cblky++){
-                    if (reslevelno == 0 || bandno == 1)
-                        xx0 = 0;
-                    else
-                        xx0 = comp->reslevel[reslevelno-1].coord[0][1] - comp->reslevel[reslevelno-1].coord[0][0];
-                    x0 = xx0;
-                    xx1 = FFMIN(ff_jpeg2000_ceildivpow2(band->coord[0][0] + 1, band->log2_cblk_width) << band->log2_cblk_width,
-                                band->coord[0][1]) - band->coord[0][0] + xx0;
-
-                    for (cblkx = 0; cblkx < prec->nb_codeblocks_width; cblkx++, cblkno++){
-                        int y, x;
-                        if (codsty->transform == FF_DWT53){
-                            for (y = yy0; y < yy1; y++){
-                                int *ptr = t1.data + (y-yy0)*t1.stride;
-                                for (x = xx0; x < xx1; x++){
-                                    *ptr++ = comp->i_data[(comp->coord[0][1] - comp->coord[0][0]) * y + x] * (1 << NMSEDEC_FRACBITS);
-                                }
-                            }
-                        } else{
-                            for (y = yy0; y < yy1; y++){
-                                int *ptr = t1.data + (y-yy0)*t1.stride;
-                                for (x = xx0; x < xx1; x++){
-                                    *ptr = (comp->i_data[(comp->coord[0][1] - comp->coord[0][0]) * y + x]);
-                                    *ptr = (int64_t)*ptr * (int64_t)(16384 * 65536 / band->i_stepsize) >> 15 - NMSEDEC_FRACBITS;
-                                    ptr++;
-                                }
-                            }
-                        }
-                        if (!prec->cblk[cblkno].data)
-                            prec->cblk[cblkno].data = av_malloc(1 + 8192);
-                        if (!prec->cblk[cblkno].passes)
-                            prec->cblk[cblkno].passes = av_malloc_array(JPEG2000_MAX_PASSES, sizeof (*prec->cblk[cblkno].passes));
-                        if (!prec->cblk[cblkno].data || !prec->cblk[cblkno].passes)
-                            return AVERROR(ENOMEM);
-                        encode_cblk(s, &t1, prec->cblk + cblkno, tile, xx1 - xx0, yy1 - yy0,
-                                    bandpos, codsty->nreslevels - reslevelno - 1);
-                        xx0 = xx1;
-                        xx1 = FFMIN(xx1 + (1 << band->log2_cblk_width), band->coord[0][1] - band->coord[0][0] + x0);
-                    }
-                    yy0 = yy1;
-                    yy1 = FFMIN(yy1 + (1 << band->log2_cblk_height), band->coord[1][1] - band->coord[1][0] + y0);
+    y0 = bandno == 0 ? 0 : comp->reslevel[reslevelno-1].coord[1][1] - comp->reslevel[reslevelno-1].coord[1][0];
+    if (reslevelno == 0 || bandno == 1)
+        x0 = 0;
+    else
+        x0 = comp->reslevel[reslevelno-1].coord[0][1] - comp->reslevel[reslevelno-1].coord[0][0];
+
+    get_cblk_range(band, 1, y0, band->log2_cblk_height, row->cblky, &yy0, &yy1);
+
+    for (int cblkx = 0; cblkx < prec->nb_codeblocks_width; cblkx++, cblkno++){
+        int y, x;
+
+        get_cblk_range(band, 0, x0, band->log2_cblk_width, cblkx, &xx0, &xx1);
+        if (codsty->transform == FF_DWT53){
+            for (y = yy0; y < yy1; y++){
+                int *ptr = t1.data + (y-yy0)*t1.stride;
+                for (x = xx0; x < xx1; x++){
+                    *ptr++ = comp->i_data[(comp->coord[0][1] - comp->coord[0][0]) * y + x] * (1 << NMSEDEC_FRACBITS);
+                }
+            }
+        } else{
+            for (y = yy0; y < yy1; y++){
+                int *ptr = t1.data + (y-yy0)*t1.stride;
+                for (x = xx0; x < xx1; x++){
+                    *ptr = (comp->i_data[(comp->coord[0][1] - comp->coord[0][0]) * y + x]);
+                    *ptr = (int64_t)*ptr * (int64_t)(16384 * 65536 / band->i_stepsize) >> 15 - NMSEDEC_FRACBITS;
+                    ptr++;
                 }
             }
         }
-        av_log(s->avctx, AV_LOG_DEBUG, "after tier1\n");
+        encode_cblk(s, &t1, prec->cblk + cblkno, tile, xx1 - xx0, yy1 - yy0,
+                    bandpos, codsty->nreslevels - reslevelno - 1);
     }
+    return 0;
+}
+
+/**
+ * Run the DWT and tier-1 coding of all tiles. Tile-components are
+ * transformed in parallel, then rows of codeblocks are coded in parallel.
+ */
+static int encode_tiles_tier1(Jpeg2000EncoderContext *s)
+{
+    AVCodecContext *avctx = s->avctx;
+    const int nb_tile_comps = s->numXtiles * s->numYtiles * s->ncomponents;
+
+    av_log(s->avctx, AV_LOG_DEBUG,"dwt\n");
+    avctx->execute2(avctx, dwt_tile_comp, NULL, s->job_ret, nb_tile_comps);
+    for (int i = 0; i < nb_tile_comps; i++)
+        if (s->job_ret[i] < 0)
+            return s->job_ret[i];
+
+    av_log(s->avctx, AV_LOG_DEBUG,"after dwt -> tier1\n");
+    avctx->execute2(avctx, encode_cblk_row, NULL, NULL, s->nb_cblk_rows);
+    av_log(s->avctx, AV_LOG_DEBUG, "after tier1\n");
+
+    return 0;
+}
+
+static int encode_tile(Jpeg2000EncoderContext *s, Jpeg2000Tile *tile, int tileno)
+{
+    int ret;
 
     av_log(s->avctx, AV_LOG_DEBUG, "rate control\n");
     if (s->compression_rate_enc)
@@ -1442,6 +1541,8 @@ static void cleanup(Jpeg2000EncoderContext *s)
         av_freep(&s->tile[tileno].layer_rates);
     }
     av_freep(&s->tile);
+    av_freep(&s->cblk_rows);
+    av_freep(&s->job_ret);
 }
 
 static void reinit(Jpeg2000EncoderContext *s)
@@ -1573,6 +1674,9 @@ static int encode_frame(AVCodecContext *avctx, AVPacket *pkt,
     if ((ret = put_com(s, 0)) < 0)
         return ret;
 
+    if ((ret = encode_tiles_tier1(s)) < 0)
+        return ret;
+
     for (tileno = 0; tileno < s->numXtiles * s->numYtiles; tileno++){
         uint8_t *psotptr;
         if (!(psotptr = put_sot(s, tileno)))
@@ -1771,7 +1875,7 @@ const FFCodec ff_jpeg2000_encoder = {
     .p.type         = AVMEDIA_TYPE_VIDEO,
     .p.id           = AV_CODEC_ID_JPEG2000,
     .p.capabilities = AV_CODEC_CAP_DR1 | AV_CODEC_CAP_ENCODER_REORDERED_OPAQUE |
-                      AV_CODEC_CAP_FRAME_THREADS,
+                      AV_CODEC_CAP_FRAME_THREADS | AV_CODEC_CAP_SLICE_THREADS,
     .priv_data_size = sizeof(Jpeg2000EncoderContext),
     .init           = j2kenc_init,
     FF_CODEC_ENCODE_CB(encode_frame),
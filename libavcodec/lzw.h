@@ -57,5 +57,6 @@ void ff_lzw_encode_init(struct LZWEncodeState *s, uint8_t *outbuf, int outsize,
                         int maxbits, enum FF_LZW_MODES mode, int little_endian);
 int ff_lzw_encode(struct LZWEncodeState * s, const uint8_t * inbuf, int insize);
 int ff_lzw_encode_flush(struct LZWEncodeState *s);
+int ff_lzw_encode_flush_clear(struct LZWEncodeState *s);
 
 #endif /* AVCODEC_LZW_H */
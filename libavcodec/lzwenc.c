@@ -280,3 +280,33 @@ int ff_lzw_encode_flush(LZWEncodeState *s)
 
     return writtenBytes(s);
 }
+
+/**
+ * Write clear code and flush bitstream, so that another code stream can be
+ * appended to the written bits
+ * @param s LZW state
+ * @return Number of bits written, excluding the flush padding
+ */
+int ff_lzw_encode_flush_clear(LZWEncodeState *s)
+{
+    int bits;
+
+    if (s->last_code != -1) {
+        writeCode(s, s->last_code);
+        /* the decoder adds a code for the last one and may grow its code
+         * size, unlike the encoder which only does so on the next code */
+        if (s->tabsize + (s->mode == FF_LZW_TIFF) >= 1 << s->bits &&
+            s->bits < s->maxbits)
+            s->bits++;
+    }
+    writeCode(s, s->clear_code);
+    bits = put_bits_count(&s->pb);
+    if (s->little_endian)
+        flush_put_bits_le(&s->pb);
+    else
+        flush_put_bits(&s->pb);
+    s->last_code = -1;
+    writtenBytes(s);
+
+    return bits;
+}
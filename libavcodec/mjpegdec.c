@@ -53,6 +53,7 @@
 #include "jpeglsdec.h"
 #include "profiles.h"
 #include "put_bits.h"
+#include "thread.h"
 
 
 static void mjpeg_find_raw_scan_data(MJpegDecodeContext *s,
@@ -147,6 +148,12 @@ av_cold int ff_mjpeg_decode_init(AVCodecContext *avctx)
     if ((ret = init_default_huffman_tables(s)) < 0)
         return ret;
 
+    if (avctx->active_thread_type & FF_THREAD_SLICE) {
+        s->slice_ctx = av_calloc(avctx->thread_count, sizeof(*s->slice_ctx));
+        if (!s->slice_ctx)
+            return AVERROR(ENOMEM);
+    }
+
 #if FF_API_MJPEG_EXTERN_HUFF
     if (s->extern_huff && avctx->extradata) {
         av_log(avctx, AV_LOG_INFO, "using external huffman table\n");
@@ -835,41 +842,43 @@ int ff_mjpeg_decode_sof(MJpegDecodeContext *s)
     return 0;
 }
 
-static inline int mjpeg_decode_dc(MJpegDecodeContext *s, int dc_index, int *val)
+static inline int mjpeg_decode_dc(MJpegDecodeContext *s, GetBitContext *gb,
+                                  int dc_index, int *val)
 {
     int code;
-    code = get_vlc2(&s->gb, s->vlcs[0][dc_index].table, 9, 2);
+    code = get_vlc2(gb, s->vlcs[0][dc_index].table, 9, 2);
     if (code < 0 || code > 16) {
         av_log(s->avctx, AV_LOG_ERROR,
                "mjpeg_decode_dc: bad vlc: %d\n", dc_index);
         return AVERROR_INVALIDDATA;
     }
 
-    *val = code ? get_xbits(&s->gb, code) : 0;
+    *val = code ? get_xbits(gb, code) : 0;
     return 0;
 }
 
 /* decode block and dequantize */
-static int decode_block(MJpegDecodeContext *s, int16_t *block, int component,
+static int decode_block(MJpegDecodeContext *s, GetBitContext *gb,
+                        int16_t *block, int *last_dc,
                         int dc_index, int ac_index, uint16_t *quant_matrix)
 {
     int code, i, j, level, val;
 
     /* DC coef */
-    int ret = mjpeg_decode_dc(s, dc_index, &val);
+    int ret = mjpeg_decode_dc(s, gb, dc_index, &val);
     if (ret < 0)
         return ret;
 
-    val = val * (unsigned)quant_matrix[0] + s->last_dc[component];
-    s->last_dc[component] = val;
+    val = val * (unsigned)quant_matrix[0] + *last_dc;
+    *last_dc = val;
     block[0] = av_clip_int16(val);
     /* AC coefs */
     i = 0;
     {
-        OPEN_READER(re, &s->gb);
+        OPEN_READER(re, gb);
         do {
-            UPDATE_CACHE(re, &s->gb);
-            GET_VLC(code, re, &s->gb, s->vlcs[1][ac_index].table, 9, 2);
+            UPDATE_CACHE(re, gb);
+            GET_VLC(code, re, gb, s->vlcs[1][ac_index].table, 9, 2);
 
             i += ((unsigned)code) >> 4;
             code &= 0xf;
@@ -878,12 +887,12 @@ static int decode_block(MJpegDecodeContext *s, int16_t *block, int component,
                 // So we have at least MIN_CACHE_BITS - 9 > 15 bits left here
                 // and don't need to refill the cache.
                 {
-                    int cache = GET_CACHE(re, &s->gb);
+                    int cache = GET_CACHE(re, gb);
                     int sign  = (~cache) >> 31;
                     level     = (NEG_USR32(sign ^ cache,code) ^ sign) - sign;
                 }
 
-                LAST_SKIP_BITS(re, &s->gb, code);
+                LAST_SKIP_BITS(re, gb, code);
 
                 if (i > 63) {
                     av_log(s->avctx, AV_LOG_ERROR, "error count: %d\n", i);
@@ -893,7 +902,7 @@ static int decode_block(MJpegDecodeContext *s, int16_t *block, int component,
                 block[j] = level * quant_matrix[i];
             }
         } while (i < 63);
-        CLOSE_READER(re, &s->gb);
+        CLOSE_READER(re, gb);
     }
 
     return 0;
@@ -905,7 +914,7 @@ static int decode_dc_progressive(MJpegDecodeContext *s, int16_t *block,
 {
     unsigned val;
     s->bdsp.clear_block(block);
-    int ret = mjpeg_decode_dc(s, dc_index, &val);
+    int ret = mjpeg_decode_dc(s, &s->gb, dc_index, &val);
     if (ret < 0)
         return ret;
 
@@ -1166,7 +1175,7 @@ static int ljpeg_decode_rgb_scan(MJpegDecodeContext *s)
                 topleft[i] = top[i];
                 top[i]     = buffer[mb_x][i];
 
-                ret = mjpeg_decode_dc(s, s->dc_index[i], &dc);
+                ret = mjpeg_decode_dc(s, &s->gb, s->dc_index[i], &dc);
                 if (ret < 0)
                     return ret;
 
@@ -1304,7 +1313,7 @@ static int ljpeg_decode_yuv_scan(MJpegDecodeContext *s)
                     for (j = 0; j < n; j++) {
                         int pred, dc;
 
-                        ret = mjpeg_decode_dc(s, s->dc_index[i], &dc);
+                        ret = mjpeg_decode_dc(s, &s->gb, s->dc_index[i], &dc);
                         if (ret < 0)
                             return ret;
 
@@ -1376,7 +1385,7 @@ static int ljpeg_decode_yuv_scan(MJpegDecodeContext *s)
                     for (j = 0; j < n; j++) {
                         int pred;
 
-                        ret = mjpeg_decode_dc(s, s->dc_index[i], &dc);
+                        ret = mjpeg_decode_dc(s, &s->gb, s->dc_index[i], &dc);
                         if (ret < 0)
                             return ret;
 
@@ -1442,6 +1451,218 @@ static void shift_output(MJpegDecodeContext *s, uint8_t *ptr, int linesize)
     }
 }
 
+/**
+ * Locate the entropy-coded data of each restart interval of the current scan.
+ *
+ * @param pend set to the position after the data of the last interval, where
+ *             ff_mjpeg_unescape_sos() would leave the byte reader
+ * @return the number of intervals found (at most nb_intervals), or a
+ *         negative error code
+ */
+static int mjpeg_find_restart_intervals(MJpegDecodeContext *s, int nb_intervals,
+                                        const uint8_t **pend)
+{
+    const uint8_t *buf_end = s->gB.buffer_end;
+    const uint8_t *start   = s->gB.buffer;
+    const uint8_t *ptr     = start;
+    int n = 0;
+
+    av_fast_malloc(&s->restart_intervals, &s->restart_intervals_size,
+                   nb_intervals * sizeof(*s->restart_intervals));
+    if (!s->restart_intervals)
+        return AVERROR(ENOMEM);
+
+    while (n < nb_intervals && (ptr = memchr(ptr, 0xff, buf_end - ptr))) {
+        const uint8_t *marker = ptr++;
+        uint8_t x;
+
+        if (ptr >= buf_end)
+            break;
+
+        x = *ptr++;
+        /* Discard multiple optional 0xFF fill bytes. */
+        while (x == 0xff && ptr < buf_end)
+            x = *ptr++;
+        /* Stuffed zero byte */
+        if (!x)
+            continue;
+
+        s->restart_intervals[n].buf  = start;
+        s->restart_intervals[n].size = marker - start;
+        n++;
+
+        if (x < RST0 || x > RST7) {
+            /* Non-restart marker */
+            ptr -= 2;
+            break;
+        }
+        start = ptr;
+    }
+    if (!ptr || ptr >= buf_end) {
+        /* The last interval extends to the end of the buffer. */
+        ptr = buf_end;
+        if (n < nb_intervals) {
+            s->restart_intervals[n].buf  = start;
+            s->restart_intervals[n].size = buf_end - start;
+            n++;
+        }
+    }
+
+    *pend = ptr;
+    return n;
+}
+
+static int mjpeg_unescape_restart_interval(MJpegSliceContext *sc,
+                                           const MJpegRestartInterval *ri)
+{
+    const uint8_t *src = ri->buf;
+    const uint8_t *end = ri->buf + ri->size;
+    const uint8_t *ptr;
+    uint8_t *dst;
+
+    av_fast_padded_malloc(&sc->buffer, &sc->buffer_size, ri->size);
+    if (!sc->buffer)
+        return AVERROR(ENOMEM);
+    dst = sc->buffer;
+
+    /* The interval contains no markers, only stuffed zero bytes. */
+    while ((ptr = memchr(src, 0xff, end - src))) {
+        ptr++;
+        memcpy(dst, src, ptr - src);
+        dst += ptr - src;
+        /* Discard multiple optional 0xFF fill bytes and the zero byte. */
+        while (ptr < end && *ptr == 0xff)
+            ptr++;
+        if (ptr < end)
+            ptr++;
+        src = ptr;
+    }
+    memcpy(dst, src, end - src);
+    dst += end - src;
+    memset(dst, 0, AV_INPUT_BUFFER_PADDING_SIZE);
+
+    return init_get_bits8(&sc->gb, sc->buffer, dst - sc->buffer);
+}
+
+static int mjpeg_decode_restart_interval(AVCodecContext *avctx, void *arg,
+                                         int jobnr, int threadnr)
+{
+    MJpegDecodeContext *s = avctx->priv_data;
+    MJpegSliceContext *sc = &s->slice_ctx[threadnr];
+    int nb_components     = s->nb_components_sos;
+    int bytes_per_pixel   = 1 + (s->bits > 8);
+    int mcu               = jobnr * s->restart_interval;
+    int mcu_end           = FFMIN(mcu + s->restart_interval,
+                                  s->mb_width * s->mb_height);
+    int chroma_h_shift, chroma_v_shift, chroma_width, chroma_height;
+    int ret;
+
+    ret = mjpeg_unescape_restart_interval(sc, &s->restart_intervals[jobnr]);
+    if (ret < 0) {
+        sc->errors++;
+        return ret;
+    }
+
+    av_pix_fmt_get_chroma_sub_sample(avctx->pix_fmt, &chroma_h_shift,
+                                     &chroma_v_shift);
+    chroma_width  = AV_CEIL_RSHIFT(s->width,  chroma_h_shift);
+    chroma_height = AV_CEIL_RSHIFT(s->height, chroma_v_shift);
+
+    for (int i = 0; i < nb_components; i++)
+        sc->last_dc[i] = (4 << s->bits);
+
+    for (; mcu < mcu_end; mcu++) {
+        int mb_x = mcu % s->mb_width;
+        int mb_y = mcu / s->mb_width;
+
+        if (get_bits_left(&sc->gb) < 0) {
+            av_log(avctx, AV_LOG_ERROR, "overread %d\n",
+                   -get_bits_left(&sc->gb));
+            sc->errors++;
+            return AVERROR_INVALIDDATA;
+        }
+        for (int i = 0; i < nb_components; i++) {
+            int c        = s->comp_index[i];
+            int h        = s->h_scount[i];
+            int v        = s->v_scount[i];
+            int linesize = s->linesize[c];
+            int x = 0, y = 0;
+
+            for (int j = 0; j < s->nb_blocks[i]; j++) {
+                int block_offset = (((linesize * (v * mb_y + y) * 8) +
+                                     (h * mb_x + x) * 8 * bytes_per_pixel) >> avctx->lowres);
+
+                if (s->interlaced && s->bottom_field)
+                    block_offset += linesize >> 1;
+
+                s->bdsp.clear_block(sc->block);
+                if (decode_block(s, &sc->gb, sc->block, &sc->last_dc[i],
+                                 s->dc_index[i], s->ac_index[i],
+                                 s->quant_matrixes[s->quant_sindex[i]]) < 0) {
+                    av_log(avctx, AV_LOG_ERROR,
+                           "error y=%d x=%d\n", mb_y, mb_x);
+                    sc->errors++;
+                    return AVERROR_INVALIDDATA;
+                }
+                if (   8 * (h * mb_x + x) < ((c == 1) || (c == 2) ? chroma_width  : s->width)
+                    && 8 * (v * mb_y + y) < ((c == 1) || (c == 2) ? chroma_height : s->height)
+                    && linesize) {
+                    uint8_t *ptr = s->picture_ptr->data[c] + block_offset;
+                    s->idsp.idct_put(ptr, linesize, sc->block);
+                    if (s->bits & 7)
+                        shift_output(s, ptr, linesize);
+                }
+                if (++x == h) {
+                    x = 0;
+                    y++;
+                }
+            }
+        }
+    }
+    return 0;
+}
+
+/**
+ * Decode the restart intervals of a sequential scan in parallel.
+ *
+ * @return 1 if the scan was decoded, 0 if it has to be decoded serially,
+ *         or a negative error code
+ */
+static int mjpeg_decode_scan_threaded(MJpegDecodeContext *s)
+{
+    AVCodecContext *avctx = s->avctx;
+    int nb_mcus      = s->mb_width * s->mb_height;
+    int nb_intervals = (nb_mcus + s->restart_interval - 1) / s->restart_interval;
+    const uint8_t *scan_end;
+    int ret, errors = 0;
+
+    if (nb_intervals < 2)
+        return 0;
+
+    ret = mjpeg_find_restart_intervals(s, nb_intervals, &scan_end);
+    if (ret < 0)
+        return ret;
+    /* Restart markers are missing, let the serial decoder deal with it. */
+    if (ret < nb_intervals)
+        return 0;
+
+    avctx->execute2(avctx, mjpeg_decode_restart_interval, NULL, NULL,
+                    nb_intervals);
+
+    bytestream2_skipu(&s->gB, scan_end - s->gB.buffer);
+
+    for (int i = 0; i < avctx->thread_count; i++) {
+        errors += s->slice_ctx[i].errors;
+        s->slice_ctx[i].errors = 0;
+    }
+    if (errors) {
+        av_log(avctx, AV_LOG_ERROR, "%d restart intervals with errors\n", errors);
+        return AVERROR_INVALIDDATA;
+    }
+
+    return 1;
+}
+
 static int mjpeg_decode_scan(MJpegDecodeContext *s)
 {
     int nb_components = s->nb_components_sos;
@@ -1484,6 +1705,14 @@ static int mjpeg_decode_scan(MJpegDecodeContext *s)
     }
 
 next_field:
+    if (s->slice_ctx && s->restart_interval && !mb_bitmask && !s->progressive) {
+        ret = mjpeg_decode_scan_threaded(s);
+        if (ret < 0)
+            return ret;
+        if (ret)
+            goto field_done;
+    }
+
     s->restart_count = -1;
 
     for (mb_y = 0; mb_y < s->mb_height; mb_y++) {
@@ -1544,7 +1773,7 @@ next_field:
 
                         } else {
                             s->bdsp.clear_block(s->block);
-                            if (decode_block(s, s->block, i,
+                            if (decode_block(s, &s->gb, s->block, &s->last_dc[i],
                                              s->dc_index[i], s->ac_index[i],
                                              s->quant_matrixes[s->quant_sindex[i]]) < 0) {
                                 av_log(s->avctx, AV_LOG_ERROR,
@@ -1585,6 +1814,7 @@ next_field:
         }
     }
 
+field_done:
     if (s->interlaced &&
         bytestream2_get_bytes_left(&s->gB) > 2 &&
         bytestream2_tell(&s->gB) > 2 &&
@@ -2250,6 +2480,34 @@ found_hw:
     bytestream2_skipu(&s->gB, *pbuf_size);
 }
 
+/* Check whether the scan starting at the current SOS marker is followed by
+ * EOI (or the end of the packet), i.e. no header marker that could change the
+ * decoder state follows it. */
+static int mjpeg_is_last_scan(const MJpegDecodeContext *s)
+{
+    GetByteContext gB = s->gB;
+    const uint8_t *ptr, *buf_end;
+
+    if (bytestream2_get_bytes_left(&gB) < 2)
+        return 0;
+    bytestream2_skipu(&gB, bytestream2_peek_be16u(&gB));
+
+    ptr     = gB.buffer;
+    buf_end = gB.buffer_end;
+    while ((ptr = memchr(ptr, 0xff, buf_end - ptr))) {
+        ptr++;
+        if (ptr < buf_end) {
+            uint8_t x = *ptr++;
+            /* Discard multiple optional 0xFF fill bytes. */
+            while (x == 0xff && ptr < buf_end)
+                x = *ptr++;
+            if (x && (x < RST0 || x > RST7))
+                return x == EOI;
+        }
+    }
+    return 1;
+}
+
 int ff_mjpeg_unescape_sos(MJpegDecodeContext *s)
 {
     const uint8_t *buf_ptr = s->gB.buffer;
@@ -2404,6 +2662,7 @@ int ff_mjpeg_decode_frame_from_buf(AVCodecContext *avctx, AVFrame *frame,
     int index;
     int ret = 0;
     int is16bit;
+    int setup_finished = 0;
 
     s->force_pal8 = 0;
 
@@ -2591,6 +2850,15 @@ eoi_parser:
         case SOS:
             s->cur_scan++;
 
+            /* With frame threading, the next frame may start decoding once
+             * no more tables or parameters can be changed by this one. Split
+             * fields share a picture, so they are decoded serially. */
+            if (avctx->active_thread_type & FF_THREAD_FRAME &&
+                !setup_finished && !s->interlaced && mjpeg_is_last_scan(s)) {
+                ff_thread_finish_setup(avctx);
+                setup_finished = 1;
+            }
+
             if ((ret = ff_mjpeg_decode_sos(s)) < 0 &&
                 (avctx->err_recognition & AV_EF_EXPLODE))
                 goto fail;
@@ -2923,6 +3191,12 @@ av_cold int ff_mjpeg_decode_end(AVCodecContext *avctx)
     av_frame_free(&s->smv_frame);
 
     av_freep(&s->buffer);
+    if (s->slice_ctx) {
+        for (i = 0; i < avctx->thread_count; i++)
+            av_freep(&s->slice_ctx[i].buffer);
+        av_freep(&s->slice_ctx);
+    }
+    av_freep(&s->restart_intervals);
     av_freep(&s->stereo3d);
     av_freep(&s->ljpeg_buffer);
     s->ljpeg_buffer_size = 0;
@@ -2945,6 +3219,118 @@ av_cold int ff_mjpeg_decode_end(AVCodecContext *avctx)
     return 0;
 }
 
+#if CONFIG_MJPEG_DECODER && HAVE_THREADS
+static int mjpeg_huffman_table_changed(const MJpegDecodeContext *s,
+                                       const MJpegDecodeContext *s1,
+                                       int class, int index)
+{
+    int nb_codes = 0;
+
+    if (memcmp(s->raw_huffman_lengths[class][index],
+               s1->raw_huffman_lengths[class][index], 16))
+        return 1;
+
+    for (int i = 0; i < 16; i++)
+        nb_codes += s1->raw_huffman_lengths[class][index][i];
+
+    return memcmp(s->raw_huffman_values[class][index],
+                  s1->raw_huffman_values[class][index], nb_codes);
+}
+
+static int mjpeg_update_thread_context(AVCodecContext *dst, const AVCodecContext *src)
+{
+    MJpegDecodeContext *s        = dst->priv_data;
+    const MJpegDecodeContext *s1 = src->priv_data;
+    int ret;
+
+    if (s == s1)
+        return 0;
+
+    memcpy(s->quant_matrixes, s1->quant_matrixes, sizeof(s->quant_matrixes));
+    memcpy(s->qscale,         s1->qscale,         sizeof(s->qscale));
+
+    /* rebuild the VLCs of the huffman tables redefined by the source */
+    for (int class = 0; class < 2; class++) {
+        for (int index = 0; index < 4; index++) {
+            uint8_t bits_table[17] = { 0 };
+
+            if (!mjpeg_huffman_table_changed(s, s1, class, index))
+                continue;
+
+            memcpy(s->raw_huffman_lengths[class][index],
+                   s1->raw_huffman_lengths[class][index], 16);
+            memcpy(s->raw_huffman_values[class][index],
+                   s1->raw_huffman_values[class][index], 256);
+
+            ff_vlc_free(&s->vlcs[class][index]);
+            if (class > 0)
+                ff_vlc_free(&s->vlcs[2][index]);
+            if (!s1->vlcs[class][index].table)
+                continue;
+
+            memcpy(bits_table + 1, s->raw_huffman_lengths[class][index], 16);
+            ret = ff_mjpeg_build_vlc(&s->vlcs[class][index], bits_table,
+                                     s->raw_huffman_values[class][index],
+                                     class > 0, dst);
+            if (ret < 0)
+                return ret;
+            if (class > 0) {
+                ret = ff_mjpeg_build_vlc(&s->vlcs[2][index], bits_table,
+                                         s->raw_huffman_values[class][index],
+                                         0, dst);
+                if (ret < 0)
+                    return ret;
+            }
+        }
+    }
+
+    /* the IDCT depends on bits_per_raw_sample, which has just been synced */
+    init_idct(dst);
+
+    s->first_picture      = s1->first_picture;
+    s->width              = s1->width;
+    s->height             = s1->height;
+    s->bits               = s1->bits;
+    memcpy(s->h_count, s1->h_count, sizeof(s->h_count));
+    memcpy(s->v_count, s1->v_count, sizeof(s->v_count));
+    s->interlaced         = s1->interlaced;
+    s->bottom_field       = s1->bottom_field;
+    s->interlace_polarity = s1->interlace_polarity;
+    s->rct                = s1->rct;
+    s->pegasus_rct        = s1->pegasus_rct;
+    s->colr               = s1->colr;
+    s->xfrm               = s1->xfrm;
+    s->cs_itu601          = s1->cs_itu601;
+    s->flipped            = s1->flipped;
+    s->multiscope         = s1->multiscope;
+    /* JPEG-LS coding parameters and palette position from LSE markers */
+    s->maxval             = s1->maxval;
+    s->near               = s1->near;
+    s->t1                 = s1->t1;
+    s->t2                 = s1->t2;
+    s->t3                 = s1->t3;
+    s->reset              = s1->reset;
+    s->palette_index      = s1->palette_index;
+    s->hwaccel_pix_fmt    = s1->hwaccel_pix_fmt;
+    s->hwaccel_sw_pix_fmt = s1->hwaccel_sw_pix_fmt;
+
+    /* For interlaced content the source has been fully decoded (see the SOS
+     * handling in ff_mjpeg_decode_frame_from_buf()); the second field may
+     * then be in this packet and has to be decoded into the same picture. */
+    if (s1->interlaced && s1->got_picture) {
+        ret = av_frame_replace(s->picture_ptr, s1->picture_ptr);
+        if (ret < 0)
+            return ret;
+        memcpy(s->linesize, s1->linesize, sizeof(s->linesize));
+        s->got_picture = 1;
+    } else {
+        s->got_picture = 0;
+    }
+
+    return 0;
+}
+#endif
+
 static av_cold void decode_flush(AVCodecContext *avctx)
 {
     MJpegDecodeContext *s = avctx->priv_data;
@@ -2983,13 +3369,16 @@ const FFCodec ff_mjpeg_decoder = {
     .init           = ff_mjpeg_decode_init,
     .close          = ff_mjpeg_decode_end,
     FF_CODEC_DECODE_CB(ff_mjpeg_decode_frame),
+    UPDATE_THREAD_CONTEXT(mjpeg_update_thread_context),
     .flush          = decode_flush,
-    .p.capabilities = AV_CODEC_CAP_DR1,
+    .p.capabilities = AV_CODEC_CAP_DR1 | AV_CODEC_CAP_FRAME_THREADS |
+                      AV_CODEC_CAP_SLICE_THREADS,
     .p.max_lowres   = 3,
     .p.priv_class   = &mjpegdec_class,
     .p.profiles     = NULL_IF_CONFIG_SMALL(ff_mjpeg_profiles),
     .caps_internal  = FF_CODEC_CAP_INIT_CLEANUP |
                       FF_CODEC_CAP_SKIP_FRAME_FILL_PARAM |
+                      FF_CODEC_CAP_FRAME_SLICE_THREADS |
                       FF_CODEC_CAP_ICC_PROFILES,
     .hw_configs     = (const AVCodecHWConfigInternal *const []) {
 #if CONFIG_MJPEG_NVDEC_HWACCEL
@@ -53,6 +53,27 @@ typedef struct ICCEntry {
 
 struct JLSState;
 
+/**
+ * Entropy-coded data of one restart interval, as located before decoding
+ * the intervals of a scan in parallel.
+ */
+typedef struct MJpegRestartInterval {
+    const uint8_t *buf;     ///< escaped data, without the restart marker
+    size_t size;
+} MJpegRestartInterval;
+
+/**
+ * Per-thread state for decoding restart intervals with slice threading.
+ */
+typedef struct MJpegSliceContext {
+    GetBitContext gb;
+    int last_dc[MAX_COMPONENTS];
+    DECLARE_ALIGNED(32, int16_t, block)[64];
+    uint8_t *buffer;        ///< unescaped restart interval data
+    unsigned int buffer_size;
+    int errors;
+} MJpegSliceContext;
+
 typedef struct MJpegDecodeContext {
     AVClass *class;
     AVCodecContext *avctx;
@@ -132,6 +153,10 @@ typedef struct MJpegDecodeContext {
     int restart_interval;
     int restart_count;
 
+    MJpegRestartInterval *restart_intervals;
+    unsigned int restart_intervals_size;
+    MJpegSliceContext *slice_ctx;  ///< one per thread with slice threading
+
     int cs_itu601;
     int interlace_polarity;
     int multiscope;
@@ -1485,24 +1485,122 @@ static int encode_frame(AVCodecContext *c, const AVFrame *frame, AVPacket *pkt)
     return size;
 }
 
-static int estimate_best_b_count(MPVMainEncContext *const m)
+/**
+ * One trial encode of estimate_best_b_count(), using b_count B-frames
+ * between consecutive P-frames.
+ */
+typedef struct BFrameTrial {
+    MPVMainEncContext *m;
+    int b_count;
+    int p_lambda, b_lambda, lambda2;
+    int64_t rd;
+} BFrameTrial;
+
+static int estimate_b_count_thread(AVCodecContext *avctx, void *arg)
 {
+    BFrameTrial *const t = arg;
+    MPVMainEncContext *const m = t->m;
     MPVEncContext *const s = &m->s;
+    AVCodecContext *c;
+    AVFrame *frame;
     AVPacket *pkt;
+    int out_size, ret;
+    int64_t rd = 0;
+
+    c     = avcodec_alloc_context3(NULL);
+    frame = av_frame_alloc();
+    pkt   = av_packet_alloc();
+    if (!c || !frame || !pkt) {
+        ret = AVERROR(ENOMEM);
+        goto fail;
+    }
+
+    c->width        = m->tmp_frames[0]->width;
+    c->height       = m->tmp_frames[0]->height;
+    c->flags        = AV_CODEC_FLAG_QSCALE | AV_CODEC_FLAG_PSNR;
+    c->flags       |= s->c.avctx->flags & AV_CODEC_FLAG_QPEL;
+    c->mb_decision  = s->c.avctx->mb_decision;
+    c->me_cmp       = s->c.avctx->me_cmp;
+    c->mb_cmp       = s->c.avctx->mb_cmp;
+    c->me_sub_cmp   = s->c.avctx->me_sub_cmp;
+    c->pix_fmt      = AV_PIX_FMT_YUV420P;
+    c->time_base    = s->c.avctx->time_base;
+    c->max_b_frames = m->max_b_frames;
+
+    ret = avcodec_open2(c, s->c.avctx->codec, NULL);
+    if (ret < 0)
+        goto fail;
+
+    /* the downscaled frames are shared by all trials,
+     * so the picture type is set on a reference */
+    ret = av_frame_ref(frame, m->tmp_frames[0]);
+    if (ret < 0)
+        goto fail;
+    frame->pict_type = AV_PICTURE_TYPE_I;
+    frame->quality   = 1 * FF_QP2LAMBDA;
+
+    out_size = encode_frame(c, frame, pkt);
+    av_frame_unref(frame);
+    if (out_size < 0) {
+        ret = out_size;
+        goto fail;
+    }
+
+    //rd += (out_size * lambda2) >> FF_LAMBDA_SHIFT;
+
+    for (int i = 0; i < m->max_b_frames + 1; i++) {
+        int is_p = i % (t->b_count + 1) == t->b_count || i == m->max_b_frames;
+
+        ret = av_frame_ref(frame, m->tmp_frames[i + 1]);
+        if (ret < 0)
+            goto fail;
+        frame->pict_type = is_p ? AV_PICTURE_TYPE_P : AV_PICTURE_TYPE_B;
+        frame->quality   = is_p ? t->p_lambda : t->b_lambda;
+
+        out_size = encode_frame(c, frame, pkt);
+        av_frame_unref(frame);
+        if (out_size < 0) {
+            ret = out_size;
+            goto fail;
+        }
+
+        rd += (out_size * (uint64_t)t->lambda2) >> (FF_LAMBDA_SHIFT - 3);
+    }
+
+    /* get the delayed frames */
+    out_size = encode_frame(c, NULL, pkt);
+    if (out_size < 0) {
+        ret = out_size;
+        goto fail;
+    }
+    rd += (out_size * (uint64_t)t->lambda2) >> (FF_LAMBDA_SHIFT - 3);
+
+    rd += c->error[0] + c->error[1] + c->error[2];
+
+    t->rd = rd;
+    ret   = 0;
+
+fail:
+    avcodec_free_context(&c);
+    av_frame_free(&frame);
+    av_packet_free(&pkt);
+    return ret;
+}
+
+static int estimate_best_b_count(MPVMainEncContext *const m)
+{
+    MPVEncContext *const s = &m->s;
+    BFrameTrial trials[MPVENC_MAX_B_FRAMES + 1];
+    int rets[MPVENC_MAX_B_FRAMES + 1];
     const int scale = m->brd_scale;
     int width  = s->c.width  >> scale;
     int height = s->c.height >> scale;
-    int out_size, p_lambda, b_lambda, lambda2;
+    int p_lambda, b_lambda, lambda2, nb_trials;
     int64_t best_rd  = INT64_MAX;
     int best_b_count = -1;
-    int ret = 0;
 
     av_assert0(scale >= 0 && scale <= 3);
 
-    pkt = av_packet_alloc();
-    if (!pkt)
-        return AVERROR(ENOMEM);
-
     p_lambda = m->last_lambda_for[AV_PICTURE_TYPE_P];
     //p_lambda * FFABS(s->c.avctx->b_quant_factor) + s->c.avctx->b_quant_offset;
     b_lambda = m->last_lambda_for[AV_PICTURE_TYPE_B];
@@ -1543,89 +1641,34 @@ static int estimate_best_b_count(MPVMainEncContext *const m)
         }
     }
 
-    for (int j = 0; j < m->max_b_frames + 1; j++) {
-        AVCodecContext *c;
-        int64_t rd = 0;
+    for (nb_trials = 0; nb_trials < m->max_b_frames + 1; nb_trials++) {
+        BFrameTrial *const t = &trials[nb_trials];
 
-        if (!m->input_picture[j])
+        if (!m->input_picture[nb_trials])
             break;
 
-        c = avcodec_alloc_context3(NULL);
-        if (!c) {
-            ret = AVERROR(ENOMEM);
-            goto fail;
-        }
-
-        c->width        = width;
-        c->height       = height;
-        c->flags        = AV_CODEC_FLAG_QSCALE | AV_CODEC_FLAG_PSNR;
-        c->flags       |= s->c.avctx->flags & AV_CODEC_FLAG_QPEL;
-        c->mb_decision  = s->c.avctx->mb_decision;
-        c->me_cmp       = s->c.avctx->me_cmp;
-        c->mb_cmp       = s->c.avctx->mb_cmp;
-        c->me_sub_cmp   = s->c.avctx->me_sub_cmp;
-        c->pix_fmt      = AV_PIX_FMT_YUV420P;
-        c->time_base    = s->c.avctx->time_base;
-        c->max_b_frames = m->max_b_frames;
-
-        ret = avcodec_open2(c, s->c.avctx->codec, NULL);
-        if (ret < 0)
-            goto fail;
-
-
-        m->tmp_frames[0]->pict_type = AV_PICTURE_TYPE_I;
-        m->tmp_frames[0]->quality   = 1 * FF_QP2LAMBDA;
-
-        out_size = encode_frame(c, m->tmp_frames[0], pkt);
-        if (out_size < 0) {
-            ret = out_size;
-            goto fail;
-        }
-
-        //rd += (out_size * lambda2) >> FF_LAMBDA_SHIFT;
-
-        for (int i = 0; i < m->max_b_frames + 1; i++) {
-            int is_p = i % (j + 1) == j || i == m->max_b_frames;
-
-            m->tmp_frames[i + 1]->pict_type = is_p ?
-                                     AV_PICTURE_TYPE_P : AV_PICTURE_TYPE_B;
-            m->tmp_frames[i + 1]->quality   = is_p ? p_lambda : b_lambda;
-
-            out_size = encode_frame(c, m->tmp_frames[i + 1], pkt);
-            if (out_size < 0) {
-                ret = out_size;
-                goto fail;
-            }
-
-            rd += (out_size * (uint64_t)lambda2) >> (FF_LAMBDA_SHIFT - 3);
-        }
+        t->m        = m;
+        t->b_count  = nb_trials;
+        t->p_lambda = p_lambda;
+        t->b_lambda = b_lambda;
+        t->lambda2  = lambda2;
+    }
 
-        /* get the delayed frames */
-        out_size = encode_frame(c, NULL, pkt);
-        if (out_size < 0) {
-            ret = out_size;
-            goto fail;
-        }
-        rd += (out_size * (uint64_t)lambda2) >> (FF_LAMBDA_SHIFT - 3);
+    /* The trial encodes are independent of each other,
+     * so they run on the slice threads of the main encoder. */
+    s->c.avctx->execute(s->c.avctx, estimate_b_count_thread, trials, rets,
+                        nb_trials, sizeof(*trials));
 
-        rd += c->error[0] + c->error[1] + c->error[2];
+    for (int j = 0; j < nb_trials; j++) {
+        if (rets[j] < 0)
+            return rets[j];
 
-        if (rd < best_rd) {
-            best_rd = rd;
+        if (trials[j].rd < best_rd) {
+            best_rd = trials[j].rd;
             best_b_count = j;
         }
-
-fail:
-        avcodec_free_context(&c);
-        av_packet_unref(pkt);
-        if (ret < 0) {
-            best_b_count = ret;
-            break;
-        }
     }
 
-    av_packet_free(&pkt);
-
     return best_b_count;
 }
 
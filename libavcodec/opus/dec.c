@@ -112,6 +112,8 @@ typedef struct OpusStreamContext {
     int delayed_samples;
 
     OpusPacket packet;
+    /* start of this stream's sub-packet, NULL when flushing */
+    const uint8_t *packet_buf;
 
     int redundancy_idx;
 } OpusStreamContext;
@@ -473,6 +475,19 @@ finish:
     return output_samples;
 }
 
+static int opus_decode_subpacket_job(AVCodecContext *avctx, void *arg,
+                                     int jobnr, int threadnr)
+{
+    OpusContext *c       = avctx->priv_data;
+    OpusStreamContext *s = &c->streams[jobnr];
+    int ret;
+
+    ret = opus_decode_subpacket(s, s->packet_buf);
+    s->decoded_samples = ret;
+
+    return ret;
+}
+
 static int opus_decode_packet(AVCodecContext *avctx, AVFrame *frame,
                               int *got_frame_ptr, AVPacket *avpkt)
 {
@@ -558,11 +573,15 @@ static int opus_decode_packet(AVCodecContext *avctx, AVFrame *frame,
         s->out_size = frame->linesize[0] - ret * sizeof(float);
     }
 
-    /* decode each sub-packet */
+    /* locate each sub-packet */
     for (int i = 0; i < c->p.nb_streams; i++) {
         OpusStreamContext *s = &c->streams[i];
 
-        if (i && buf) {
+        s->packet_buf = buf;
+        if (!buf)
+            continue;
+
+        if (i) {
             ret = ff_opus_parse_packet(&s->packet, buf, buf_size, i != c->p.nb_streams - 1);
             if (ret < 0) {
                 av_log(avctx, AV_LOG_ERROR, "Error parsing the packet header.\n");
@@ -577,19 +596,21 @@ static int opus_decode_packet(AVCodecContext *avctx, AVFrame *frame,
             s->silk_samplerate = get_silk_samplerate(s->packet.config);
         }
 
-        ret = opus_decode_subpacket(&c->streams[i], buf);
-        if (ret < 0)
-            return ret;
-        s->decoded_samples = ret;
-        decoded_samples       = FFMIN(decoded_samples, ret);
-
-        if (!buf)
-            continue;
-
         buf      += s->packet.packet_size;
         buf_size -= s->packet.packet_size;
     }
 
+    /* the streams share no state and write to distinct channels,
+     * so they can be decoded concurrently */
+    avctx->execute2(avctx, opus_decode_subpacket_job, NULL, NULL, c->p.nb_streams);
+
+    for (int i = 0; i < c->p.nb_streams; i++) {
+        ret = c->streams[i].decoded_samples;
+        if (ret < 0)
+            return ret;
+        decoded_samples = FFMIN(decoded_samples, ret);
+    }
+
     /* buffer the extra samples */
     for (int i = 0; i < c->p.nb_streams; i++) {
         OpusStreamContext *s = &c->streams[i];
@@ -780,6 +801,7 @@ const FFCodec ff_opus_decoder = {
     .close           = opus_decode_close,
     FF_CODEC_DECODE_CB(opus_decode_packet),
     .flush           = opus_decode_flush,
-    .p.capabilities  = AV_CODEC_CAP_DR1 | AV_CODEC_CAP_DELAY | AV_CODEC_CAP_CHANNEL_CONF,
+    .p.capabilities  = AV_CODEC_CAP_DR1 | AV_CODEC_CAP_DELAY | AV_CODEC_CAP_CHANNEL_CONF |
+                       AV_CODEC_CAP_SLICE_THREADS,
     .caps_internal   = FF_CODEC_CAP_INIT_CLEANUP,
 };
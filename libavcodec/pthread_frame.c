@@ -43,6 +43,7 @@
 #include "libavutil/buffer.h"
 #include "libavutil/common.h"
 #include "libavutil/cpu.h"
+#include "libavutil/executor.h"
 #include "libavutil/frame.h"
 #include "libavutil/internal.h"
 #include "libavutil/log.h"
@@ -75,6 +76,19 @@ typedef struct ThreadFrameProgress {
     atomic_int progress[2];
 } ThreadFrameProgress;
 
+typedef int (action_func)(AVCodecContext *c, void *arg);
+typedef int (action_func2)(AVCodecContext *c, void *arg, int jobnr, int threadnr);
+
+/**
+ * Task queued on the shared slice pool to help a frame thread with the
+ * slice jobs of its current frame.
+ */
+typedef struct SliceHelper {
+    AVTask task;
+    struct PerThreadContext *p;
+    struct SliceHelper *next_free;
+} SliceHelper;
+
 /**
  * Context used by codec threads and stored in their AVCodecInternal thread_ctx.
  */
@@ -115,6 +129,25 @@ typedef struct PerThreadContext {
     int hwaccel_threadsafe;
 
     atomic_int debug_threads;       ///< Set if the FF_DEBUG_THREADS option is set.
+
+    /**
+     * Slice jobs of the frame decoded by this thread when FF_THREAD_HYBRID
+     * is in use. All of these are protected by slice_mutex.
+     */
+    pthread_mutex_t slice_mutex;
+    pthread_cond_t  slice_cond;     ///< Signalled when the last slice job is done.
+    action_func    *slice_func;
+    action_func2   *slice_func2;
+    void           *slice_arg;
+    int            *slice_ret;
+    int             slice_job_size;
+    int             slice_job_count;
+    int             slice_next_job;
+    int             slice_jobs_done;
+
+    SliceHelper   **slice_helpers;  ///< All helper tasks allocated by this thread.
+    int             nb_slice_helpers;
+    SliceHelper    *free_slice_helpers; ///< Helpers that are not queued on the pool.
 } PerThreadContext;
 
 /**
@@ -152,6 +185,14 @@ typedef struct FrameThreadContext {
     const AVHWAccel *stash_hwaccel;
     void            *stash_hwaccel_context;
     void            *stash_hwaccel_priv;
+
+    /**
+     * Pool shared by all threads to run their slice jobs, only allocated
+     * when FF_THREAD_HYBRID is in use.
+     */
+    AVExecutor *slice_executor;
+    int nb_slice_threads;          ///< Number of threads in slice_executor.
+    atomic_int next_slice_threadnr;
 } FrameThreadContext;
 
 static int hwaccel_serial(const AVCodecContext *avctx)
@@ -555,7 +596,7 @@ static int submit_packet(PerThreadContext *p, AVCodecContext *user_avctx,
     pthread_mutex_unlock(&p->mutex);
 
     fctx->prev_thread = p;
-    fctx->next_decoding = (fctx->next_decoding + 1) % p->avctx->thread_count;
+    fctx->next_decoding = (fctx->next_decoding + 1) % user_avctx->thread_count;
 
     return 0;
 }
@@ -744,8 +785,9 @@ DEFINE_OFFSET_ARRAY(FrameThreadContext, thread_ctx, pthread_init_cnt,
 
 #define OFF(member) offsetof(PerThreadContext, member)
 DEFINE_OFFSET_ARRAY(PerThreadContext, per_thread, pthread_init_cnt,
-                    (OFF(progress_mutex), OFF(mutex)),
-                    (OFF(input_cond), OFF(progress_cond), OFF(output_cond)));
+                    (OFF(progress_mutex), OFF(mutex), OFF(slice_mutex)),
+                    (OFF(input_cond), OFF(progress_cond), OFF(output_cond),
+                     OFF(slice_cond)));
 #undef OFF
 
 av_cold void ff_frame_thread_free(AVCodecContext *avctx, int thread_count)
@@ -756,6 +798,10 @@ av_cold void ff_frame_thread_free(AVCodecContext *avctx, int thread_count)
 
     park_frame_worker_threads(fctx, thread_count);
 
+    /* No slice jobs are running anymore, so helpers still queued on the
+     * pool can simply be dropped */
+    av_executor_free(&fctx->slice_executor);
+
     for (i = 0; i < thread_count; i++) {
         PerThreadContext *p = &fctx->threads[i];
         AVCodecContext *ctx = p->avctx;
@@ -794,6 +840,10 @@ av_cold void ff_frame_thread_free(AVCodecContext *avctx, int thread_count)
 
         decoded_frames_free(&p->df);
 
+        for (int j = 0; j < p->nb_slice_helpers; j++)
+            av_free(p->slice_helpers[j]);
+        av_freep(&p->slice_helpers);
+
         ff_pthread_free(p, per_thread_offsets);
         av_packet_free(&p->avpkt);
 
@@ -816,6 +866,184 @@ av_cold void ff_frame_thread_free(AVCodecContext *avctx, int thread_count)
     av_freep(&avctx->internal->thread_ctx);
 }
 
+/**
+ * Run slice jobs of p's current batch until there are none left to claim.
+ */
+static void run_slice_jobs(PerThreadContext *p, int threadnr)
+{
+    pthread_mutex_lock(&p->slice_mutex);
+    while (p->slice_next_job < p->slice_job_count) {
+        int jobnr = p->slice_next_job++;
+        int ret;
+
+        pthread_mutex_unlock(&p->slice_mutex);
+        ret = p->slice_func ? p->slice_func(p->avctx, (char *)p->slice_arg + p->slice_job_size * jobnr)
+                            : p->slice_func2(p->avctx, p->slice_arg, jobnr, threadnr);
+        if (p->slice_ret)
+            p->slice_ret[jobnr] = ret;
+        pthread_mutex_lock(&p->slice_mutex);
+
+        if (++p->slice_jobs_done == p->slice_job_count)
+            pthread_cond_signal(&p->slice_cond);
+    }
+    pthread_mutex_unlock(&p->slice_mutex);
+}
+
+static int slice_helper_priority_higher(const AVTask *a, const AVTask *b)
+{
+    /* Run helpers in the order they were queued */
+    return 1;
+}
+
+static int slice_helper_ready(const AVTask *t, void *user_data)
+{
+    return 1;
+}
+
+static int slice_helper_run(AVTask *t, void *local_context, void *user_data)
+{
+    FrameThreadContext *fctx = user_data;
+    SliceHelper *h = (SliceHelper *)t;
+    PerThreadContext *p = h->p;
+    int *threadnr = local_context;
+
+    /* Number the pool threads from 1, 0 is the frame thread itself */
+    if (!*threadnr)
+        *threadnr = atomic_fetch_add(&fctx->next_slice_threadnr, 1) + 1;
+
+    /* A helper may run after the batch it was queued for has finished;
+     * it then either helps with the next batch of the thread or does
+     * nothing. */
+    run_slice_jobs(p, *threadnr);
+
+    pthread_mutex_lock(&p->slice_mutex);
+    h->next_free = p->free_slice_helpers;
+    p->free_slice_helpers = h;
+    pthread_mutex_unlock(&p->slice_mutex);
+
+    return 0;
+}
+
+static SliceHelper *get_slice_helper(PerThreadContext *p)
+{
+    SliceHelper *h = p->free_slice_helpers, **tmp;
+
+    if (h) {
+        p->free_slice_helpers = h->next_free;
+        return h;
+    }
+
+    tmp = av_realloc_array(p->slice_helpers, p->nb_slice_helpers + 1,
+                           sizeof(*p->slice_helpers));
+    if (!tmp)
+        return NULL;
+    p->slice_helpers = tmp;
+
+    h = av_mallocz(sizeof(*h));
+    if (!h)
+        return NULL;
+    h->p = p;
+    p->slice_helpers[p->nb_slice_helpers++] = h;
+
+    return h;
+}
+
+/**
+ * execute()/execute2() of the per-thread contexts when FF_THREAD_HYBRID is
+ * in use. The calling frame thread works on its own jobs while helpers
+ * queued on the shared pool join in as pool threads become available, so
+ * a frame never waits for the pool to make progress.
+ */
+static int hybrid_execute(AVCodecContext *avctx, action_func *func,
+                          action_func2 *func2, void *arg, int *ret,
+                          int job_count, int job_size)
+{
+    PerThreadContext *p = avctx->internal->thread_ctx;
+    FrameThreadContext *fctx = p->parent;
+    SliceHelper *helpers[MAX_AUTO_THREADS];
+    int nb_helpers = 0;
+
+    if (job_count <= 0)
+        return 0;
+
+    pthread_mutex_lock(&p->slice_mutex);
+    p->slice_func      = func;
+    p->slice_func2     = func2;
+    p->slice_arg       = arg;
+    p->slice_ret       = ret;
+    p->slice_job_size  = job_size;
+    p->slice_job_count = job_count;
+    p->slice_next_job  = 0;
+    p->slice_jobs_done = 0;
+
+    while (nb_helpers < FFMIN(job_count - 1, fctx->nb_slice_threads)) {
+        SliceHelper *h = get_slice_helper(p);
+        if (!h)
+            break;
+        helpers[nb_helpers++] = h;
+    }
+    pthread_mutex_unlock(&p->slice_mutex);
+
+    for (int i = 0; i < nb_helpers; i++)
+        av_executor_execute(fctx->slice_executor, &helpers[i]->task);
+
+    run_slice_jobs(p, 0);
+
+    pthread_mutex_lock(&p->slice_mutex);
+    while (p->slice_jobs_done < p->slice_job_count)
+        pthread_cond_wait(&p->slice_cond, &p->slice_mutex);
+    pthread_mutex_unlock(&p->slice_mutex);
+
+    return 0;
+}
+
+static int thread_execute(AVCodecContext *avctx, action_func *func, void *arg,
+                          int *ret, int job_count, int job_size)
+{
+    return hybrid_execute(avctx, func, NULL, arg, ret, job_count, job_size);
+}
+
+static int thread_execute2(AVCodecContext *avctx, action_func2 *func2,
+                           void *arg, int *ret, int job_count)
+{
+    return hybrid_execute(avctx, NULL, func2, arg, ret, job_count, 0);
+}
+
+/**
+ * Set up the pool running the slice jobs of all threads if both frame and
+ * slice threading are in use. Falls back to plain frame threading if there
+ * are no spare cores or the pool cannot be created.
+ */
+static av_cold void init_slice_executor(AVCodecContext *avctx,
+                                        FrameThreadContext *fctx)
+{
+    const AVTaskCallbacks callbacks = {
+        .user_data          = fctx,
+        .local_context_size = sizeof(int),
+        .priority_higher    = slice_helper_priority_higher,
+        .ready              = slice_helper_ready,
+        .run                = slice_helper_run,
+    };
+    int nb_threads = FFMIN(av_cpu_count(), MAX_AUTO_THREADS) - 1;
+
+    if (!(avctx->active_thread_type & FF_THREAD_SLICE))
+        return;
+
+    avctx->active_thread_type = FF_THREAD_FRAME;
+    if (nb_threads < 1)
+        return;
+
+    fctx->slice_executor = av_executor_alloc(&callbacks, nb_threads);
+    if (!fctx->slice_executor) {
+        av_log(avctx, AV_LOG_WARNING,
+               "Could not create slice thread pool, using frame threads only\n");
+        return;
+    }
+    fctx->nb_slice_threads = nb_threads;
+    atomic_init(&fctx->next_slice_threadnr, 0);
+    avctx->active_thread_type = FF_THREAD_FRAME | FF_THREAD_SLICE;
+}
+
 static av_cold int init_thread(PerThreadContext *p, int *threads_to_free,
                                FrameThreadContext *fctx, AVCodecContext *avctx,
                                const FFCodec *codec, int first)
@@ -872,6 +1100,13 @@ static av_cold int init_thread(PerThreadContext *p, int *threads_to_free,
     if (!first)
         copy->internal->is_copy = 1;
 
+    if (fctx->slice_executor) {
+        /* Slice jobs run on this thread and on any thread of the pool */
+        copy->thread_count = fctx->nb_slice_threads + 1;
+        copy->execute      = thread_execute;
+        copy->execute2     = thread_execute2;
+    }
+
     copy->internal->in_pkt = av_packet_alloc();
     if (!copy->internal->in_pkt)
         return AVERROR(ENOMEM);
@@ -951,6 +1186,8 @@ av_cold int ff_frame_thread_init(AVCodecContext *avctx)
 
     fctx->async_lock = 1;
 
+    init_slice_executor(avctx, fctx);
+
     if (codec->p.type == AVMEDIA_TYPE_VIDEO)
         avctx->delay = avctx->thread_count - 1;
 
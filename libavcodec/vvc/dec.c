@@ -1240,7 +1240,7 @@ static av_cold int vvc_decode_free(AVCodecContext *avctx)
 
     ff_cbs_fragment_free(&s->current_frame);
     vvc_decode_flush(avctx);
-    ff_vvc_executor_free(&s->executor);
+    ff_vvc_executor_free(s);
     if (s->fcs) {
         for (int i = 0; i < s->nb_fcs; i++)
             frame_context_free(s->fcs + i);
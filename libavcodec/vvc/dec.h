@@ -248,6 +248,7 @@ typedef struct VVCContext {
 
     uint64_t nb_frames;     ///< processed frames
     int nb_delayed;         ///< delayed frames
+    struct VVCTaskStats *task_stats;    ///< per-stage task counters, with FF_DEBUG_THREADS only
 
     H274HashContext *hash_ctx;
 }  VVCContext ;
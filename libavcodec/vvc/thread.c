@@ -25,6 +25,7 @@
 #include "libavcodec/executor.h"
 #include "libavutil/mem.h"
 #include "libavutil/thread.h"
+#include "libavutil/time.h"
 
 #include "thread.h"
 #include "ctu.h"
@@ -61,6 +62,9 @@ typedef struct VVCTask {
 
     VVCTaskStage stage;
 
+    // when the task was queued, for FF_DEBUG_THREADS statistics
+    int64_t queue_time;
+
     // ctu x, y, and raster scan order
     int rx, ry, rs;
     VVCFrameContext *fc;
@@ -78,6 +82,14 @@ typedef struct VVCTask {
     atomic_uchar target_inter_score;
 } VVCTask;
 
+typedef struct VVCTaskStats {
+    int64_t start_time;
+    int thread_count;
+    atomic_uint_least64_t count[VVC_TASK_STAGE_LAST];
+    atomic_uint_least64_t run_time[VVC_TASK_STAGE_LAST];   ///< in microseconds
+    atomic_uint_least64_t queue_time[VVC_TASK_STAGE_LAST]; ///< in microseconds
+} VVCTaskStats;
+
 typedef struct VVCRowThread {
     atomic_int col_progress[VVC_PROGRESS_LAST];
 } VVCRowThread;
@@ -104,28 +116,43 @@ typedef struct VVCFrameThread {
     AVCond  cond;
 } VVCFrameThread;
 
-#define PRIORITY_LOWEST 2
+// Parsing runs serially along each entry point and gates all other stages,
+// so it comes first, for every frame in flight. The other stages are ordered
+// by frame age: a frame waits for the pixels of its references, which always
+// precede it in decoding order, so the oldest frame is on the critical path.
+// Each frame in flight owns a pair of priorities picked by its decoding order,
+// and the executor serves the pairs as a ring starting at the oldest frame,
+// see ff_vvc_frame_wait(), so queued tasks age along with their frame.
+// Frames nothing refers to only hold up their own output and come after the
+// ring.
+// Within a frame, inter tasks come last: for an 8K clip, a CTU line completed
+// in the reference frame may trigger 64 and more of them, and we want to avoid
+// being overwhelmed with inter tasks.
+static int task_priority(const VVCContext *s, const VVCTask *t)
+{
+    const VVCFrameContext *fc = t->fc;
+    int slot;
+
+    if (t->stage <= VVC_TASK_STAGE_PARSE)
+        return 0;
+
+    if (fc->ps.ph.r->ph_non_ref_pic_flag)
+        slot = s->nb_fcs;
+    else
+        slot = fc->decode_order % s->nb_fcs;
+
+    return 1 + 2 * slot + (t->stage == VVC_TASK_STAGE_INTER);
+}
+
 static void add_task(VVCContext *s, VVCTask *t)
 {
     VVCFrameThread *ft     = t->fc->ft;
     FFTask *task           = &t->u.task;
-    const int priorities[] = {
-        0,                  // VVC_TASK_STAGE_INIT,
-        0,                  // VVC_TASK_STAGE_PARSE,
-        1,                  // VVC_TASK_STAGE_DEBLOCK_BS
-        // For an 8K clip, a CTU line completed in the reference frame may trigger 64 and more inter tasks.
-        // We assign these tasks the lowest priority to avoid being overwhelmed with inter tasks.
-        PRIORITY_LOWEST,    // VVC_TASK_STAGE_INTER
-        1,                  // VVC_TASK_STAGE_RECON,
-        1,                  // VVC_TASK_STAGE_LMCS,
-        1,                  // VVC_TASK_STAGE_DEBLOCK_V,
-        1,                  // VVC_TASK_STAGE_DEBLOCK_H,
-        1,                  // VVC_TASK_STAGE_SAO,
-        1,                  // VVC_TASK_STAGE_ALF,
-    };
 
     atomic_fetch_add(&ft->nb_scheduled_tasks, 1);
-    task->priority = priorities[t->stage];
+    if (s->task_stats)
+        t->queue_time = av_gettime_relative();
+    task->priority = task_priority(s, t);
     ff_executor_execute(s->executor, task);
 }
 
@@ -669,12 +696,31 @@ static int task_run(FFTask *_t, void *local_context, void *user_data)
     VVCLocalContext *lc = local_context;
     VVCFrameThread *ft  = t->fc->ft;
 
+    VVCTaskStats *stats = s->task_stats;
+
     lc->fc = t->fc;
 
-    do {
-        task_run_stage(t, s, lc);
-        t->stage++;
-    } while (task_is_stage_ready(t, 1));
+    if (stats) {
+        int64_t start = av_gettime_relative();
+        atomic_fetch_add(&stats->queue_time[t->stage], start - t->queue_time);
+        do {
+            const VVCTaskStage stage = t->stage;
+            int64_t end;
+
+            task_run_stage(t, s, lc);
+            t->stage++;
+
+            end = av_gettime_relative();
+            atomic_fetch_add(&stats->count[stage], 1);
+            atomic_fetch_add(&stats->run_time[stage], end - start);
+            start = end;
+        } while (task_is_stage_ready(t, 1));
+    } else {
+        do {
+            task_run_stage(t, s, lc);
+            t->stage++;
+        } while (task_is_stage_ready(t, 1));
+    }
 
     if (t->stage != VVC_TASK_STAGE_LAST)
         frame_thread_add_score(s, ft, t->rx, t->ry, t->stage);
@@ -689,15 +735,50 @@ av_cold FFExecutor* ff_vvc_executor_alloc(VVCContext *s, const int thread_count)
     FFTaskCallbacks callbacks = {
         s,
         sizeof(VVCLocalContext),
-        PRIORITY_LOWEST + 1,
+        1 + 2 * (s->nb_fcs + 1),
         task_run,
     };
+
+    if (s->avctx->debug & FF_DEBUG_THREADS) {
+        s->task_stats = av_mallocz(sizeof(*s->task_stats));
+        if (!s->task_stats)
+            return NULL;
+        s->task_stats->start_time   = av_gettime_relative();
+        s->task_stats->thread_count = FFMAX(thread_count, 1);
+    }
     return ff_executor_alloc(&callbacks, thread_count);
 }
 
-av_cold void ff_vvc_executor_free(FFExecutor **e)
+static av_cold void report_task_stats(VVCContext *s)
+{
+    const VVCTaskStats *stats = s->task_stats;
+    const int64_t elapsed     = av_gettime_relative() - stats->start_time;
+    uint64_t busy = 0;
+
+    for (int i = 0; i < VVC_TASK_STAGE_LAST; i++) {
+        const uint64_t count = atomic_load(&stats->count[i]);
+        const uint64_t run   = atomic_load(&stats->run_time[i]);
+        const uint64_t queue = atomic_load(&stats->queue_time[i]);
+
+        busy += run;
+        if (!count)
+            continue;
+        av_log(s->avctx, AV_LOG_INFO,
+               "stage %-4s: %10"PRIu64" tasks, %10.3f ms, %8.2f us/task, %8.2f us queued/task\n",
+               task_name[i], count, run / 1000.0, (double)run / count, (double)queue / count);
+    }
+    if (elapsed > 0)
+        av_log(s->avctx, AV_LOG_INFO, "%"PRIu64" frames, %d threads, %.1f%% busy\n",
+               s->nb_frames, stats->thread_count,
+               100.0 * busy / ((double)elapsed * stats->thread_count));
+}
+
+av_cold void ff_vvc_executor_free(VVCContext *s)
 {
-    ff_executor_free(e);
+    ff_executor_free(&s->executor);
+    if (s->task_stats)
+        report_task_stats(s);
+    av_freep(&s->task_stats);
 }
 
 void ff_vvc_frame_thread_free(VVCFrameContext *fc)
@@ -845,6 +926,8 @@ int ff_vvc_frame_wait(VVCContext *s, VVCFrameContext *fc)
 
     ff_mutex_unlock(&ft->lock);
     ff_vvc_report_frame_finished(fc->ref);
+    ff_executor_rotate_priorities(s->executor, 1, 2 * s->nb_fcs,
+                                  2 * ((fc->decode_order + 1) % s->nb_fcs));
 
     ff_dlog(s->avctx, "frame %5d done\r\n", (int)fc->decode_order);
     return ft->ret;
@@ -26,7 +26,7 @@
 #include "dec.h"
 
 struct FFExecutor* ff_vvc_executor_alloc(VVCContext *s, int thread_count);
-void ff_vvc_executor_free(struct FFExecutor **e);
+void ff_vvc_executor_free(VVCContext *s);
 
 int ff_vvc_frame_thread_init(VVCFrameContext *fc);
 void ff_vvc_frame_thread_free(VVCFrameContext *fc);
@@ -43,10 +43,9 @@ AVFrame *ff_null_get_audio_buffer(AVFilterLink *link, int nb_samples)
     return ff_get_audio_buffer(link->dst->outputs[0], nb_samples);
 }
 
-AVFrame *ff_default_get_audio_buffer(AVFilterLink *link, int nb_samples)
+static AVFrame *frame_pool_get_audio(FilterLinkInternal *li, int nb_samples)
 {
-    AVFrame *frame = NULL;
-    FilterLinkInternal *const li = ff_link_internal(link);
+    AVFilterLink *const link = &li->l.pub;
     int channels = link->ch_layout.nb_channels;
     int align = av_cpu_max_align();
 
@@ -78,7 +77,17 @@ AVFrame *ff_default_get_audio_buffer(AVFilterLink *link, int nb_samples)
         }
     }
 
-    frame = ff_frame_pool_get(li->frame_pool);
+    return ff_frame_pool_get(li->frame_pool);
+}
+
+AVFrame *ff_default_get_audio_buffer(AVFilterLink *link, int nb_samples)
+{
+    AVFrame *frame = NULL;
+    FilterLinkInternal *const li = ff_link_internal(link);
+
+    ff_graph_state_lock(li->l.graph);
+    frame = frame_pool_get_audio(li, nb_samples);
+    ff_graph_state_unlock(li->l.graph);
     if (!frame)
         return NULL;
 
@@ -90,7 +99,7 @@ AVFrame *ff_default_get_audio_buffer(AVFilterLink *link, int nb_samples)
     }
     frame->sample_rate = link->sample_rate;
 
-    av_samples_set_silence(frame->extended_data, 0, nb_samples, channels, link->format);
+    av_samples_set_silence(frame->extended_data, 0, nb_samples, link->ch_layout.nb_channels, link->format);
 
     return frame;
 }
@@ -191,6 +191,7 @@ int avfilter_link(AVFilterContext *src, unsigned srcpad,
     link->format  = -1;
     link->colorspace = AVCOL_SPC_UNSPECIFIED;
     ff_framequeue_init(&li->fifo, &fffiltergraph(src->graph)->frame_queues);
+    ff_mutex_init(&li->lock, NULL);
 
     return 0;
 }
@@ -204,6 +205,7 @@ static void link_free(AVFilterLink **link)
     li = ff_link_internal(*link);
 
     ff_framequeue_free(&li->fifo);
+    ff_mutex_destroy(&li->lock);
     ff_frame_pool_uninit(&li->frame_pool);
     av_channel_layout_uninit(&(*link)->ch_layout);
     av_frame_side_data_free(&(*link)->side_data, &(*link)->nb_side_data);
@@ -219,17 +221,26 @@ static void update_link_current_pts(FilterLinkInternal *li, int64_t pts)
 
     if (pts == AV_NOPTS_VALUE)
         return;
+    if (li->l.graph && li->age_index >= 0) {
+        /* the heap compares the timestamps of all sink links */
+        ff_graph_state_lock(li->l.graph);
+        li->l.current_pts = pts;
+        li->l.current_pts_us = av_rescale_q(pts, link->time_base, AV_TIME_BASE_Q);
+        /* TODO use duration */
+        ff_avfilter_graph_update_heap(li->l.graph, li);
+        ff_graph_state_unlock(li->l.graph);
+        return;
+    }
     li->l.current_pts = pts;
     li->l.current_pts_us = av_rescale_q(pts, link->time_base, AV_TIME_BASE_Q);
-    /* TODO use duration */
-    if (li->l.graph && li->age_index >= 0)
-        ff_avfilter_graph_update_heap(li->l.graph, li);
 }
 
 void ff_filter_set_ready(AVFilterContext *filter, unsigned priority)
 {
     FFFilterContext *ctxi = fffilterctx(filter);
+    ff_graph_state_lock(filter->graph);
     ctxi->ready = FFMAX(ctxi->ready, priority);
+    ff_graph_state_unlock(filter->graph);
 }
 
 /**
@@ -242,7 +253,9 @@ static void filter_unblock(AVFilterContext *filter)
 
     for (i = 0; i < filter->nb_outputs; i++) {
         FilterLinkInternal * const li = ff_link_internal(filter->outputs[i]);
+        ff_link_lock(li);
         li->frame_blocked_in = 0;
+        ff_link_unlock(li);
     }
 }
 
@@ -251,13 +264,18 @@ void ff_avfilter_link_set_in_status(AVFilterLink *link, int status, int64_t pts)
 {
     FilterLinkInternal * const li = ff_link_internal(link);
 
-    if (li->status_in == status)
+    ff_link_lock(li);
+    if (li->status_in) {
+        /* the destination may have closed the link in the meantime */
+        av_assert0(li->status_in == status || li->status_out);
+        ff_link_unlock(li);
         return;
-    av_assert0(!li->status_in);
+    }
     li->status_in = status;
     li->status_in_pts = pts;
     li->frame_wanted_out = 0;
     li->frame_blocked_in = 0;
+    ff_link_unlock(li);
     filter_unblock(link->dst);
     ff_filter_set_ready(link->dst, 200);
 }
@@ -270,9 +288,11 @@ static void link_set_out_status(AVFilterLink *link, int status, int64_t pts)
 {
     FilterLinkInternal * const li = ff_link_internal(link);
 
+    ff_link_lock(li);
     av_assert0(!li->frame_wanted_out);
     av_assert0(!li->status_out);
     li->status_out = status;
+    ff_link_unlock(li);
     if (pts != AV_NOPTS_VALUE)
         update_link_current_pts(li, pts);
     filter_unblock(link->dst);
@@ -489,20 +509,28 @@ int ff_request_frame(AVFilterLink *link)
     av_assert1(!fffilter(link->dst->filter)->activate);
     if (li->status_out)
         return li->status_out;
+    ff_link_lock(li);
     if (li->status_in) {
+        int status = li->status_in;
+        int64_t pts = li->status_in_pts;
+
         if (ff_framequeue_queued_frames(&li->fifo)) {
             av_assert1(!li->frame_wanted_out);
-            av_assert1(fffilterctx(link->dst)->ready >= 300);
+            av_assert1(fffiltergraph(link->dst->graph)->concurrent ||
+                       fffilterctx(link->dst)->ready >= 300);
+            ff_link_unlock(li);
             return 0;
         } else {
+            ff_link_unlock(li);
             /* Acknowledge status change. Filters using ff_request_frame() will
                handle the change automatically. Filters can also check the
                status directly but none do yet. */
-            link_set_out_status(link, li->status_in, li->status_in_pts);
+            link_set_out_status(link, status, pts);
             return li->status_out;
         }
     }
     li->frame_wanted_out = 1;
+    ff_link_unlock(li);
     ff_filter_set_ready(link->src, 100);
     return 0;
 }
@@ -522,7 +550,9 @@ static int64_t guess_status_pts(AVFilterContext *ctx, int status, AVRational lin
     av_log(ctx, AV_LOG_WARNING, "EOF timestamp not reliable\n");
     for (i = 0; i < ctx->nb_inputs; i++) {
         FilterLinkInternal * const li = ff_link_internal(ctx->inputs[i]);
+        ff_link_lock(li);
         r = FFMIN(r, av_rescale_q(li->status_in_pts, ctx->inputs[i]->time_base, link_time_base));
+        ff_link_unlock(li);
     }
     if (r < INT64_MAX)
         return r;
@@ -536,13 +566,15 @@ static int request_frame_to_filter(AVFilterLink *link)
 
     FF_TPRINTF_START(NULL, request_frame_to_filter); ff_tlog_link(NULL, link, 1);
     /* Assume the filter is blocked, let the method clear it if not */
+    ff_link_lock(li);
     li->frame_blocked_in = 1;
+    ff_link_unlock(li);
     if (link->srcpad->request_frame)
         ret = link->srcpad->request_frame(link);
     else if (link->src->inputs[0])
         ret = ff_request_frame(link->src->inputs[0]);
     if (ret < 0) {
-        if (ret != AVERROR(EAGAIN) && ret != li->status_in)
+        if (ret != AVERROR(EAGAIN) && ret != ff_outlink_get_status(link))
             ff_avfilter_link_set_in_status(link, ret, guess_status_pts(link->src, ret, link->time_base));
         if (ret == AVERROR_EOF)
             ret = 0;
@@ -835,6 +867,9 @@ void avfilter_free(AVFilterContext *filter)
     av_freep(&filter->priv);
     while (ctxi->command_queue)
         command_queue_pop(filter);
+    av_freep(&ctxi->frame_thread_frames);
+    av_freep(&ctxi->frame_thread_rets);
+    av_freep(&ctxi->frame_thread_disabled);
     av_opt_free(filter);
     av_expr_free(ctxi->enable);
     ctxi->enable = NULL;
@@ -931,7 +966,18 @@ int avfilter_init_dict(AVFilterContext *ctx, AVDictionary **options)
         return ret;
     }
 
-    if (ctx->filter->flags & AVFILTER_FLAG_SLICE_THREADS &&
+    /* Frame threading is only enabled through the graph, filters which have
+     * threading disabled stay serial. It takes precedence, the slice jobs of
+     * a frame-threaded filter are run serially by its frame threads. */
+    if (ctx->filter->flags & AVFILTER_FLAG_FRAME_THREADS &&
+        ctx->thread_type && ctx->graph->thread_type & AVFILTER_THREAD_FRAME &&
+        fffiltergraph(ctx->graph)->thread_execute &&
+        ff_filter_get_nb_threads(ctx) > 1) {
+        av_assert1(fffilter(ctx->filter)->process_frame &&
+                   !fffilter(ctx->filter)->activate &&
+                   ctx->nb_inputs == 1 && ctx->nb_outputs == 1);
+        ctx->thread_type = AVFILTER_THREAD_FRAME;
+    } else if (ctx->filter->flags & AVFILTER_FLAG_SLICE_THREADS &&
         ctx->thread_type & ctx->graph->thread_type & AVFILTER_THREAD_SLICE &&
         fffiltergraph(ctx->graph)->thread_execute) {
         ctx->thread_type       = AVFILTER_THREAD_SLICE;
@@ -940,11 +986,25 @@ int avfilter_init_dict(AVFilterContext *ctx, AVDictionary **options)
         ctx->thread_type = 0;
     }
 
+    /* init() may clear AVFILTER_THREAD_FRAME if the configuration of this
+     * instance keeps state between frames. */
     if (fffilter(ctx->filter)->init)
         ret = fffilter(ctx->filter)->init(ctx);
     if (ret < 0)
         return ret;
 
+    if (ctx->thread_type & AVFILTER_THREAD_FRAME) {
+        int nb_threads = ff_filter_get_nb_threads(ctx);
+
+        ctxi->frame_thread_frames   = av_calloc(nb_threads, sizeof(*ctxi->frame_thread_frames));
+        ctxi->frame_thread_rets     = av_calloc(nb_threads, sizeof(*ctxi->frame_thread_rets));
+        ctxi->frame_thread_disabled = av_calloc(nb_threads, sizeof(*ctxi->frame_thread_disabled));
+        if (!ctxi->frame_thread_frames || !ctxi->frame_thread_rets ||
+            !ctxi->frame_thread_disabled)
+            return AVERROR(ENOMEM);
+        ctxi->nb_frame_threads = nb_threads;
+    }
+
     if (ctx->enable_str) {
         ret = set_enable_expr(ctxi, ctx->enable_str);
         if (ret < 0)
@@ -1102,11 +1162,14 @@ int ff_filter_frame(AVFilterLink *link, AVFrame *frame)
                                        link->time_base);
     }
 
-    li->frame_blocked_in = li->frame_wanted_out = 0;
+    ff_link_lock(li);
+    li->frame_wanted_out = 0;
+    li->frame_blocked_in = 0;
     li->l.frame_count_in++;
     li->l.sample_count_in += frame->nb_samples;
-    filter_unblock(link->dst);
     ret = ff_framequeue_add(&li->fifo, frame);
+    ff_link_unlock(li);
+    filter_unblock(link->dst);
     if (ret < 0) {
         av_frame_free(&frame);
         return ret;
@@ -1194,7 +1257,7 @@ static int filter_frame_to_filter(AVFilterLink *link)
     AVFilterContext *dst = link->dst;
     int ret;
 
-    av_assert1(ff_framequeue_queued_frames(&li->fifo));
+    av_assert1(ff_inlink_queued_frames(link));
     ret = li->l.min_samples ?
           ff_inlink_consume_samples(link, li->l.min_samples, li->l.max_samples, &frame) :
           ff_inlink_consume_frame(link, &frame);
@@ -1232,9 +1295,7 @@ static int forward_status_change(AVFilterContext *filter, FilterLinkInternal *li
         return 0;
     }
     while (!li_in->status_out) {
-        FilterLinkInternal *li_out = ff_link_internal(filter->outputs[out]);
-
-        if (!li_out->status_in) {
+        if (!ff_outlink_get_status(filter->outputs[out])) {
             progress++;
             ret = request_frame_to_filter(filter->outputs[out]);
             if (ret < 0)
@@ -1255,6 +1316,92 @@ static int forward_status_change(AVFilterContext *filter, FilterLinkInternal *li
     return 0;
 }
 
+static int frame_thread_job(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    FFFilterContext *ctxi = fffilterctx(ctx);
+    AVFrame *in = ctxi->frame_thread_frames[jobnr];
+
+    if (ctxi->frame_thread_disabled[jobnr])
+        return 0;
+    ctxi->frame_thread_frames[jobnr] = NULL;
+    return fffilter(ctx->filter)->process_frame(ctx, in, &ctxi->frame_thread_frames[jobnr], jobnr);
+}
+
+/**
+ * Filter up to nb_frame_threads frames of the input concurrently and send
+ * the results in order. Waits until enough frames are queued, unless the
+ * input has reached its end.
+ */
+static int filter_frames_threaded(AVFilterContext *filter)
+{
+    FFFilterContext *ctxi = fffilterctx(filter);
+    FFFilterGraph *graphi = fffiltergraph(filter->graph);
+    AVFilterLink *inlink  = filter->inputs[0];
+    AVFilterLink *outlink = filter->outputs[0];
+    FilterLinkInternal * const li = ff_link_internal(inlink);
+    size_t queued = ff_inlink_queued_frames(inlink);
+    int nb_frames = FFMIN(queued, ctxi->nb_frame_threads);
+    int concurrent, status, ret = 0;
+
+    /* queued commands must apply between the right frames */
+    if (!nb_frames || ctxi->command_queue)
+        return FFERROR_NOT_READY;
+    ff_link_lock(li);
+    status = li->status_in;
+    ff_link_unlock(li);
+    if (nb_frames < ctxi->nb_frame_threads && !status) {
+        FF_FILTER_FORWARD_WANTED(outlink, inlink);
+        return 0;
+    }
+
+    for (int i = 0; i < nb_frames; i++) {
+        AVFrame *frame;
+
+        ret = ff_inlink_consume_frame(inlink, &frame);
+        av_assert1(ret);
+        if (ret >= 0 && inlink->dstpad->flags & AVFILTERPAD_FLAG_NEEDS_WRITABLE)
+            ret = ff_inlink_make_frame_writable(inlink, &frame);
+        if (ret < 0) {
+            nb_frames = i;
+            break;
+        }
+        ctxi->frame_thread_frames[i]   = frame;
+        ctxi->frame_thread_disabled[i] = filter->is_disabled &&
+            (filter->filter->flags & AVFILTER_FLAG_SUPPORT_TIMELINE_GENERIC);
+    }
+    filter_unblock(filter);
+
+    if (ret >= 0) {
+        /* output buffers are allocated from the threads */
+        concurrent = graphi->concurrent;
+        if (!concurrent)
+            graphi->concurrent = 1;
+        graphi->thread_execute(filter, frame_thread_job, NULL,
+                               ctxi->frame_thread_rets, nb_frames);
+        if (!concurrent)
+            graphi->concurrent = 0;
+    }
+
+    for (int i = 0; i < nb_frames; i++) {
+        AVFrame *frame = ctxi->frame_thread_frames[i];
+
+        ctxi->frame_thread_frames[i] = NULL;
+        if (ret >= 0 && !ctxi->frame_thread_disabled[i])
+            ret = ctxi->frame_thread_rets[i];
+        if (ret < 0 || !frame) {
+            av_frame_free(&frame);
+            continue;
+        }
+        ret = ff_filter_frame(outlink, frame);
+    }
+
+    if (ret < 0 && ret != li->status_out)
+        link_set_out_status(inlink, ret, AV_NOPTS_VALUE);
+    else
+        ff_filter_set_ready(filter, 300);
+    return ret;
+}
+
 static int filter_activate_default(AVFilterContext *filter)
 {
     unsigned i;
@@ -1268,29 +1415,45 @@ static int filter_activate_default(AVFilterContext *filter)
         return 0;
     }
 
+    if (filter->thread_type & AVFILTER_THREAD_FRAME) {
+        int ret = filter_frames_threaded(filter);
+        if (ret != FFERROR_NOT_READY)
+            return ret;
+    }
+
     for (i = 0; i < filter->nb_inputs; i++) {
         FilterLinkInternal *li = ff_link_internal(filter->inputs[i]);
-        if (samples_ready(li, li->l.min_samples)) {
+        int ready;
+
+        ff_link_lock(li);
+        ready = samples_ready(li, li->l.min_samples);
+        ff_link_unlock(li);
+        if (ready)
             return filter_frame_to_filter(filter->inputs[i]);
-        }
     }
     for (i = 0; i < filter->nb_inputs; i++) {
         FilterLinkInternal * const li = ff_link_internal(filter->inputs[i]);
-        if (li->status_in && !li->status_out) {
-            av_assert1(!ff_framequeue_queued_frames(&li->fifo));
+        int pending;
+
+        ff_link_lock(li);
+        pending = li->status_in && !li->status_out;
+        av_assert1(!pending || !ff_framequeue_queued_frames(&li->fifo));
+        ff_link_unlock(li);
+        if (pending)
             return forward_status_change(filter, li);
-        }
     }
     for (i = 0; i < filter->nb_outputs; i++) {
         FilterLinkInternal * const li = ff_link_internal(filter->outputs[i]);
-        if (li->frame_wanted_out &&
-            !li->frame_blocked_in) {
+        int wanted;
+
+        ff_link_lock(li);
+        wanted = li->frame_wanted_out && !li->frame_blocked_in;
+        ff_link_unlock(li);
+        if (wanted)
             return request_frame_to_filter(filter->outputs[i]);
-        }
     }
     for (i = 0; i < filter->nb_outputs; i++) {
-        FilterLinkInternal * const li = ff_link_internal(filter->outputs[i]);
-        if (li->frame_wanted_out)
+        if (ff_outlink_frame_wanted(filter->outputs[i]))
             return request_frame_to_filter(filter->outputs[i]);
     }
     if (!filter->nb_outputs) {
@@ -1452,7 +1615,9 @@ int ff_filter_activate(AVFilterContext *filter)
     /* Generic timeline support is not yet implemented but should be easy */
     av_assert1(!(fi->p.flags & AVFILTER_FLAG_SUPPORT_TIMELINE_GENERIC &&
                  fi->activate));
+    ff_graph_state_lock(filter->graph);
     ctxi->ready = 0;
+    ff_graph_state_unlock(filter->graph);
     ret = fi->activate ? fi->activate(filter) : filter_activate_default(filter);
     if (ret == FFERROR_NOT_READY)
         ret = 0;
@@ -1462,15 +1627,22 @@ int ff_filter_activate(AVFilterContext *filter)
 int ff_inlink_acknowledge_status(AVFilterLink *link, int *rstatus, int64_t *rpts)
 {
     FilterLinkInternal * const li = ff_link_internal(link);
+    int64_t pts;
+
     *rpts = li->l.current_pts;
-    if (ff_framequeue_queued_frames(&li->fifo))
+    ff_link_lock(li);
+    if (ff_framequeue_queued_frames(&li->fifo)) {
+        ff_link_unlock(li);
         return *rstatus = 0;
-    if (li->status_out)
+    }
+    if (li->status_out || !li->status_in) {
+        ff_link_unlock(li);
         return *rstatus = li->status_out;
-    if (!li->status_in)
-        return *rstatus = 0;
+    }
     *rstatus = li->status_out = li->status_in;
-    update_link_current_pts(li, li->status_in_pts);
+    pts = li->status_in_pts;
+    ff_link_unlock(li);
+    update_link_current_pts(li, pts);
     *rpts = li->l.current_pts;
     return 1;
 }
@@ -1478,29 +1650,48 @@ int ff_inlink_acknowledge_status(AVFilterLink *link, int *rstatus, int64_t *rpts
 size_t ff_inlink_queued_frames(AVFilterLink *link)
 {
     FilterLinkInternal * const li = ff_link_internal(link);
-    return ff_framequeue_queued_frames(&li->fifo);
+    size_t ret;
+
+    ff_link_lock(li);
+    ret = ff_framequeue_queued_frames(&li->fifo);
+    ff_link_unlock(li);
+    return ret;
 }
 
 int ff_inlink_check_available_frame(AVFilterLink *link)
 {
-    FilterLinkInternal * const li = ff_link_internal(link);
-    return ff_framequeue_queued_frames(&li->fifo) > 0;
+    return ff_inlink_queued_frames(link) > 0;
 }
 
 int ff_inlink_queued_samples(AVFilterLink *link)
 {
     FilterLinkInternal * const li = ff_link_internal(link);
-    return ff_framequeue_queued_samples(&li->fifo);
+    int ret;
+
+    ff_link_lock(li);
+    ret = ff_framequeue_queued_samples(&li->fifo);
+    ff_link_unlock(li);
+    return ret;
 }
 
-int ff_inlink_check_available_samples(AVFilterLink *link, unsigned min)
+static int check_available_samples(FilterLinkInternal *li, unsigned min)
 {
-    FilterLinkInternal * const li = ff_link_internal(link);
     uint64_t samples = ff_framequeue_queued_samples(&li->fifo);
     av_assert1(min);
     return samples >= min || (li->status_in && samples);
 }
 
+int ff_inlink_check_available_samples(AVFilterLink *link, unsigned min)
+{
+    FilterLinkInternal * const li = ff_link_internal(link);
+    int ret;
+
+    ff_link_lock(li);
+    ret = check_available_samples(li, min);
+    ff_link_unlock(li);
+    return ret;
+}
+
 static void consume_update(FilterLinkInternal *li, const AVFrame *frame)
 {
     AVFilterLink *const link = &li->l.pub;
@@ -1518,15 +1709,20 @@ int ff_inlink_consume_frame(AVFilterLink *link, AVFrame **rframe)
     AVFrame *frame;
 
     *rframe = NULL;
-    if (!ff_inlink_check_available_frame(link))
+    ff_link_lock(li);
+    if (!ff_framequeue_queued_frames(&li->fifo)) {
+        ff_link_unlock(li);
         return 0;
+    }
 
     if (li->fifo.samples_skipped) {
-        frame = ff_framequeue_peek(&li->fifo, 0);
-        return ff_inlink_consume_samples(link, frame->nb_samples, frame->nb_samples, rframe);
+        int nb_samples = ff_framequeue_peek(&li->fifo, 0)->nb_samples;
+        ff_link_unlock(li);
+        return ff_inlink_consume_samples(link, nb_samples, nb_samples, rframe);
     }
 
     frame = ff_framequeue_take(&li->fifo);
+    ff_link_unlock(li);
     consume_update(li, frame);
     *rframe = frame;
     return 1;
@@ -1541,11 +1737,15 @@ int ff_inlink_consume_samples(AVFilterLink *link, unsigned min, unsigned max,
 
     av_assert1(min);
     *rframe = NULL;
-    if (!ff_inlink_check_available_samples(link, min))
+    ff_link_lock(li);
+    if (!check_available_samples(li, min)) {
+        ff_link_unlock(li);
         return 0;
+    }
     if (li->status_in)
         min = FFMIN(min, ff_framequeue_queued_samples(&li->fifo));
     ret = take_samples(li, min, max, &frame);
+    ff_link_unlock(li);
     if (ret < 0)
         return ret;
     consume_update(li, frame);
@@ -1556,7 +1756,13 @@ int ff_inlink_consume_samples(AVFilterLink *link, unsigned min, unsigned max,
 AVFrame *ff_inlink_peek_frame(AVFilterLink *link, size_t idx)
 {
     FilterLinkInternal * const li = ff_link_internal(link);
-    return ff_framequeue_peek(&li->fifo, idx);
+    AVFrame *frame;
+
+    /* only the destination takes frames, so the frame itself stays valid */
+    ff_link_lock(li);
+    frame = ff_framequeue_peek(&li->fifo, idx);
+    ff_link_unlock(li);
+    return frame;
 }
 
 int ff_inlink_make_frame_writable(AVFilterLink *link, AVFrame **rframe)
@@ -1617,10 +1823,13 @@ int ff_inlink_process_commands(AVFilterLink *link, const AVFrame *frame)
 
 void ff_inlink_request_frame(AVFilterLink *link)
 {
-    av_unused FilterLinkInternal *li = ff_link_internal(link);
-    av_assert1(!li->status_in);
+    FilterLinkInternal * const li = ff_link_internal(link);
+
+    ff_link_lock(li);
+    av_assert1(fffiltergraph(link->dst->graph)->concurrent || !li->status_in);
     av_assert1(!li->status_out);
     li->frame_wanted_out = 1;
+    ff_link_unlock(li);
     ff_filter_set_ready(link->src, 100);
 }
 
@@ -1629,21 +1838,30 @@ void ff_inlink_set_status(AVFilterLink *link, int status)
     FilterLinkInternal * const li = ff_link_internal(link);
     if (li->status_out)
         return;
+    ff_link_lock(li);
     li->frame_wanted_out = 0;
     li->frame_blocked_in = 0;
+    ff_link_unlock(li);
     link_set_out_status(link, status, AV_NOPTS_VALUE);
+    ff_link_lock(li);
     while (ff_framequeue_queued_frames(&li->fifo)) {
            AVFrame *frame = ff_framequeue_take(&li->fifo);
            av_frame_free(&frame);
     }
     if (!li->status_in)
         li->status_in = status;
+    ff_link_unlock(li);
 }
 
 int ff_outlink_get_status(AVFilterLink *link)
 {
     FilterLinkInternal * const li = ff_link_internal(link);
-    return li->status_in;
+    int ret;
+
+    ff_link_lock(li);
+    ret = li->status_in;
+    ff_link_unlock(li);
+    return ret;
 }
 
 int ff_inoutlink_check_flow(AVFilterLink *inlink, AVFilterLink *outlink)
@@ -1685,7 +1903,12 @@ int ff_filter_init_hw_frames(AVFilterContext *avctx, AVFilterLink *link,
 int ff_outlink_frame_wanted(AVFilterLink *link)
 {
     FilterLinkInternal * const li = ff_link_internal(link);
-    return li->frame_wanted_out;
+    int ret;
+
+    ff_link_lock(li);
+    ret = li->frame_wanted_out;
+    ff_link_unlock(li);
+    return ret;
 }
 
 int ff_filter_execute(AVFilterContext *ctx, avfilter_action_func *func,
@@ -1693,3 +1916,13 @@ int ff_filter_execute(AVFilterContext *ctx, avfilter_action_func *func,
 {
     return fffilterctx(ctx)->execute(ctx, func, arg, ret, nb_jobs);
 }
+
+int ff_filter_execute_is_concurrent(AVFilterContext *ctx)
+{
+    FFFilterGraph *graphi = fffiltergraph(ctx->graph);
+
+    /* the internal thread pool is only created without a custom execute;
+     * filters running on it execute their jobs one after another */
+    return ctx->thread_type & AVFILTER_THREAD_SLICE &&
+           graphi->thread && !graphi->concurrent;
+}
@@ -186,6 +186,12 @@ typedef struct AVFilterFormatsConfig {
  * The filter can create hardware frames using AVFilterContext.hw_device_ctx.
  */
 #define AVFILTER_FLAG_HWDEVICE              (1 << 4)
+
+/**
+ * The filter supports frame multithreading, i.e. it can process several
+ * frames of its input concurrently, see AVFILTER_THREAD_FRAME.
+ */
+#define AVFILTER_FLAG_FRAME_THREADS         (1 << 5)
 /**
  * Some filters support a generic "enable" expression option that can be used
  * to enable or disable a filter in the timeline. Filters supporting this
@@ -270,6 +276,18 @@ unsigned avfilter_filter_pad_count(const AVFilter *filter, int is_output);
  */
 #define AVFILTER_THREAD_SLICE (1 << 0)
 
+/**
+ * Activate independent filters of a graph concurrently. Only meaningful for
+ * AVFilterGraph.thread_type, and not enabled by default.
+ */
+#define AVFILTER_THREAD_GRAPH (1 << 1)
+
+/**
+ * Process several frames concurrently. Filters supporting it delay their
+ * output by up to nb_threads - 1 frames. Not enabled by default.
+ */
+#define AVFILTER_THREAD_FRAME (1 << 2)
+
 /** An instance of a filter */
 typedef struct AVFilterContext {
     const AVClass *av_class;        ///< needed for av_log() and filters common options
@@ -598,7 +616,9 @@ typedef struct AVFilterGraph {
      * of AVFILTER_THREAD_* flags.
      *
      * May be set by the caller at any point, the setting will apply to all
-     * filters initialized after that. The default is allowing everything.
+     * filters initialized after that. The default is allowing everything
+     * except AVFILTER_THREAD_FRAME and AVFILTER_THREAD_GRAPH; the latter
+     * must be set before adding any filters to the graph.
      *
      * When a filter in this graph is initialized, this field is combined using
      * bit AND with AVFilterContext.thread_type to get the final mask used for
@@ -27,6 +27,8 @@
 
 #include <stdint.h>
 
+#include "libavutil/thread.h"
+
 #include "avfilter.h"
 #include "filters.h"
 #include "framequeue.h"
@@ -85,6 +87,14 @@ typedef struct FilterLinkInternal {
         AVLINK_STARTINIT,       ///< started, but incomplete
         AVLINK_INIT             ///< complete
     } init_state;
+
+    /**
+     * Protects fifo, status_in, status_out, frame_wanted_out and
+     * frame_blocked_in while the filters on both ends of the link may run
+     * concurrently, see FFFilterGraph.concurrent. Never held while taking
+     * another link lock.
+     */
+    AVMutex lock;
 } FilterLinkInternal;
 
 static inline FilterLinkInternal *ff_link_internal(AVFilterLink *link)
@@ -116,6 +126,16 @@ typedef struct FFFilterContext {
     double *var_values;
 
     struct AVFilterCommand *command_queue;
+
+    /**
+     * Frames being filtered concurrently with AVFILTER_THREAD_FRAME, the
+     * return values of FFFilter.process_frame() and whether the timeline
+     * disabled the filter for each of them.
+     */
+    AVFrame **frame_thread_frames;
+    int      *frame_thread_rets;
+    uint8_t  *frame_thread_disabled;
+    int    nb_frame_threads;
 } FFFilterContext;
 
 static inline FFFilterContext *fffilterctx(AVFilterContext *ctx)
@@ -145,6 +165,26 @@ typedef struct FFFilterGraph {
     void *thread;
     avfilter_execute_func *thread_execute;
     FFFrameQueueGlobal frame_queues;
+
+    /**
+     * Activate nb_filters distinct filters concurrently on the slice threads
+     * and store the return value of ff_filter_activate() for each in rets.
+     * Only set if AVFILTER_THREAD_GRAPH is in use.
+     */
+    void (*thread_activate)(struct FFFilterGraph *graph, AVFilterContext **filters,
+                            int *rets, int nb_filters);
+    AVFilterContext **activate_filters;
+    int              *activate_rets;
+
+    /**
+     * Set while thread_activate() is running or frames of a filter are
+     * processed on the slice threads. The state of a link shared by its two
+     * ends must then only be accessed with the lock of the link held, and
+     * the readiness of the filters, their frame pools and the sink links heap
+     * with state_lock held, including by the filter they belong to.
+     */
+    int concurrent;
+    AVMutex state_lock;
 } FFFilterGraph;
 
 static inline FFFilterGraph *fffiltergraph(AVFilterGraph *graph)
@@ -152,6 +192,30 @@ static inline FFFilterGraph *fffiltergraph(AVFilterGraph *graph)
     return (FFFilterGraph*)graph;
 }
 
+static inline void ff_graph_state_lock(AVFilterGraph *graph)
+{
+    if (graph && fffiltergraph(graph)->concurrent)
+        ff_mutex_lock(&fffiltergraph(graph)->state_lock);
+}
+
+static inline void ff_graph_state_unlock(AVFilterGraph *graph)
+{
+    if (graph && fffiltergraph(graph)->concurrent)
+        ff_mutex_unlock(&fffiltergraph(graph)->state_lock);
+}
+
+static inline void ff_link_lock(FilterLinkInternal *li)
+{
+    if (li->l.graph && fffiltergraph(li->l.graph)->concurrent)
+        ff_mutex_lock(&li->lock);
+}
+
+static inline void ff_link_unlock(FilterLinkInternal *li)
+{
+    if (li->l.graph && fffiltergraph(li->l.graph)->concurrent)
+        ff_mutex_unlock(&li->lock);
+}
+
 /**
  * Update the position of a link in the age heap.
  */
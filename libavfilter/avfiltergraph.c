@@ -49,6 +49,8 @@ static const AVOption filtergraph_options[] = {
     { "thread_type", "Allowed thread types", OFFSET(thread_type), AV_OPT_TYPE_FLAGS,
         { .i64 = AVFILTER_THREAD_SLICE }, 0, INT_MAX, F|V|A, .unit = "thread_type" },
         { "slice", NULL, 0, AV_OPT_TYPE_CONST, { .i64 = AVFILTER_THREAD_SLICE }, .flags = F|V|A, .unit = "thread_type" },
+        { "graph", "activate independent filters concurrently", 0, AV_OPT_TYPE_CONST, { .i64 = AVFILTER_THREAD_GRAPH }, .flags = F|V|A, .unit = "thread_type" },
+        { "frame", "process several frames of a filter concurrently", 0, AV_OPT_TYPE_CONST, { .i64 = AVFILTER_THREAD_FRAME }, .flags = F|V|A, .unit = "thread_type" },
     { "threads",     "Maximum number of threads", OFFSET(nb_threads), AV_OPT_TYPE_INT,
         { .i64 = 0 }, 0, INT_MAX, F|V|A, .unit = "threads"},
         {"auto", "autodetect a suitable number of threads to use", 0, AV_OPT_TYPE_CONST, {.i64 = 0 }, .flags = F|V|A, .unit = "threads"},
@@ -94,6 +96,7 @@ AVFilterGraph *avfilter_graph_alloc(void)
     ret->av_class = &filtergraph_class;
     av_opt_set_defaults(ret);
     ff_framequeue_global_init(&graph->frame_queues);
+    ff_mutex_init(&graph->state_lock, NULL);
 
     return ret;
 }
@@ -128,6 +131,7 @@ void avfilter_graph_free(AVFilterGraph **graphp)
         avfilter_free(graph->filters[0]);
 
     ff_graph_thread_free(graphi);
+    ff_mutex_destroy(&graphi->state_lock);
 
     av_freep(&graphi->sink_links);
 
@@ -1613,12 +1617,83 @@ int avfilter_graph_request_oldest(AVFilterGraph *graph)
     return 0;
 }
 
+/**
+ * Filters that reach beyond their own links (e.g. sending commands to other
+ * filters) or that drive a hardware device are never activated together
+ * with other filters.
+ */
+static int filter_needs_exclusive_activation(const AVFilterContext *ctx)
+{
+    return fffilter(ctx->filter)->flags_internal &
+           (FF_FILTER_FLAG_GRAPH_EXCLUSIVE | FF_FILTER_FLAG_HWFRAME_AWARE);
+}
+
+/**
+ * Pick up to nb_threads ready filters, in decreasing order of readiness,
+ * and activate them concurrently. Filters sharing a link synchronize on the
+ * lock of the link. The filter with the highest readiness is always picked,
+ * so progress is the same as with the serial path.
+ */
+static int graph_run_once_concurrent(AVFilterGraph *graph)
+{
+    FFFilterGraph *graphi = fffiltergraph(graph);
+    AVFilterContext **batch = graphi->activate_filters;
+    int *rets = graphi->activate_rets;
+    int nb_batch = 0, ret = 0;
+
+    while (nb_batch < graph->nb_threads) {
+        AVFilterContext *best = NULL;
+        unsigned best_ready = 0;
+
+        for (unsigned i = 0; i < graph->nb_filters; i++) {
+            AVFilterContext *ctx = graph->filters[i];
+            unsigned ready = fffilterctx(ctx)->ready;
+            int j;
+
+            if (ready <= best_ready)
+                continue;
+            if (nb_batch && filter_needs_exclusive_activation(ctx))
+                continue;
+            for (j = 0; j < nb_batch; j++)
+                if (batch[j] == ctx)
+                    break;
+            if (j < nb_batch)
+                continue;
+            best       = ctx;
+            best_ready = ready;
+        }
+        if (!best)
+            break;
+        batch[nb_batch++] = best;
+        if (filter_needs_exclusive_activation(best))
+            break;
+    }
+
+    if (!nb_batch)
+        return AVERROR(EAGAIN);
+    if (nb_batch == 1)
+        return ff_filter_activate(batch[0]);
+
+    graphi->thread_activate(graphi, batch, rets, nb_batch);
+
+    /* Report the result of the filter the serial path would have picked,
+     * unless another one failed. */
+    ret = rets[0];
+    for (int i = 1; i < nb_batch; i++)
+        if (rets[i] < 0 && rets[i] != FFERROR_BUFFERSRC_EMPTY &&
+            (ret >= 0 || ret == FFERROR_BUFFERSRC_EMPTY))
+            ret = rets[i];
+    return ret;
+}
+
 int ff_filter_graph_run_once(AVFilterGraph *graph)
 {
     FFFilterContext *ctxi;
     unsigned i;
 
     av_assert0(graph->nb_filters);
+    if (fffiltergraph(graph)->thread_activate)
+        return graph_run_once_concurrent(graph);
     ctxi = fffilterctx(graph->filters[0]);
     for (i = 1; i < graph->nb_filters; i++) {
         FFFilterContext *ctxi_other = fffilterctx(graph->filters[i]);
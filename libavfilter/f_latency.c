@@ -106,6 +106,7 @@ const FFFilter ff_vf_latency = {
     .p.flags       = AVFILTER_FLAG_SUPPORT_TIMELINE_INTERNAL |
                      AVFILTER_FLAG_METADATA_ONLY,
     .priv_size     = sizeof(LatencyContext),
+    .flags_internal = FF_FILTER_FLAG_GRAPH_EXCLUSIVE,
     .init          = init,
     .uninit        = uninit,
     .activate      = activate,
@@ -122,6 +123,7 @@ const FFFilter ff_af_alatency = {
     .p.description = NULL_IF_CONFIG_SMALL("Report audio filtering latency."),
     .p.flags       = AVFILTER_FLAG_SUPPORT_TIMELINE_INTERNAL,
     .priv_size     = sizeof(LatencyContext),
+    .flags_internal = FF_FILTER_FLAG_GRAPH_EXCLUSIVE,
     .init          = init,
     .uninit        = uninit,
     .activate      = activate,
@@ -207,6 +207,12 @@ static inline FilterLink* ff_filter_link(AVFilterLink *link)
  */
 #define FF_FILTER_FLAG_HWFRAME_AWARE (1 << 0)
 
+/**
+ * The filter accesses other filters of its graph, e.g. by sending them
+ * commands, and must not be activated concurrently with any other filter.
+ */
+#define FF_FILTER_FLAG_GRAPH_EXCLUSIVE (1 << 1)
+
 /**
  * Find the index of a link.
  *
@@ -459,6 +465,28 @@ typedef struct FFFilter {
      * activation.
      */
     int (*activate)(AVFilterContext *ctx);
+
+    /**
+     * Filter a single frame, for filters with AVFILTER_FLAG_FRAME_THREADS.
+     *
+     * With frame threading, this is called concurrently for several frames
+     * of the only input, and the output frames are sent in order by the
+     * generic code. It must therefore not modify the filter private context
+     * or anything else shared between frames, nor rely on link state like
+     * frame_count_out; jobnr is unique among the concurrent calls and lower
+     * than ff_filter_get_nb_threads(), and may be used to select per-thread
+     * scratch buffers.
+     *
+     * Filters without frame threading are driven by the filter_frame()
+     * callback of their input pad as usual, which would typically call this
+     * with jobnr 0.
+     *
+     * @param in   the input frame, owned by the callee
+     * @param out  set to the output frame, which may be in, or to NULL if no
+     *             frame is to be output
+     * @return >= 0 on success, a negative AVERROR code on failure
+     */
+    int (*process_frame)(AVFilterContext *ctx, AVFrame *in, AVFrame **out, int jobnr);
 } FFFilter;
 
 static inline const FFFilter *fffilter(const AVFilter *f)
@@ -819,4 +847,15 @@ int ff_pixfmt_is_in(enum AVPixelFormat fmt, const enum AVPixelFormat *fmts);
 int ff_filter_execute(AVFilterContext *ctx, avfilter_action_func *func,
                       void *arg, int *ret, int nb_jobs);
 
+/**
+ * Tell whether the jobs of ff_filter_execute() are guaranteed to run at
+ * the same time, so that a job may wait for another one. This is only the
+ * case with the internal slice threads of the graph, for at most
+ * ff_filter_get_nb_threads() jobs, unless the filter itself runs on them;
+ * a custom AVFilterGraph.execute may run the jobs one after another.
+ *
+ * @return 1 if the jobs run concurrently, 0 otherwise
+ */
+int ff_filter_execute_is_concurrent(AVFilterContext *ctx);
+
 #endif /* AVFILTER_FILTERS_H */
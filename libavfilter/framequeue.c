@@ -31,7 +31,7 @@ static inline FFFrameBucket *bucket(FFFrameQueue *fq, size_t idx)
 void ff_framequeue_global_init(FFFrameQueueGlobal *fqg)
 {
     fqg->max_queued = SIZE_MAX;
-    fqg->queued = 0;
+    atomic_init(&fqg->queued, 0);
 }
 
 static void check_consistency(FFFrameQueue *fq)
@@ -69,7 +69,7 @@ int ff_framequeue_add(FFFrameQueue *fq, AVFrame *frame)
     FFFrameBucket *b;
 
     check_consistency(fq);
-    if (fq->global->queued >= fq->global->max_queued)
+    if (atomic_load_explicit(&fq->global->queued, memory_order_relaxed) >= fq->global->max_queued)
         return AVERROR(ENOMEM);
     if (fq->queued == fq->allocated) {
         if (fq->allocated == 1) {
@@ -94,7 +94,7 @@ int ff_framequeue_add(FFFrameQueue *fq, AVFrame *frame)
     b = bucket(fq, fq->queued);
     b->frame = frame;
     fq->queued++;
-    fq->global->queued++;
+    atomic_fetch_add_explicit(&fq->global->queued, 1, memory_order_relaxed);
     fq->total_frames_head++;
     fq->total_samples_head += frame->nb_samples;
     check_consistency(fq);
@@ -109,7 +109,7 @@ AVFrame *ff_framequeue_take(FFFrameQueue *fq)
     av_assert1(fq->queued);
     b = bucket(fq, 0);
     fq->queued--;
-    fq->global->queued--;
+    atomic_fetch_sub_explicit(&fq->global->queued, 1, memory_order_relaxed);
     fq->tail++;
     fq->tail &= fq->allocated - 1;
     fq->total_frames_tail++;
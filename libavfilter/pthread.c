@@ -40,6 +40,9 @@ typedef struct ThreadContext {
     AVFilterContext *ctx;
     void *arg;
     int   *rets;
+
+    /* set while the threads run jobs */
+    int executing;
 } ThreadContext;
 
 static void worker_func(void *priv, int jobnr, int threadnr, int nb_jobs, int nb_threads)
@@ -58,16 +61,68 @@ static void slice_thread_uninit(ThreadContext *c)
 static int thread_execute(AVFilterContext *ctx, avfilter_action_func *func,
                           void *arg, int *ret, int nb_jobs)
 {
-    ThreadContext *c = fffiltergraph(ctx->graph)->thread;
+    FFFilterGraph *graphi = fffiltergraph(ctx->graph);
+    ThreadContext *c = graphi->thread;
 
     if (nb_jobs <= 0)
         return 0;
+
+    /* called from a job, e.g. by a filter activated with thread_activate():
+     * all the threads are busy, run the jobs on this one */
+    if (c->executing) {
+        for (int i = 0; i < nb_jobs; i++) {
+            int r = func(ctx, arg, i, nb_jobs);
+            if (ret)
+                ret[i] = r;
+        }
+        return 0;
+    }
+
     c->ctx         = ctx;
     c->arg         = arg;
     c->func        = func;
     c->rets        = ret;
 
+    c->executing = 1;
     avpriv_slicethread_execute(c->thread, nb_jobs, 0);
+    c->executing = 0;
+    return 0;
+}
+
+static int activate_job(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    AVFilterContext **filters = arg;
+    return ff_filter_activate(filters[jobnr]);
+}
+
+static void thread_activate(FFFilterGraph *graphi, AVFilterContext **filters,
+                            int *rets, int nb_filters)
+{
+    ThreadContext *c = graphi->thread;
+
+    c->ctx         = NULL;
+    c->arg         = filters;
+    c->func        = activate_job;
+    c->rets        = rets;
+
+    graphi->concurrent = 1;
+    c->executing = 1;
+    avpriv_slicethread_execute(c->thread, nb_filters, 0);
+    c->executing = 0;
+    graphi->concurrent = 0;
+}
+
+static int activate_thread_init(FFFilterGraph *graphi)
+{
+    AVFilterGraph *graph = &graphi->p;
+
+    /* at most one filter per thread is activated at a time */
+    graphi->activate_filters = av_calloc(graph->nb_threads, sizeof(*graphi->activate_filters));
+    graphi->activate_rets    = av_calloc(graph->nb_threads, sizeof(*graphi->activate_rets));
+    if (!graphi->activate_filters || !graphi->activate_rets)
+        return AVERROR(ENOMEM);
+
+    graphi->thread_activate = thread_activate;
     return 0;
 }
 
@@ -104,6 +159,12 @@ int ff_graph_thread_init(FFFilterGraph *graphi)
 
     graphi->thread_execute = thread_execute;
 
+    if (graph->thread_type & AVFILTER_THREAD_GRAPH) {
+        ret = activate_thread_init(graphi);
+        if (ret < 0)
+            return ret;
+    }
+
     return 0;
 }
 
@@ -112,4 +173,7 @@ void ff_graph_thread_free(FFFilterGraph *graph)
     if (graph->thread)
         slice_thread_uninit(graph->thread);
     av_freep(&graph->thread);
+    av_freep(&graph->activate_filters);
+    av_freep(&graph->activate_rets);
+    graph->thread_activate = NULL;
 }
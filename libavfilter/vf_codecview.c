@@ -219,11 +219,9 @@ static void draw_block_rectangle(uint8_t *buf, int sx, int sy, int w, int h, ptr
     }
 }
 
-static int filter_frame(AVFilterLink *inlink, AVFrame *frame)
+static int process_frame(AVFilterContext *ctx, AVFrame *frame, AVFrame **out, int jobnr)
 {
-    AVFilterContext *ctx = inlink->dst;
-    CodecViewContext *s = ctx->priv;
-    AVFilterLink *outlink = ctx->outputs[0];
+    const CodecViewContext *s = ctx->priv;
 
     if (s->qp) {
         enum AVVideoEncParamsType qp_type;
@@ -309,7 +307,20 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *frame)
         }
     }
 
-    return ff_filter_frame(outlink, frame);
+    *out = frame;
+    return 0;
+}
+
+static int filter_frame(AVFilterLink *inlink, AVFrame *frame)
+{
+    AVFilterContext *ctx = inlink->dst;
+    AVFrame *out;
+    int ret;
+
+    ret = process_frame(ctx, frame, &out, 0);
+    if (ret < 0)
+        return ret;
+    return ff_filter_frame(ctx->outputs[0], out);
 }
 
 static int config_input(AVFilterLink *inlink)
@@ -337,8 +348,10 @@ const FFFilter ff_vf_codecview = {
     .p.name        = "codecview",
     .p.description = NULL_IF_CONFIG_SMALL("Visualize information about some codecs."),
     .p.priv_class  = &codecview_class,
-    .p.flags       = AVFILTER_FLAG_SUPPORT_TIMELINE_GENERIC,
+    .p.flags       = AVFILTER_FLAG_SUPPORT_TIMELINE_GENERIC |
+                     AVFILTER_FLAG_FRAME_THREADS,
     .priv_size     = sizeof(CodecViewContext),
+    .process_frame = process_frame,
     FILTER_INPUTS(codecview_inputs),
     FILTER_OUTPUTS(ff_video_default_filterpad),
     // TODO: we can probably add way more pixel formats without any other
@@ -369,10 +369,10 @@ static av_pure av_always_inline int pixel_belongs_to_box(DrawBoxContext *s, int
            (x - s->x < s->thickness) || (s->x + s->w - 1 - x < s->thickness);
 }
 
-static int filter_frame(AVFilterLink *inlink, AVFrame *frame)
+static int process_frame(AVFilterContext *ctx, AVFrame *frame, AVFrame **out, int jobnr)
 {
-    AVFilterContext *ctx = inlink->dst;
     DrawBoxContext *s = ctx->priv;
+    DrawBoxContext box;
     const AVDetectionBBoxHeader *header = NULL;
     const AVDetectionBBox *bbox;
     AVFrameSideData *sd;
@@ -385,8 +385,12 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *frame)
             loop = header->nb_bboxes;
         } else {
             av_log(ctx, AV_LOG_WARNING, "No detection bboxes.\n");
-            return ff_filter_frame(inlink->dst->outputs[0], frame);
+            *out = frame;
+            return 0;
         }
+        /* work on a copy, frames may be processed concurrently */
+        box = *s;
+        s   = &box;
     }
 
     for (int i = 0; i < loop; i++) {
@@ -402,7 +406,20 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *frame)
                        FFMIN(s->y + s->h, frame->height), pixel_belongs_to_box);
     }
 
-    return ff_filter_frame(inlink->dst->outputs[0], frame);
+    *out = frame;
+    return 0;
+}
+
+static int filter_frame(AVFilterLink *inlink, AVFrame *frame)
+{
+    AVFilterContext *ctx = inlink->dst;
+    AVFrame *out;
+    int ret;
+
+    ret = process_frame(ctx, frame, &out, 0);
+    if (ret < 0)
+        return ret;
+    return ff_filter_frame(ctx->outputs[0], out);
 }
 
 static int process_command(AVFilterContext *ctx, const char *cmd, const char *args, char *res, int res_len, int flags)
@@ -475,9 +492,11 @@ const FFFilter ff_vf_drawbox = {
     .p.name        = "drawbox",
     .p.description = NULL_IF_CONFIG_SMALL("Draw a colored box on the input video."),
     .p.priv_class  = &drawbox_class,
-    .p.flags       = AVFILTER_FLAG_SUPPORT_TIMELINE_GENERIC,
+    .p.flags       = AVFILTER_FLAG_SUPPORT_TIMELINE_GENERIC |
+                     AVFILTER_FLAG_FRAME_THREADS,
     .priv_size     = sizeof(DrawBoxContext),
     .init          = init,
+    .process_frame = process_frame,
     FILTER_INPUTS(drawbox_inputs),
     FILTER_OUTPUTS(ff_video_default_filterpad),
     FILTER_PIXFMTS_ARRAY(pix_fmts),
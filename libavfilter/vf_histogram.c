@@ -26,6 +26,7 @@
 #include "libavutil/pixdesc.h"
 #include "libavutil/imgutils.h"
 #include "libavutil/intreadwrite.h"
+#include "libavutil/mem.h"
 #include "avfilter.h"
 #include "filters.h"
 #include "formats.h"
@@ -36,7 +37,7 @@ typedef struct HistogramContext {
     int            thistogram;
     int            envelope;
     int            slide;
-    unsigned       histogram[256*256];
+    unsigned      *histogram;           ///< one histogram per frame thread
     int            histogram_size;
     int            width;
     int            x_pos;
@@ -365,6 +366,12 @@ static int config_input(AVFilterLink *inlink)
     s->planewidth[1]  = s->planewidth[2]  = AV_CEIL_RSHIFT(inlink->w, s->desc->log2_chroma_w);
     s->planewidth[0]  = s->planewidth[3]  = inlink->w;
 
+    av_freep(&s->histogram);
+    s->histogram = av_calloc(ff_filter_get_nb_threads(inlink->dst),
+                             256 * 256 * sizeof(*s->histogram));
+    if (!s->histogram)
+        return AVERROR(ENOMEM);
+
     return 0;
 }
 
@@ -399,21 +406,22 @@ static int config_output(AVFilterLink *outlink)
     return 0;
 }
 
-static int filter_frame(AVFilterLink *inlink, AVFrame *in)
+static int process_frame(AVFilterContext *ctx, AVFrame *in, AVFrame **pout, int jobnr)
 {
-    HistogramContext *s   = inlink->dst->priv;
-    AVFilterContext *ctx  = inlink->dst;
+    HistogramContext *s   = ctx->priv;
     AVFilterLink *outlink = ctx->outputs[0];
-    AVFrame *out = s->out;
+    unsigned *histogram   = s->histogram + jobnr * 256 * 256;
+    AVFrame *out = s->thistogram ? s->out : NULL;
     int i, j, k, l, m;
 
-    if (!s->thistogram || !out) {
+    if (!out) {
         out = ff_get_video_buffer(outlink, outlink->w, outlink->h);
         if (!out) {
             av_frame_free(&in);
             return AVERROR(ENOMEM);
         }
-        s->out = out;
+        if (s->thistogram)
+            s->out = out;
 
         for (k = 0; k < 4 && out->data[k]; k++) {
             const int is_chroma = (k == 1 || k == 2);
@@ -461,18 +469,18 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *in)
             for (i = 0; i < height; i++) {
                 const uint8_t *src = in->data[p] + i * in->linesize[p];
                 for (j = 0; j < width; j++)
-                    s->histogram[src[j]]++;
+                    histogram[src[j]]++;
             }
         } else {
             for (i = 0; i < height; i++) {
                 const uint16_t *src = (const uint16_t *)(in->data[p] + i * in->linesize[p]);
                 for (j = 0; j < width; j++)
-                    s->histogram[src[j]]++;
+                    histogram[src[j]]++;
             }
         }
 
         for (i = 0; i < s->histogram_size; i++)
-            max_hval = FFMAX(max_hval, s->histogram[i]);
+            max_hval = FFMAX(max_hval, histogram[i]);
         max_hval_log = log2(max_hval + 1);
 
         if (s->thistogram) {
@@ -499,15 +507,15 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *in)
                 int idx = s->histogram_size - i - 1;
                 int value = s->start[p];
 
-                if (s->envelope && s->histogram[idx]) {
+                if (s->envelope && histogram[idx]) {
                     minh = FFMIN(minh, i);
                     maxh = FFMAX(maxh, i);
                 }
 
                 if (s->levels_mode)
-                    value += lrint(max_value * (log2(s->histogram[idx] + 1) / max_hval_log));
+                    value += lrint(max_value * (log2(histogram[idx] + 1) / max_hval_log));
                 else
-                    value += lrint(max_value * s->histogram[idx] / (float)max_hval);
+                    value += lrint(max_value * histogram[idx] / (float)max_hval);
 
                 if (s->histogram_size <= 256) {
                     s->out->data[p][(i + starty) * s->out->linesize[p] + startx + s->x_pos] = value;
@@ -544,9 +552,9 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *in)
                 int col_height;
 
                 if (s->levels_mode)
-                    col_height = lrint(s->level_height * (1. - (log2(s->histogram[i] + 1) / max_hval_log)));
+                    col_height = lrint(s->level_height * (1. - (log2(histogram[i] + 1) / max_hval_log)));
                 else
-                    col_height = s->level_height - (s->histogram[i] * (int64_t)s->level_height + max_hval - 1) / max_hval;
+                    col_height = s->level_height - (histogram[i] * (int64_t)s->level_height + max_hval - 1) / max_hval;
 
                 if (s->histogram_size <= 256) {
                     for (j = s->level_height - 1; j >= col_height; j--) {
@@ -590,32 +598,52 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *in)
             }
         }
 
-        memset(s->histogram, 0, s->histogram_size * sizeof(unsigned));
+        memset(histogram, 0, s->histogram_size * sizeof(unsigned));
     }
 
     av_frame_copy_props(out, in);
     out->sample_aspect_ratio = outlink->sample_aspect_ratio;
     av_frame_free(&in);
+    *pout = out;
+    if (!s->thistogram)
+        return 0;
+
     s->x_pos++;
     if (s->x_pos >= s->width) {
         s->x_pos = 0;
-        if (s->thistogram && (s->slide == 4 || s->slide == 0)) {
+        if (s->slide == 4 || s->slide == 0) {
             s->out = NULL;
-            goto end;
+            return 0;
         }
-    } else if (s->thistogram && s->slide == 4) {
+    } else if (s->slide == 4) {
+        *pout = NULL;
         return 0;
     }
 
-    if (s->thistogram) {
-        AVFrame *clone = av_frame_clone(out);
+    *pout = av_frame_clone(out);
+    if (!*pout)
+        return AVERROR(ENOMEM);
+    return 0;
+}
 
-        if (!clone)
-            return AVERROR(ENOMEM);
-        return ff_filter_frame(outlink, clone);
-    }
-end:
-    return ff_filter_frame(outlink, out);
+static int filter_frame(AVFilterLink *inlink, AVFrame *in)
+{
+    AVFilterContext *ctx = inlink->dst;
+    AVFrame *out;
+    int ret;
+
+    ret = process_frame(ctx, in, &out, 0);
+    if (ret < 0 || !out)
+        return ret;
+    return ff_filter_frame(ctx->outputs[0], out);
+}
+
+static av_cold void uninit(AVFilterContext *ctx)
+{
+    HistogramContext *s = ctx->priv;
+
+    av_freep(&s->histogram);
+    av_frame_free(&s->out);
 }
 
 static const AVFilterPad inputs[] = {
@@ -641,7 +669,10 @@ const FFFilter ff_vf_histogram = {
     .p.name        = "histogram",
     .p.description = NULL_IF_CONFIG_SMALL("Compute and draw a histogram."),
     .p.priv_class  = &histogram_class,
+    .p.flags       = AVFILTER_FLAG_FRAME_THREADS,
     .priv_size     = sizeof(HistogramContext),
+    .uninit        = uninit,
+    .process_frame = process_frame,
     FILTER_INPUTS(inputs),
     FILTER_OUTPUTS(outputs),
     FILTER_QUERY_FUNC(query_formats),
@@ -651,13 +682,6 @@ const FFFilter ff_vf_histogram = {
 
 #if CONFIG_THISTOGRAM_FILTER
 
-static av_cold void uninit(AVFilterContext *ctx)
-{
-    HistogramContext *s = ctx->priv;
-
-    av_frame_free(&s->out);
-}
-
 static const AVOption thistogram_options[] = {
     { "width", "set width", OFFSET(width), AV_OPT_TYPE_INT, {.i64=0}, 0, 8192, FLAGS},
     { "w",     "set width", OFFSET(width), AV_OPT_TYPE_INT, {.i64=0}, 0, 8192, FLAGS},
@@ -83,6 +83,9 @@ typedef struct PaletteGenContext {
     int nb_boxes;                           // number of boxes (increase will segmenting them)
     int palette_pushed;                     // if the palette frame is pushed into the outlink or not
     uint8_t transparency_color[4];          // background color for transparency
+    struct hist_node *job_hist;             // per slice job histograms of the current frame
+    int nb_job_hist;                        // number of per slice job histograms
+    int *job_ret;                           // per slice job number of new colors or error
 } PaletteGenContext;
 
 #define OFFSET(x) offsetof(PaletteGenContext, x)
@@ -419,14 +422,38 @@ static int color_inc(struct hist_node *hist, uint32_t color)
 }
 
 /**
- * Update histogram when pixels differ from previous frame.
+ * Add a color reference to a hash table node holding the same bucket.
+ */
+static int color_merge(struct hist_node *node, const struct color_ref *ref)
+{
+    struct color_ref *e;
+
+    for (int i = 0; i < node->nb_entries; i++) {
+        e = &node->entries[i];
+        if (e->color == ref->color) {
+            e->count += ref->count;
+            return 0;
+        }
+    }
+
+    e = av_dynarray2_add((void**)&node->entries, &node->nb_entries,
+                         sizeof(*node->entries), (const uint8_t *)ref);
+    if (!e)
+        return AVERROR(ENOMEM);
+    return 1;
+}
+
+/**
+ * Update histogram when pixels of the rows [y_start, y_end) differ from
+ * previous frame.
  */
 static int update_histogram_diff(struct hist_node *hist,
-                                 const AVFrame *f1, const AVFrame *f2)
+                                 const AVFrame *f1, const AVFrame *f2,
+                                 int y_start, int y_end)
 {
     int x, y, ret, nb_diff_colors = 0;
 
-    for (y = 0; y < f1->height; y++) {
+    for (y = y_start; y < y_end; y++) {
         const uint32_t *p = (const uint32_t *)(f1->data[0] + y*f1->linesize[0]);
         const uint32_t *q = (const uint32_t *)(f2->data[0] + y*f2->linesize[0]);
 
@@ -443,13 +470,14 @@ static int update_histogram_diff(struct hist_node *hist,
 }
 
 /**
- * Simple histogram of the frame.
+ * Simple histogram of the rows [y_start, y_end) of the frame.
  */
-static int update_histogram_frame(struct hist_node *hist, const AVFrame *f)
+static int update_histogram_frame(struct hist_node *hist, const AVFrame *f,
+                                  int y_start, int y_end)
 {
     int x, y, ret, nb_diff_colors = 0;
 
-    for (y = 0; y < f->height; y++) {
+    for (y = y_start; y < y_end; y++) {
         const uint32_t *p = (const uint32_t *)(f->data[0] + y*f->linesize[0]);
 
         for (x = 0; x < f->width; x++) {
@@ -462,6 +490,53 @@ static int update_histogram_frame(struct hist_node *hist, const AVFrame *f)
     return nb_diff_colors;
 }
 
+/**
+ * Each slice job builds the histogram of a range of rows in its own hash
+ * table.
+ */
+static int update_histogram_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    PaletteGenContext *s = ctx->priv;
+    const AVFrame *in = arg;
+    struct hist_node *hist = s->job_hist + jobnr * HIST_SIZE;
+    const int slice_start = (in->height *  jobnr   ) / nb_jobs;
+    const int slice_end   = (in->height * (jobnr+1)) / nb_jobs;
+    int ret;
+
+    ret = s->prev_frame ? update_histogram_diff(hist, s->prev_frame, in, slice_start, slice_end)
+                        : update_histogram_frame(hist, in, slice_start, slice_end);
+    return FFMIN(ret, 0);
+}
+
+/**
+ * Merge the histograms of the slice jobs into the stream histogram. Each job
+ * owns a range of buckets and visits the slices top to bottom, so that the
+ * colors are referenced in the same order as with a single job.
+ */
+static int merge_histogram_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    PaletteGenContext *s = ctx->priv;
+    const int nb_hist = *(const int *)arg;
+    const int hash_start = (HIST_SIZE *  jobnr   ) / nb_jobs;
+    const int hash_end   = (HIST_SIZE * (jobnr+1)) / nb_jobs;
+    int ret, nb_diff_colors = 0;
+
+    for (int h = hash_start; h < hash_end; h++) {
+        for (int j = 0; j < nb_hist; j++) {
+            struct hist_node *node = &s->job_hist[j * HIST_SIZE + h];
+
+            for (int i = 0; i < node->nb_entries; i++) {
+                ret = color_merge(&s->histogram[h], &node->entries[i]);
+                if (ret < 0)
+                    return ret;
+                nb_diff_colors += ret;
+            }
+            node->nb_entries = 0;
+        }
+    }
+    return nb_diff_colors;
+}
+
 /**
  * Update the histogram for each passing frame. No frame will be pushed here.
  */
@@ -469,15 +544,36 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *in)
 {
     AVFilterContext *ctx = inlink->dst;
     PaletteGenContext *s = ctx->priv;
-    int ret;
+    const int nb_jobs = FFMIN(in->height, s->nb_job_hist);
+    int ret = 0;
 
     if (in->color_trc != AVCOL_TRC_UNSPECIFIED && in->color_trc != AVCOL_TRC_IEC61966_2_1)
         av_log(ctx, AV_LOG_WARNING, "The input frame is not in sRGB, colors may be off\n");
 
-    ret = s->prev_frame ? update_histogram_diff(s->histogram, s->prev_frame, in)
-                        : update_histogram_frame(s->histogram, in);
-    if (ret > 0)
-        s->nb_refs += ret;
+    if (nb_jobs > 1) {
+        ff_filter_execute(ctx, update_histogram_slice, in, s->job_ret, nb_jobs);
+        for (int i = 0; i < nb_jobs && ret >= 0; i++)
+            ret = s->job_ret[i];
+        if (ret >= 0) {
+            ff_filter_execute(ctx, merge_histogram_slice, (void *)&nb_jobs,
+                              s->job_ret, s->nb_job_hist);
+            for (int i = 0; i < s->nb_job_hist && ret >= 0; i++) {
+                ret = s->job_ret[i];
+                if (ret > 0)
+                    s->nb_refs += ret;
+            }
+        }
+    } else {
+        ret = s->prev_frame ? update_histogram_diff(s->histogram, s->prev_frame, in, 0, in->height)
+                            : update_histogram_frame(s->histogram, in, 0, in->height);
+        if (ret > 0)
+            s->nb_refs += ret;
+    }
+    if (ret < 0) {
+        av_frame_free(&in);
+        return ret;
+    }
+    ret = 0;
 
     if (s->stats_mode == STATS_MODE_DIFF_FRAMES) {
         av_frame_free(&s->prev_frame);
@@ -523,6 +619,36 @@ static int request_frame(AVFilterLink *outlink)
     return r;
 }
 
+static void free_job_hist(PaletteGenContext *s)
+{
+    if (s->job_hist) {
+        for (int i = 0; i < s->nb_job_hist * HIST_SIZE; i++)
+            av_freep(&s->job_hist[i].entries);
+    }
+    av_freep(&s->job_hist);
+    av_freep(&s->job_ret);
+    s->nb_job_hist = 0;
+}
+
+static int config_input(AVFilterLink *inlink)
+{
+    AVFilterContext *ctx = inlink->dst;
+    PaletteGenContext *s = ctx->priv;
+    const int nb_threads = ff_filter_get_nb_threads(ctx);
+
+    free_job_hist(s);
+    s->job_ret = av_calloc(nb_threads, sizeof(*s->job_ret));
+    if (!s->job_ret)
+        return AVERROR(ENOMEM);
+    if (nb_threads > 1) {
+        s->job_hist = av_calloc(nb_threads * HIST_SIZE, sizeof(*s->job_hist));
+        if (!s->job_hist)
+            return AVERROR(ENOMEM);
+    }
+    s->nb_job_hist = nb_threads;
+    return 0;
+}
+
 /**
  * The output is one simple 16x16 squared-pixels palette.
  */
@@ -553,6 +679,7 @@ static av_cold void uninit(AVFilterContext *ctx)
     for (i = 0; i < HIST_SIZE; i++)
         av_freep(&s->histogram[i].entries);
     av_freep(&s->refs);
+    free_job_hist(s);
     av_frame_free(&s->prev_frame);
 }
 
@@ -560,6 +687,7 @@ static const AVFilterPad palettegen_inputs[] = {
     {
         .name         = "default",
         .type         = AVMEDIA_TYPE_VIDEO,
+        .config_props = config_input,
         .filter_frame = filter_frame,
     },
 };
@@ -577,6 +705,7 @@ const FFFilter ff_vf_palettegen = {
     .p.name        = "palettegen",
     .p.description = NULL_IF_CONFIG_SMALL("Find the optimal palette for a given stream."),
     .p.priv_class  = &palettegen_class,
+    .p.flags       = AVFILTER_FLAG_SLICE_THREADS,
     .priv_size     = sizeof(PaletteGenContext),
     .init          = init,
     .uninit        = uninit,
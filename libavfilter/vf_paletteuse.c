@@ -24,12 +24,15 @@
  * Use a palette to downsample an input video stream.
  */
 
+#include <stdatomic.h>
+
 #include "libavutil/bprint.h"
 #include "libavutil/file_open.h"
 #include "libavutil/internal.h"
 #include "libavutil/mem.h"
 #include "libavutil/opt.h"
 #include "libavutil/qsort.h"
+#include "libavutil/thread.h"
 #include "avfilter.h"
 #include "filters.h"
 #include "formats.h"
@@ -83,12 +86,15 @@ struct cache_node {
 struct PaletteUseContext;
 
 typedef int (*set_frame_func)(struct PaletteUseContext *s, AVFrame *out, AVFrame *in,
-                              int x_start, int y_start, int width, int height);
+                              int x_start, int y_start, int width, int height,
+                              int jobnr, int nb_jobs);
 
 typedef struct PaletteUseContext {
     const AVClass *class;
     FFFrameSync fs;
-    struct cache_node cache[CACHE_SIZE];    /* lookup cache */
+    struct cache_node (*cache)[CACHE_SIZE]; /* lookup cache, one per slice job */
+    int nb_jobs;
+    int *job_ret;
     struct color_node map[AVPALETTE_COUNT]; /* 3D-Tree (KD-Tree with K=3) for reverse colormap */
     uint32_t palette[AVPALETTE_COUNT];
     int transparency_index; /* index in the palette of transparency. -1 if there is no transparency in the palette. */
@@ -103,6 +109,12 @@ typedef struct PaletteUseContext {
     AVFrame *last_in;
     AVFrame *last_out;
 
+    /* row progress for error diffusion dithering with several slice jobs */
+    atomic_int *row_progress;
+    atomic_int nb_waiters;
+    AVMutex progress_mutex;
+    AVCond progress_cond;
+
     /* debug options */
     char *dot_filename;
     int calc_mean_err;
@@ -239,11 +251,12 @@ struct stack_node {
  * Check if the requested color is in the cache already. If not, find it in the
  * color tree and cache it.
  */
-static av_always_inline int color_get(PaletteUseContext *s, uint32_t color)
+static av_always_inline int color_get(PaletteUseContext *s, struct cache_node *cache,
+                                      uint32_t color)
 {
     struct color_info clrinfo;
     const uint32_t hash = ff_lowbias32(color) & (CACHE_SIZE - 1);
-    struct cache_node *node = &s->cache[hash];
+    struct cache_node *node = &cache[hash];
     struct cached_color *e;
 
     // first, check for transparency
@@ -268,11 +281,11 @@ static av_always_inline int color_get(PaletteUseContext *s, uint32_t color)
     return e->pal_entry;
 }
 
-static av_always_inline int get_dst_color_err(PaletteUseContext *s,
+static av_always_inline int get_dst_color_err(PaletteUseContext *s, struct cache_node *cache,
                                               uint32_t c, int *er, int *eg, int *eb)
 {
     uint32_t dstc;
-    const int dstx = color_get(s, c);
+    const int dstx = color_get(s, cache, c);
     if (dstx < 0)
         return dstx;
     dstc = s->palette[dstx];
@@ -289,22 +302,80 @@ static av_always_inline int get_dst_color_err(PaletteUseContext *s,
     return dstx;
 }
 
+/**
+ * With error diffusion, a pixel receives error from the pixels up to 2
+ * columns to its right on the rows above, and the order in which these
+ * contributions are clipped matters. A row may thus only process a pixel
+ * once the row above is done up to DIFFUSION_LAG columns past it.
+ * This requires all the jobs to run at the same time, which only the
+ * internal slice threads guarantee; otherwise a single job is used.
+ */
+#define DIFFUSION_LAG 4
+#define PROGRESS_STEP 32
+
+static void report_row(PaletteUseContext *s, int y, int x)
+{
+    atomic_store(&s->row_progress[y], x);
+    if (atomic_load(&s->nb_waiters)) {
+        ff_mutex_lock(&s->progress_mutex);
+        ff_cond_broadcast(&s->progress_cond);
+        ff_mutex_unlock(&s->progress_mutex);
+    }
+}
+
+static int await_row(PaletteUseContext *s, int y, int x)
+{
+    int progress = atomic_load(&s->row_progress[y]);
+
+    if (progress >= x)
+        return progress;
+
+    ff_mutex_lock(&s->progress_mutex);
+    atomic_fetch_add(&s->nb_waiters, 1);
+    while ((progress = atomic_load(&s->row_progress[y])) < x)
+        ff_cond_wait(&s->progress_cond, &s->progress_mutex);
+    atomic_fetch_sub(&s->nb_waiters, 1);
+    ff_mutex_unlock(&s->progress_mutex);
+    return progress;
+}
+
 static av_always_inline int set_frame(PaletteUseContext *s, AVFrame *out, AVFrame *in,
                                       int x_start, int y_start, int w, int h,
+                                      int jobnr, int nb_jobs,
                                       enum dithering_mode dither)
 {
+    struct cache_node *cache = s->cache[jobnr];
     const int src_linesize = in ->linesize[0] >> 2;
     const int dst_linesize = out->linesize[0];
-    uint32_t *src = ((uint32_t *)in ->data[0]) + y_start*src_linesize;
-    uint8_t  *dst =              out->data[0]  + y_start*dst_linesize;
+    const int diffusion = dither != DITHERING_NONE && dither != DITHERING_BAYER;
+    const int sync = diffusion && nb_jobs > 1;
+    int slice_start, slice_end, slice_step, y, ret;
+
+    if (diffusion) {
+        /* rows are handed out in turn, each one trailing the row above */
+        slice_start = y_start + jobnr;
+        slice_end   = y_start + h;
+        slice_step  = nb_jobs;
+    } else {
+        slice_start = y_start + (h *  jobnr   ) / nb_jobs;
+        slice_end   = y_start + (h * (jobnr+1)) / nb_jobs;
+        slice_step  = 1;
+    }
 
     w += x_start;
     h += y_start;
 
-    for (int y = y_start; y < h; y++) {
+    for (y = slice_start; y < slice_end; y += slice_step) {
+        uint32_t *src = ((uint32_t *)in ->data[0]) + y*src_linesize;
+        uint8_t  *dst =              out->data[0]  + y*dst_linesize;
+        int avail = sync && y > y_start ? x_start - 1 : INT_MAX;
+
         for (int x = x_start; x < w; x++) {
             int er, eg, eb;
 
+            if (x > avail)
+                avail = await_row(s, y - 1, x + DIFFUSION_LAG + 1) - DIFFUSION_LAG - 1;
+
             if (dither == DITHERING_BAYER) {
                 const int d = s->ordered_dither[(y & 7)<<3 | (x & 7)];
                 const uint8_t a8 = src[x] >> 24;
@@ -315,18 +386,22 @@ static av_always_inline int set_frame(PaletteUseContext *s, AVFrame *out, AVFram
                 const uint8_t g = av_clip_uint8(g8 + d);
                 const uint8_t b = av_clip_uint8(b8 + d);
                 const uint32_t color_new = (unsigned)(a8) << 24 | r << 16 | g << 8 | b;
-                const int color = color_get(s, color_new);
+                const int color = color_get(s, cache, color_new);
 
-                if (color < 0)
-                    return color;
+                if (color < 0) {
+                    ret = color;
+                    goto fail;
+                }
                 dst[x] = color;
 
             } else if (dither == DITHERING_HECKBERT) {
                 const int right = x < w - 1, down = y < h - 1;
-                const int color = get_dst_color_err(s, src[x], &er, &eg, &eb);
+                const int color = get_dst_color_err(s, cache, src[x], &er, &eg, &eb);
 
-                if (color < 0)
-                    return color;
+                if (color < 0) {
+                    ret = color;
+                    goto fail;
+                }
                 dst[x] = color;
 
                 if (right)         src[               x + 1] = dither_color(src[               x + 1], er, eg, eb, 3, 3);
@@ -335,10 +410,12 @@ static av_always_inline int set_frame(PaletteUseContext *s, AVFrame *out, AVFram
 
             } else if (dither == DITHERING_FLOYD_STEINBERG) {
                 const int right = x < w - 1, down = y < h - 1, left = x > x_start;
-                const int color = get_dst_color_err(s, src[x], &er, &eg, &eb);
+                const int color = get_dst_color_err(s, cache, src[x], &er, &eg, &eb);
 
-                if (color < 0)
-                    return color;
+                if (color < 0) {
+                    ret = color;
+                    goto fail;
+                }
                 dst[x] = color;
 
                 if (right)         src[               x + 1] = dither_color(src[               x + 1], er, eg, eb, 7, 4);
@@ -349,10 +426,12 @@ static av_always_inline int set_frame(PaletteUseContext *s, AVFrame *out, AVFram
             } else if (dither == DITHERING_SIERRA2) {
                 const int right  = x < w - 1, down  = y < h - 1, left  = x > x_start;
                 const int right2 = x < w - 2,                    left2 = x > x_start + 1;
-                const int color = get_dst_color_err(s, src[x], &er, &eg, &eb);
+                const int color = get_dst_color_err(s, cache, src[x], &er, &eg, &eb);
 
-                if (color < 0)
-                    return color;
+                if (color < 0) {
+                    ret = color;
+                    goto fail;
+                }
                 dst[x] = color;
 
                 if (right)          src[                 x + 1] = dither_color(src[                 x + 1], er, eg, eb, 4, 4);
@@ -368,10 +447,12 @@ static av_always_inline int set_frame(PaletteUseContext *s, AVFrame *out, AVFram
 
             } else if (dither == DITHERING_SIERRA2_4A) {
                 const int right = x < w - 1, down = y < h - 1, left = x > x_start;
-                const int color = get_dst_color_err(s, src[x], &er, &eg, &eb);
+                const int color = get_dst_color_err(s, cache, src[x], &er, &eg, &eb);
 
-                if (color < 0)
-                    return color;
+                if (color < 0) {
+                    ret = color;
+                    goto fail;
+                }
                 dst[x] = color;
 
                 if (right)         src[               x + 1] = dither_color(src[               x + 1], er, eg, eb, 2, 2);
@@ -381,10 +462,12 @@ static av_always_inline int set_frame(PaletteUseContext *s, AVFrame *out, AVFram
             } else if (dither == DITHERING_SIERRA3) {
                 const int right  = x < w - 1, down  = y < h - 1, left  = x > x_start;
                 const int right2 = x < w - 2, down2 = y < h - 2, left2 = x > x_start + 1;
-                const int color = get_dst_color_err(s, src[x], &er, &eg, &eb);
+                const int color = get_dst_color_err(s, cache, src[x], &er, &eg, &eb);
 
-                if (color < 0)
-                    return color;
+                if (color < 0) {
+                    ret = color;
+                    goto fail;
+                }
                 dst[x] = color;
 
                 if (right)         src[                 x + 1] = dither_color(src[                 x + 1], er, eg, eb, 5, 5);
@@ -407,10 +490,12 @@ static av_always_inline int set_frame(PaletteUseContext *s, AVFrame *out, AVFram
             } else if (dither == DITHERING_BURKES) {
                 const int right  = x < w - 1, down  = y < h - 1, left  = x > x_start;
                 const int right2 = x < w - 2,                    left2 = x > x_start + 1;
-                const int color = get_dst_color_err(s, src[x], &er, &eg, &eb);
+                const int color = get_dst_color_err(s, cache, src[x], &er, &eg, &eb);
 
-                if (color < 0)
-                    return color;
+                if (color < 0) {
+                    ret = color;
+                    goto fail;
+                }
                 dst[x] = color;
 
                 if (right)      src[                 x + 1] = dither_color(src[                 x + 1], er, eg, eb, 8, 5);
@@ -427,10 +512,12 @@ static av_always_inline int set_frame(PaletteUseContext *s, AVFrame *out, AVFram
             } else if (dither == DITHERING_ATKINSON) {
                 const int right  = x < w - 1, down  = y < h - 1, left = x > x_start;
                 const int right2 = x < w - 2, down2 = y < h - 2;
-                const int color = get_dst_color_err(s, src[x], &er, &eg, &eb);
+                const int color = get_dst_color_err(s, cache, src[x], &er, &eg, &eb);
 
-                if (color < 0)
-                    return color;
+                if (color < 0) {
+                    ret = color;
+                    goto fail;
+                }
                 dst[x] = color;
 
                 if (right)     src[                 x + 1] = dither_color(src[                 x + 1], er, eg, eb, 1, 3);
@@ -444,17 +531,29 @@ static av_always_inline int set_frame(PaletteUseContext *s, AVFrame *out, AVFram
                 }
 
             } else {
-                const int color = color_get(s, src[x]);
+                const int color = color_get(s, cache, src[x]);
 
-                if (color < 0)
-                    return color;
+                if (color < 0) {
+                    ret = color;
+                    goto fail;
+                }
                 dst[x] = color;
             }
+
+            if (sync && !((x + 1 - x_start) % PROGRESS_STEP))
+                report_row(s, y, x + 1);
         }
-        src += src_linesize;
-        dst += dst_linesize;
+        if (sync)
+            report_row(s, y, INT_MAX);
     }
     return 0;
+
+fail:
+    /* do not leave the rows below waiting */
+    if (sync)
+        for (; y < slice_end; y += slice_step)
+            report_row(s, y, INT_MAX);
+    return ret;
 }
 
 #define INDENT 4
@@ -767,9 +866,24 @@ static void set_processing_window(enum diff_mode diff_mode,
     *hp = height;
 }
 
+typedef struct ThreadData {
+    AVFrame *in, *out;
+    int x, y, w, h;
+} ThreadData;
+
+static int set_frame_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    PaletteUseContext *s = ctx->priv;
+    ThreadData *td = arg;
+
+    return s->set_frame(s, td->out, td->in, td->x, td->y, td->w, td->h,
+                        jobnr, nb_jobs);
+}
+
 static int apply_palette(AVFilterLink *inlink, AVFrame *in, AVFrame **outf)
 {
-    int x, y, w, h, ret;
+    int x, y, w, h, nb_jobs, ret;
+    ThreadData td;
     AVFilterContext *ctx = inlink->dst;
     PaletteUseContext *s = ctx->priv;
     AVFilterLink *outlink = inlink->dst->outputs[0];
@@ -795,11 +909,23 @@ static int apply_palette(AVFilterLink *inlink, AVFrame *in, AVFrame **outf)
     ff_dlog(ctx, "%dx%d rect: (%d;%d) -> (%d,%d) [area:%dx%d]\n",
             w, h, x, y, x+w, y+h, in->width, in->height);
 
-    ret = s->set_frame(s, out, in, x, y, w, h);
-    if (ret < 0) {
-        av_frame_free(&out);
-        *outf = NULL;
-        return ret;
+    nb_jobs = FFMIN(h, s->nb_jobs);
+    if (s->dither != DITHERING_NONE && s->dither != DITHERING_BAYER) {
+        /* the error diffusion jobs wait for each other */
+        if (!ff_filter_execute_is_concurrent(ctx))
+            nb_jobs = 1;
+        for (int i = y; nb_jobs > 1 && i < y + h; i++)
+            atomic_store_explicit(&s->row_progress[i], 0, memory_order_relaxed);
+    }
+
+    td = (ThreadData){ .in = in, .out = out, .x = x, .y = y, .w = w, .h = h };
+    ff_filter_execute(ctx, set_frame_slice, &td, s->job_ret, nb_jobs);
+    for (int i = 0; i < nb_jobs; i++) {
+        if (s->job_ret[i] < 0) {
+            av_frame_free(&out);
+            *outf = NULL;
+            return s->job_ret[i];
+        }
     }
     memcpy(out->data[1], s->palette, AVPALETTE_SIZE);
     *outf = out;
@@ -822,6 +948,13 @@ static int config_output(AVFilterLink *outlink)
     outlink->w = ctx->inputs[0]->w;
     outlink->h = ctx->inputs[0]->h;
 
+    s->nb_jobs      = ff_filter_get_nb_threads(ctx);
+    s->cache        = av_calloc(s->nb_jobs, sizeof(*s->cache));
+    s->job_ret      = av_calloc(s->nb_jobs, sizeof(*s->job_ret));
+    s->row_progress = av_calloc(outlink->h, sizeof(*s->row_progress));
+    if (!s->cache || !s->job_ret || !s->row_progress)
+        return AVERROR(ENOMEM);
+
     outlink->time_base = ctx->inputs[0]->time_base;
     if ((ret = ff_framesync_configure(&s->fs)) < 0)
         return ret;
@@ -843,6 +976,15 @@ static int config_input_palette(AVFilterLink *inlink)
     return 0;
 }
 
+static void free_cache(PaletteUseContext *s)
+{
+    if (!s->cache)
+        return;
+    for (int j = 0; j < s->nb_jobs; j++)
+        for (int i = 0; i < CACHE_SIZE; i++)
+            av_freep(&s->cache[j][i].entries);
+}
+
 static void load_palette(PaletteUseContext *s, const AVFrame *palette_frame)
 {
     int i, x, y;
@@ -854,9 +996,8 @@ static void load_palette(PaletteUseContext *s, const AVFrame *palette_frame)
     if (s->new) {
         memset(s->palette, 0, sizeof(s->palette));
         memset(s->map, 0, sizeof(s->map));
-        for (i = 0; i < CACHE_SIZE; i++)
-            av_freep(&s->cache[i].entries);
-        memset(s->cache, 0, sizeof(s->cache));
+        free_cache(s);
+        memset(s->cache, 0, s->nb_jobs * sizeof(*s->cache));
     }
 
     i = 0;
@@ -905,9 +1046,10 @@ static int load_apply_palette(FFFrameSync *fs)
 
 #define DEFINE_SET_FRAME(name, value)                                           \
 static int set_frame_##name(PaletteUseContext *s, AVFrame *out, AVFrame *in,    \
-                            int x_start, int y_start, int w, int h)             \
+                            int x_start, int y_start, int w, int h,             \
+                            int jobnr, int nb_jobs)                             \
 {                                                                               \
-    return set_frame(s, out, in, x_start, y_start, w, h, value);                \
+    return set_frame(s, out, in, x_start, y_start, w, h, jobnr, nb_jobs, value);\
 }
 
 DEFINE_SET_FRAME(none,            DITHERING_NONE)
@@ -943,6 +1085,11 @@ static int dither_value(int p)
 static av_cold int init(AVFilterContext *ctx)
 {
     PaletteUseContext *s = ctx->priv;
+    int ret;
+
+    if ((ret = ff_mutex_init(&s->progress_mutex, NULL)) ||
+        (ret = ff_cond_init(&s->progress_cond, NULL)))
+        return AVERROR(ret);
 
     s->last_in  = av_frame_alloc();
     s->last_out = av_frame_alloc();
@@ -972,10 +1119,14 @@ static av_cold void uninit(AVFilterContext *ctx)
     PaletteUseContext *s = ctx->priv;
 
     ff_framesync_uninit(&s->fs);
-    for (int i = 0; i < CACHE_SIZE; i++)
-        av_freep(&s->cache[i].entries);
+    free_cache(s);
+    av_freep(&s->cache);
+    av_freep(&s->job_ret);
+    av_freep(&s->row_progress);
     av_frame_free(&s->last_in);
     av_frame_free(&s->last_out);
+    ff_cond_destroy(&s->progress_cond);
+    ff_mutex_destroy(&s->progress_mutex);
 }
 
 static const AVFilterPad paletteuse_inputs[] = {
@@ -1001,6 +1152,7 @@ const FFFilter ff_vf_paletteuse = {
     .p.name        = "paletteuse",
     .p.description = NULL_IF_CONFIG_SMALL("Use a palette to downsample an input video stream."),
     .p.priv_class  = &paletteuse_class,
+    .p.flags       = AVFILTER_FLAG_SLICE_THREADS,
     .priv_size     = sizeof(PaletteUseContext),
     .init          = init,
     .uninit        = uninit,
@@ -325,6 +325,27 @@ static av_cold int preinit(AVFilterContext *ctx)
 
 static int do_scale(FFFrameSync *fs);
 
+typedef struct ScaleExecuteArgs {
+    int (*func)(void *priv, int jobnr);
+    void *priv;
+} ScaleExecuteArgs;
+
+static int scale_execute_job(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    ScaleExecuteArgs *args = arg;
+    return args->func(args->priv, jobnr);
+}
+
+/* run the swscale slices on the filtergraph threads */
+static int scale_execute(SwsContext *sws, int (*func)(void *priv, int jobnr),
+                         void *priv, int nb_jobs)
+{
+    AVFilterContext *ctx = sws->opaque;
+    ScaleExecuteArgs args = { .func = func, .priv = priv };
+
+    return ff_filter_execute(ctx, scale_execute_job, &args, NULL, nb_jobs);
+}
+
 static av_cold int init(AVFilterContext *ctx)
 {
     ScaleContext *scale = ctx->priv;
@@ -421,9 +442,14 @@ static av_cold int init(AVFilterContext *ctx)
     scale->sws->dst_h_chr_pos = scale->out_h_chr_pos;
     scale->sws->dst_v_chr_pos = scale->out_v_chr_pos;
 
-    // use generic thread-count if the user did not set it explicitly
-    if (!scale->sws->threads)
+    // use generic thread-count and threads if the user did not set it explicitly
+    if (!scale->sws->threads) {
         scale->sws->threads = ff_filter_get_nb_threads(ctx);
+        if (ctx->thread_type & AVFILTER_THREAD_SLICE) {
+            scale->sws->opaque  = ctx;
+            scale->sws->execute = scale_execute;
+        }
+    }
 
     if (!IS_SCALE2REF(ctx) && scale->uses_ref) {
         AVFilterPad pad = {
@@ -1191,7 +1217,7 @@ const FFFilter ff_vf_scale = {
     .p.name          = "scale",
     .p.description   = NULL_IF_CONFIG_SMALL("Scale the input video size and/or convert the image format."),
     .p.priv_class    = &scale_class,
-    .p.flags         = AVFILTER_FLAG_DYNAMIC_INPUTS,
+    .p.flags         = AVFILTER_FLAG_DYNAMIC_INPUTS | AVFILTER_FLAG_SLICE_THREADS,
     .preinit         = preinit,
     .init            = init,
     .uninit          = uninit,
@@ -1260,6 +1286,7 @@ const FFFilter ff_vf_scale2ref = {
     .p.name          = "scale2ref",
     .p.description   = NULL_IF_CONFIG_SMALL("Scale the input video size and/or convert the image format to the given reference."),
     .p.priv_class    = &scale2ref_class,
+    .p.flags         = AVFILTER_FLAG_SLICE_THREADS,
     .preinit         = preinit,
     .init            = init,
     .uninit          = uninit,
@@ -58,6 +58,7 @@ void ff_free_stream(AVStream **pst)
     avcodec_free_context(&sti->avctx);
     av_bsf_free(&sti->bsfc);
     av_freep(&sti->index_entries);
+    av_freep(&sti->index_pending);
     av_freep(&sti->probe_data.buf);
 
     av_packet_free(&sti->parse_pkt);
@@ -121,6 +121,45 @@ URLContext *ffio_geturlcontext(AVIOContext *s)
         return NULL;
 }
 
+int ffio_read_mapped(AVIOContext *s, int size, AVBufferRef **buf, uint8_t **data)
+{
+    URLContext *h = ffio_geturlcontext(s);
+    AVBufferRef *map;
+    int64_t pos = avio_tell(s), ret;
+
+    /* the bytes must reach the caller exactly as they are in the resource */
+    if (!h || s->write_flag || s->update_checksum || size < 0 || pos < 0)
+        return AVERROR(ENOSYS);
+
+    ret = ffurl_map(h, pos, size, &map);
+    if (ret < 0)
+        return ret;
+
+    ret = avio_skip(s, size);
+    if (ret < 0) {
+        av_buffer_unref(&map);
+        return ret;
+    }
+
+    *buf  = map;
+    *data = map->data;
+    return 0;
+}
+
+int ffio_shift_data(AVIOContext *s, AVIOContext *src,
+                    int64_t pos, int64_t end, int64_t shift)
+{
+    URLContext *h = ffio_geturlcontext(s);
+
+    if (!h || !src || !s->write_flag || pos < 0 || end < pos || shift <= 0)
+        return AVERROR(ENOSYS);
+
+    avio_flush(s);
+    if (s->error)
+        return s->error;
+    return ffurl_shift_data(h, ffio_geturlcontext(src), pos, end, shift);
+}
+
 int ffurl_register_protocol(URLProtocol *protocol)
 {
     URLProtocol **p;
@@ -871,6 +910,22 @@ int ffurl_get_short_seek(void *urlcontext)
     return h->prot->url_get_short_seek(h);
 }
 
+int ffurl_map(URLContext *h, int64_t pos, int size, AVBufferRef **buf)
+{
+    if (!h || !h->prot || !h->prot->url_map)
+        return AVERROR(ENOSYS);
+    return h->prot->url_map(h, pos, size, buf);
+}
+
+int ffurl_shift_data(URLContext *h, URLContext *src,
+                     int64_t pos, int64_t end, int64_t shift)
+{
+    if (!h || !h->prot || !h->prot->url_shift_data ||
+        !src || src->prot != h->prot)
+        return AVERROR(ENOSYS);
+    return h->prot->url_shift_data(h, src, pos, end, shift);
+}
+
 int ffurl_shutdown(URLContext *h, int flags)
 {
     if (!h || !h->prot || !h->prot->url_shutdown)
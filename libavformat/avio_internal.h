@@ -21,6 +21,7 @@
 
 #include "avio.h"
 
+#include "libavutil/buffer.h"
 #include "libavutil/log.h"
 
 extern const AVClass ff_avio_class;
@@ -119,6 +120,31 @@ void ffio_init_write_context(FFIOContext *s, uint8_t *buffer, int buffer_size);
  */
 int ffio_read_indirect(AVIOContext *s, unsigned char *buf, int size, const unsigned char **data);
 
+/**
+ * Read size bytes by mapping them from the underlying protocol instead of
+ * copying them. The data is followed by zeroed padding.
+ *
+ * @param buf  set to a new reference to the read-only mapping
+ * @param data set to the start of the data inside the mapping
+ * @return 0 on success, AVERROR(ENOSYS) if the data cannot be referenced,
+ *         in which case nothing has been read, or another negative
+ *         error code
+ */
+int ffio_read_mapped(AVIOContext *s, int size, AVBufferRef **buf, uint8_t **data);
+
+/**
+ * Flush the output and let the underlying protocol move the bytes in
+ * [pos, end) shift bytes forward, e.g. with copy_file_range() for local
+ * files. The current position is not changed.
+ *
+ * @param src the same resource as s, opened for reading; both must use the
+ *            same protocol
+ * @return 0 on success, AVERROR(ENOSYS) if the protocol cannot do it, in
+ *         which case nothing has been moved, or another negative error code
+ */
+int ffio_shift_data(AVIOContext *s, AVIOContext *src,
+                    int64_t pos, int64_t end, int64_t shift);
+
 void ffio_fill(AVIOContext *s, int b, int64_t count);
 
 static av_always_inline void ffio_wfourcc(AVIOContext *pb, const uint8_t *s)
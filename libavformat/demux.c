@@ -1501,8 +1501,8 @@ static int read_frame_internal(AVFormatContext *s, AVPacket *pkt)
             if ((s->iformat->flags & AVFMT_GENERIC_INDEX) &&
                 (pkt->flags & AV_PKT_FLAG_KEY) && pkt->dts != AV_NOPTS_VALUE) {
                 ff_reduce_index(s, st->index);
-                av_add_index_entry(st, pkt->pos, pkt->dts,
-                                   0, 0, AVINDEX_KEYFRAME);
+                ff_add_index_entry_deferred(st, pkt->pos, pkt->dts,
+                                            0, 0, AVINDEX_KEYFRAME);
             }
             got_packet = 1;
         } else if (st->discard < AVDISCARD_ALL) {
@@ -1669,7 +1669,7 @@ return_packet:
     st = s->streams[pkt->stream_index];
     if ((s->iformat->flags & AVFMT_GENERIC_INDEX) && pkt->flags & AV_PKT_FLAG_KEY) {
         ff_reduce_index(s, st->index);
-        av_add_index_entry(st, pkt->pos, pkt->dts, 0, 0, AVINDEX_KEYFRAME);
+        ff_add_index_entry_deferred(st, pkt->pos, pkt->dts, 0, 0, AVINDEX_KEYFRAME);
     }
 
     if (is_relative(pkt->dts))
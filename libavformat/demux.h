@@ -181,6 +181,21 @@ typedef struct FFInputFormat {
      * @see avdevice_list_devices() for more details.
      */
     int (*get_device_list)(struct AVFormatContext *s, struct AVDeviceInfoList *device_list);
+
+    /**
+     * Fill FFStream.index_entries of a stream whose index the demuxer keeps
+     * in a different form. Called by the public index API before it accesses
+     * the index.
+     * @return 0 on success or if there is nothing to do, a negative AVERROR
+     *         code otherwise
+     */
+    int (*expand_index)(struct AVFormatContext *s, struct AVStream *st);
+
+    /**
+     * Return the number of FFStream.index_entries a stream would have after
+     * expand_index(), without modifying it. Must be set if expand_index is.
+     */
+    int (*index_count)(const struct AVFormatContext *s, const struct AVStream *st);
 } FFInputFormat;
 
 static inline const FFInputFormat *ffifmt(const AVInputFormat *fmt)
@@ -276,6 +291,18 @@ int64_t ff_gen_search(AVFormatContext *s, int stream_index,
 int ff_index_search_timestamp(const AVIndexEntry *entries, int nb_entries,
                               int64_t wanted_timestamp, int flags);
 
+/**
+ * Same as ff_index_search_timestamp(), for an index that is not stored as
+ * an array of AVIndexEntry.
+ *
+ * @param get_entry returns the timestamp of the entry at index and sets
+ *                  *entry_flags to its flags
+ */
+int ff_index_search_timestamp_cb(void *opaque, int nb_entries,
+                                 int64_t (*get_entry)(void *opaque, int index,
+                                                      int *entry_flags),
+                                 int64_t wanted_timestamp, int flags);
+
 /**
  * Internal version of av_add_index_entry
  */
@@ -284,6 +311,29 @@ int ff_add_index_entry(AVIndexEntry **index_entries,
                        unsigned int *index_entries_allocated_size,
                        int64_t pos, int64_t timestamp, int size, int distance, int flags);
 
+/**
+ * Add an index entry like av_add_index_entry(), but queue entries that
+ * would have to be inserted in the middle of the index instead of moving
+ * the following ones. Meant for demuxers that build their index while
+ * reading, possibly out of order.
+ *
+ * The queued entries are merged into the index by ff_flush_index_entries(),
+ * which the index accessors and the seeking functions call as needed.
+ *
+ * @return >= 0 on success, AVERROR_xxx on error
+ */
+int ff_add_index_entry_deferred(AVStream *st, int64_t pos, int64_t timestamp,
+                                int size, int distance, int flags);
+
+/**
+ * Merge the entries queued by ff_add_index_entry_deferred() into
+ * FFStream.index_entries. Must be called before accessing the index
+ * array directly when the demuxer uses ff_add_index_entry_deferred().
+ *
+ * @return 0 if OK, AVERROR_xxx on error
+ */
+int ff_flush_index_entries(AVStream *st);
+
 void ff_configure_buffers_for_index(AVFormatContext *s, int64_t time_tolerance);
 
 /**
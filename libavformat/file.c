@@ -19,13 +19,26 @@
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
  */
 
+#include "config.h"
 #include "config_components.h"
 
+#if HAVE_COPY_FILE_RANGE
+#ifndef _GNU_SOURCE
+# define _GNU_SOURCE
+#endif
+#endif
+#define _DEFAULT_SOURCE
+#define _SVID_SOURCE // needed for MAP_ANONYMOUS
+#define _DARWIN_C_SOURCE // needed for MAP_ANON
+
+#include "libavcodec/defs.h"
 #include "libavutil/avstring.h"
+#include "libavutil/buffer.h"
 #include "libavutil/file_open.h"
 #include "libavutil/internal.h"
 #include "libavutil/mem.h"
 #include "libavutil/opt.h"
+#include "libavutil/thread.h"
 #include "avio.h"
 #if HAVE_DIRENT_H
 #include <dirent.h>
@@ -39,6 +52,17 @@
 #endif
 #include <sys/stat.h>
 #include <stdlib.h>
+#if HAVE_MMAP
+#include <sys/mman.h>
+#if defined(MAP_ANON) && !defined(MAP_ANONYMOUS)
+#define MAP_ANONYMOUS MAP_ANON
+#endif
+#endif
+#if HAVE_MMAP && HAVE_MPROTECT && defined(MAP_ANONYMOUS)
+#define FILE_MAP 1
+#else
+#define FILE_MAP 0
+#endif
 #include "os_support.h"
 #include "url.h"
 
@@ -89,6 +113,41 @@
 
 /* standard file protocol */
 
+typedef struct FileBlock {
+    uint8_t *data;
+    int size;       ///< bytes of valid or queued data
+    int64_t pos;    ///< file offset of data
+    int err;        ///< error or AVERROR_EOF hit after the data, read only
+} FileBlock;
+
+/**
+ * State shared with the background I/O thread. The thread owns the file
+ * offset of the descriptor while it runs. Blocks are handed over in ring
+ * order: blocks[head] to blocks[head + count - 1] are owned by the reader
+ * when reading, and by the I/O thread when writing.
+ */
+typedef struct FileAsync {
+    FileBlock *blocks;
+    int nb_blocks;
+    int block_size;
+    int write;
+    int head, count;
+    int offset;         ///< read: bytes consumed from blocks[head];
+                        ///< write: bytes filled in the next block
+    int64_t pos;        ///< logical position
+    int64_t io_pos;     ///< file offset of the next read
+    int io_seek;        ///< io_pos does not match the descriptor offset
+    unsigned generation;
+    int io_stop;        ///< end of file or error reached by the I/O thread
+    int io_error;       ///< write error
+    int abort_request;
+
+    pthread_t thread;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond_io;
+    pthread_cond_t cond_main;
+} FileAsync;
+
 typedef struct FileContext {
     const AVClass *class;
     int fd;
@@ -97,6 +156,12 @@ typedef struct FileContext {
     int pkt_size;
     int follow;
     int seekable;
+    int readahead;
+    int write_behind;
+    int io_block_size;
+    int use_mmap;
+    FileAsync *async;
+    size_t page_size;       ///< nonzero if ranges of the file can be mapped
 #if HAVE_DIRENT_H
     DIR *dir;
 #endif
@@ -108,6 +173,10 @@ static const AVOption file_options[] = {
     { "follow", "Follow a file as it is being written", offsetof(FileContext, follow), AV_OPT_TYPE_INT, { .i64 = 0 }, 0, 1, AV_OPT_FLAG_DECODING_PARAM },
     { "seekable", "Sets if the file is seekable", offsetof(FileContext, seekable), AV_OPT_TYPE_INT, { .i64 = -1 }, -1, 0, AV_OPT_FLAG_DECODING_PARAM | AV_OPT_FLAG_ENCODING_PARAM },
     { "pkt_size", "Maximum packet size", offsetof(FileContext, pkt_size), AV_OPT_TYPE_INT, { .i64 = 0 }, 0, INT_MAX, AV_OPT_FLAG_DECODING_PARAM | AV_OPT_FLAG_ENCODING_PARAM },
+    { "readahead", "number of blocks to read ahead in a background thread", offsetof(FileContext, readahead), AV_OPT_TYPE_INT, { .i64 = 0 }, 0, 1024, AV_OPT_FLAG_DECODING_PARAM },
+    { "write_behind", "number of blocks to write in a background thread", offsetof(FileContext, write_behind), AV_OPT_TYPE_INT, { .i64 = 0 }, 0, 1024, AV_OPT_FLAG_ENCODING_PARAM },
+    { "io_block_size", "size of the background I/O blocks", offsetof(FileContext, io_block_size), AV_OPT_TYPE_INT, { .i64 = 1 << 20 }, 4096, 1 << 30, AV_OPT_FLAG_DECODING_PARAM | AV_OPT_FLAG_ENCODING_PARAM },
+    { "mmap", "map the file into memory and return packets without copying", offsetof(FileContext, use_mmap), AV_OPT_TYPE_BOOL, { .i64 = 0 }, 0, 1, AV_OPT_FLAG_DECODING_PARAM },
     { NULL }
 };
 
@@ -138,10 +207,319 @@ static const AVClass fd_class = {
     .version    = LIBAVUTIL_VERSION_INT,
 };
 
+#if HAVE_THREADS
+static void *file_async_thread(void *arg)
+{
+    FileContext *c = arg;
+    FileAsync *a = c->async;
+
+    pthread_mutex_lock(&a->mutex);
+    for (;;) {
+        FileBlock *blk;
+        unsigned generation;
+        int64_t pos;
+        int ret, err = 0;
+
+        if (a->write) {
+            if (!a->count) {
+                if (a->abort_request)
+                    break;
+                pthread_cond_wait(&a->cond_io, &a->mutex);
+                continue;
+            }
+            blk = &a->blocks[a->head];
+            pthread_mutex_unlock(&a->mutex);
+
+            for (int done = 0; done < blk->size && !err; done += ret) {
+                ret = write(c->fd, blk->data + done, blk->size - done);
+                if (ret < 0)
+                    err = AVERROR(errno);
+            }
+
+            pthread_mutex_lock(&a->mutex);
+            if (err && !a->io_error)
+                a->io_error = err;
+            a->head = (a->head + 1) % a->nb_blocks;
+            a->count--;
+            pthread_cond_signal(&a->cond_main);
+            continue;
+        }
+
+        if (a->abort_request)
+            break;
+        if (a->count == a->nb_blocks || a->io_stop) {
+            pthread_cond_wait(&a->cond_io, &a->mutex);
+            continue;
+        }
+        blk        = &a->blocks[(a->head + a->count) % a->nb_blocks];
+        pos        = a->io_pos;
+        generation = a->generation;
+        if (a->io_seek && lseek(c->fd, pos, SEEK_SET) < 0)
+            err = AVERROR(errno);
+        a->io_seek = 0;
+        pthread_mutex_unlock(&a->mutex);
+
+        ret = err ? 0 : read(c->fd, blk->data, a->block_size);
+        if (ret < 0)
+            err = AVERROR(errno);
+
+        pthread_mutex_lock(&a->mutex);
+        if (generation != a->generation) {
+            /* the reader seeked away while the read was in progress */
+            pthread_cond_signal(&a->cond_main);
+            continue;
+        }
+        blk->pos  = pos;
+        blk->size = FFMAX(ret, 0);
+        blk->err  = err ? err : !ret ? AVERROR_EOF : 0;
+        a->io_stop = blk->err < 0;
+        a->io_pos += blk->size;
+        a->count++;
+        pthread_cond_signal(&a->cond_main);
+    }
+    pthread_mutex_unlock(&a->mutex);
+
+    return NULL;
+}
+
+static int file_async_read(URLContext *h, unsigned char *buf, int size)
+{
+    FileContext *c = h->priv_data;
+    FileAsync *a = c->async;
+    FileBlock *blk;
+
+    pthread_mutex_lock(&a->mutex);
+    while (!a->count)
+        pthread_cond_wait(&a->cond_main, &a->mutex);
+    blk = &a->blocks[a->head];
+    pthread_mutex_unlock(&a->mutex);
+
+    /* the block is owned by the reader until it is handed back */
+    size = FFMIN(size, blk->size - a->offset);
+    if (!size)
+        return blk->err;
+    memcpy(buf, blk->data + a->offset, size);
+    a->offset += size;
+    a->pos    += size;
+
+    if (a->offset == blk->size && !blk->err) {
+        pthread_mutex_lock(&a->mutex);
+        a->head   = (a->head + 1) % a->nb_blocks;
+        a->count--;
+        a->offset = 0;
+        pthread_cond_signal(&a->cond_io);
+        pthread_mutex_unlock(&a->mutex);
+    }
+    return size;
+}
+
+/* queue the partially filled block and wait until all blocks are written */
+static int file_async_flush(FileAsync *a)
+{
+    int ret;
+
+    pthread_mutex_lock(&a->mutex);
+    if (a->offset) {
+        a->blocks[(a->head + a->count) % a->nb_blocks].size = a->offset;
+        a->count++;
+        a->offset = 0;
+        pthread_cond_signal(&a->cond_io);
+    }
+    while (a->count)
+        pthread_cond_wait(&a->cond_main, &a->mutex);
+    ret = a->io_error;
+    pthread_mutex_unlock(&a->mutex);
+
+    return ret;
+}
+
+static int file_async_write(URLContext *h, const unsigned char *buf, int size)
+{
+    FileContext *c = h->priv_data;
+    FileAsync *a = c->async;
+    FileBlock *blk;
+    int ret;
+
+    pthread_mutex_lock(&a->mutex);
+    while (a->count == a->nb_blocks)
+        pthread_cond_wait(&a->cond_main, &a->mutex);
+    ret = a->io_error;
+    blk = &a->blocks[(a->head + a->count) % a->nb_blocks];
+    pthread_mutex_unlock(&a->mutex);
+    if (ret < 0)
+        return ret;
+
+    size = FFMIN(size, a->block_size - a->offset);
+    memcpy(blk->data + a->offset, buf, size);
+    a->offset += size;
+    a->pos    += size;
+
+    if (a->offset == a->block_size) {
+        pthread_mutex_lock(&a->mutex);
+        blk->size = a->block_size;
+        a->count++;
+        a->offset = 0;
+        pthread_cond_signal(&a->cond_io);
+        pthread_mutex_unlock(&a->mutex);
+    }
+    return size;
+}
+
+static int64_t file_async_seek(URLContext *h, int64_t pos, int whence)
+{
+    FileContext *c = h->priv_data;
+    FileAsync *a = c->async;
+    struct stat st;
+    int64_t ret;
+
+    if (a->write) {
+        if ((ret = file_async_flush(a)) < 0)
+            return ret;
+        /* the I/O thread is idle until more data is queued */
+        if (whence == AVSEEK_SIZE)
+            return fstat(c->fd, &st) < 0 ? AVERROR(errno) : st.st_size;
+        ret = lseek(c->fd, pos, whence);
+        if (ret < 0)
+            return AVERROR(errno);
+        return a->pos = ret;
+    }
+
+    if (whence == AVSEEK_SIZE || whence == SEEK_END) {
+        if (fstat(c->fd, &st) < 0)
+            return AVERROR(errno);
+        if (whence == AVSEEK_SIZE)
+            return st.st_size;
+        pos += st.st_size;
+    } else if (whence == SEEK_CUR) {
+        pos += a->pos;
+    } else if (whence != SEEK_SET) {
+        return AVERROR(EINVAL);
+    }
+    if (pos < 0)
+        return AVERROR(EINVAL);
+
+    pthread_mutex_lock(&a->mutex);
+    /* drop the blocks before the target, keeping what was read ahead */
+    while (a->count) {
+        FileBlock *blk = &a->blocks[a->head];
+        if (pos >= blk->pos && pos <= blk->pos + blk->size &&
+            (pos < blk->pos + blk->size || blk->err))
+            break;
+        a->head = (a->head + 1) % a->nb_blocks;
+        a->count--;
+    }
+    if (a->count) {
+        a->offset = pos - a->blocks[a->head].pos;
+    } else {
+        a->generation++;
+        a->head    = 0;
+        a->offset  = 0;
+        a->io_pos  = pos;
+        a->io_seek = 1;
+        a->io_stop = 0;
+    }
+    pthread_cond_signal(&a->cond_io);
+    pthread_mutex_unlock(&a->mutex);
+
+    return a->pos = pos;
+}
+
+static int file_async_close(URLContext *h)
+{
+    FileContext *c = h->priv_data;
+    FileAsync *a = c->async;
+    int ret = 0;
+
+    if (a->write)
+        ret = file_async_flush(a);
+
+    pthread_mutex_lock(&a->mutex);
+    a->abort_request = 1;
+    pthread_cond_signal(&a->cond_io);
+    pthread_mutex_unlock(&a->mutex);
+    pthread_join(a->thread, NULL);
+
+    pthread_cond_destroy(&a->cond_main);
+    pthread_cond_destroy(&a->cond_io);
+    pthread_mutex_destroy(&a->mutex);
+    for (int i = 0; i < a->nb_blocks; i++)
+        av_freep(&a->blocks[i].data);
+    av_freep(&a->blocks);
+    av_freep(&c->async);
+
+    return ret;
+}
+
+static int file_async_open(URLContext *h, int nb_blocks, int write)
+{
+    FileContext *c = h->priv_data;
+    FileAsync *a;
+    int64_t pos;
+    int ret;
+
+    pos = lseek(c->fd, 0, SEEK_CUR);
+    if (pos < 0)
+        return AVERROR(errno);
+
+    a = c->async = av_mallocz(sizeof(*a));
+    if (!a)
+        return AVERROR(ENOMEM);
+    a->blocks = av_calloc(nb_blocks, sizeof(*a->blocks));
+    if (!a->blocks)
+        goto fail;
+    for (a->nb_blocks = 0; a->nb_blocks < nb_blocks; a->nb_blocks++) {
+        a->blocks[a->nb_blocks].data = av_malloc(c->io_block_size);
+        if (!a->blocks[a->nb_blocks].data)
+            goto fail;
+    }
+    a->block_size = c->io_block_size;
+    a->write      = write;
+    a->pos        = a->io_pos = pos;
+
+    ret = pthread_mutex_init(&a->mutex, NULL);
+    if (ret)
+        goto fail_ret;
+    ret = pthread_cond_init(&a->cond_io, NULL);
+    if (ret)
+        goto fail_mutex;
+    ret = pthread_cond_init(&a->cond_main, NULL);
+    if (ret)
+        goto fail_cond_io;
+    ret = pthread_create(&a->thread, NULL, file_async_thread, c);
+    if (ret)
+        goto fail_cond_main;
+
+    return 0;
+
+fail_cond_main:
+    pthread_cond_destroy(&a->cond_main);
+fail_cond_io:
+    pthread_cond_destroy(&a->cond_io);
+fail_mutex:
+    pthread_mutex_destroy(&a->mutex);
+fail_ret:
+    av_log(h, AV_LOG_ERROR, "Failed to start the I/O thread: %s\n", av_err2str(AVERROR(ret)));
+    ret = AVERROR(ret);
+    goto free;
+fail:
+    ret = AVERROR(ENOMEM);
+free:
+    for (int i = 0; i < a->nb_blocks; i++)
+        av_freep(&a->blocks[i].data);
+    av_freep(&a->blocks);
+    av_freep(&c->async);
+    return ret;
+}
+#endif /* HAVE_THREADS */
+
 static int file_read(URLContext *h, unsigned char *buf, int size)
 {
     FileContext *c = h->priv_data;
     int ret;
+#if HAVE_THREADS
+    if (c->async)
+        return file_async_read(h, buf, size);
+#endif
     size = FFMIN(size, c->blocksize);
     ret = read(c->fd, buf, size);
     if (ret == 0 && c->follow)
@@ -155,6 +533,10 @@ static int file_write(URLContext *h, const unsigned char *buf, int size)
 {
     FileContext *c = h->priv_data;
     int ret;
+#if HAVE_THREADS
+    if (c->async)
+        return file_async_write(h, buf, size);
+#endif
     size = FFMIN(size, c->blocksize);
     ret = write(c->fd, buf, size);
     return (ret == -1) ? AVERROR(errno) : ret;
@@ -223,8 +605,13 @@ static int fd_dup(URLContext *h, int oldfd)
 static int file_close(URLContext *h)
 {
     FileContext *c = h->priv_data;
-    int ret = close(c->fd);
-    return (ret == -1) ? AVERROR(errno) : 0;
+    int ret, async_ret = 0;
+#if HAVE_THREADS
+    if (c->async)
+        async_ret = file_async_close(h);
+#endif
+    ret = close(c->fd);
+    return (ret == -1) ? AVERROR(errno) : async_ret;
 }
 
 /* XXX: use llseek */
@@ -233,6 +620,11 @@ static int64_t file_seek(URLContext *h, int64_t pos, int whence)
     FileContext *c = h->priv_data;
     int64_t ret;
 
+#if HAVE_THREADS
+    if (c->async)
+        return file_async_seek(h, pos, whence);
+#endif
+
     if (whence == AVSEEK_SIZE) {
         struct stat st;
         ret = fstat(c->fd, &st);
@@ -282,6 +674,114 @@ static int file_move(URLContext *h_src, URLContext *h_dst)
     return 0;
 }
 
+#if FILE_MAP
+/* below this, mapping costs more than copying */
+#define MAP_MIN_SIZE (64 * 1024)
+
+static void file_unmap(void *opaque, uint8_t *data)
+{
+    const uintptr_t page_mask = sysconf(_SC_PAGESIZE) - 1;
+
+    munmap((void *)((uintptr_t)data & ~page_mask), (size_t)(uintptr_t)opaque);
+}
+
+/**
+ * Map the whole pages of the range read-only and read the partial last
+ * page into an anonymous page, so the padding after the data is zeroed.
+ */
+static int file_map(URLContext *h, int64_t pos, int size, AVBufferRef **buf)
+{
+    FileContext *c = h->priv_data;
+    int64_t start, end;
+    size_t len;
+    struct stat st;
+    uint8_t *base;
+
+    if (!c->page_size || size < MAP_MIN_SIZE)
+        return AVERROR(ENOSYS);
+
+    start = pos & ~(int64_t)(c->page_size - 1);
+    end   = (pos + size) & ~(int64_t)(c->page_size - 1);
+    len   = FFALIGN(pos - start + size + AV_INPUT_BUFFER_PADDING_SIZE, c->page_size);
+
+    /* accessing pages past the end of a truncated file raises SIGBUS */
+    if (fstat(c->fd, &st) < 0 || pos + size > st.st_size)
+        return AVERROR(ENOSYS);
+
+    base = mmap(NULL, len, PROT_READ | PROT_WRITE,
+                MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED)
+        return AVERROR(ENOSYS);
+
+    if (end > start &&
+        mmap(base, end - start, PROT_READ, MAP_PRIVATE | MAP_FIXED,
+             c->fd, start) == MAP_FAILED)
+        goto fail;
+    if (pread(c->fd, base + (end - start), pos + size - end, end) != pos + size - end)
+        goto fail;
+    if (mprotect(base + (end - start), len - (end - start), PROT_READ) < 0)
+        goto fail;
+
+    *buf = av_buffer_create(base + (pos - start), size + AV_INPUT_BUFFER_PADDING_SIZE,
+                            file_unmap, (void *)(uintptr_t)len,
+                            AV_BUFFER_FLAG_READONLY);
+    if (!*buf) {
+        munmap(base, len);
+        return AVERROR(ENOMEM);
+    }
+    return 0;
+
+fail:
+    munmap(base, len);
+    return AVERROR(ENOSYS);
+}
+#endif
+
+#if HAVE_COPY_FILE_RANGE
+static int file_shift_data(URLContext *h, URLContext *src,
+                           int64_t pos, int64_t end, int64_t shift)
+{
+    FileContext *c = h->priv_data;
+    /* the output may be write-only, so read through the reopened one */
+    int fd = ((FileContext *)src->priv_data)->fd;
+    int64_t left = end - pos, moved = 0;
+
+#if HAVE_THREADS
+    int ret;
+
+    if (c->async && (ret = file_async_flush(c->async)) < 0)
+        return ret;
+#endif
+
+    /* Copy from the end in chunks of at most shift bytes, so that the
+     * source and destination of each copy do not overlap and no byte is
+     * overwritten before it has been copied. The copy stays in the kernel,
+     * which saves the round-trip through userspace but not the I/O itself:
+     * filesystems can only share extents for block-aligned ranges, which
+     * the shifts done by muxers rarely are. */
+    while (left > 0) {
+        int64_t chunk = FFMIN(left, shift);
+        off_t in  = pos + left - chunk;
+        off_t out = in + shift;
+
+        left -= chunk;
+        while (chunk > 0) {
+            ssize_t n = copy_file_range(fd, &in, c->fd, &out,
+                                        FFMIN(chunk, 1 << 30), 0);
+            if (n <= 0) {
+                /* if nothing has been moved yet, let the caller copy */
+                return !moved ? AVERROR(ENOSYS) :
+                       n < 0  ? AVERROR(errno) : AVERROR(EIO);
+            }
+            chunk -= n;
+            moved += n;
+        }
+    }
+
+    return 0;
+}
+#endif
+
 static int file_open(URLContext *h, const char *filename, int flags)
 {
     FileContext *c = h->priv_data;
@@ -328,6 +828,28 @@ static int file_open(URLContext *h, const char *filename, int flags)
     if (c->seekable >= 0)
         h->is_streamed = !c->seekable;
 
+#if HAVE_THREADS
+    /* the I/O thread needs exclusive use of the file offset */
+    if ((c->readahead || c->write_behind) && !c->follow &&
+        (flags & AVIO_FLAG_READ_WRITE) != AVIO_FLAG_READ_WRITE &&
+        !fstat(fd, &st) && S_ISREG(st.st_mode)) {
+        int write = !!(flags & AVIO_FLAG_WRITE);
+        int nb_blocks = write ? c->write_behind : c->readahead;
+        int ret;
+
+        if (nb_blocks && (ret = file_async_open(h, nb_blocks, write)) < 0) {
+            close(fd);
+            return ret;
+        }
+    }
+#endif
+
+#if FILE_MAP
+    if (c->use_mmap && !c->follow && !(flags & AVIO_FLAG_WRITE) &&
+        !fstat(fd, &st) && S_ISREG(st.st_mode))
+        c->page_size = sysconf(_SC_PAGESIZE);
+#endif
+
     return 0;
 }
 
@@ -423,6 +945,12 @@ const URLProtocol ff_file_protocol = {
     .url_seek            = file_seek,
     .url_close           = file_close,
     .url_get_file_handle = file_get_handle,
+#if FILE_MAP
+    .url_map             = file_map,
+#endif
+#if HAVE_COPY_FILE_RANGE
+    .url_shift_data      = file_shift_data,
+#endif
     .url_check           = file_check,
     .url_delete          = file_delete,
     .url_move            = file_move,
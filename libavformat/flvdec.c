@@ -1034,6 +1034,7 @@ static void clear_index_entries(AVFormatContext *s, int64_t pos)
     for (unsigned i = 0; i < s->nb_streams; i++) {
         FFStream *const sti = ffstream(s->streams[i]);
         int out = 0;
+        ff_flush_index_entries(s->streams[i]);
         /* Remove all index entries that point to >= pos */
         for (int j = 0; j < sti->nb_index_entries; j++)
             if (sti->index_entries[j].pos < pos)
@@ -1600,8 +1601,10 @@ skip:
 
         if ((s->pb->seekable & AVIO_SEEKABLE_NORMAL) &&
             ((flags & FLV_VIDEO_FRAMETYPE_MASK) == FLV_FRAME_KEY ||
-             stream_type == FLV_STREAM_TYPE_AUDIO))
-            av_add_index_entry(st, pos, dts, track_size, 0, AVINDEX_KEYFRAME);
+             stream_type == FLV_STREAM_TYPE_AUDIO)) {
+            ff_reduce_index(s, st->index);
+            ff_add_index_entry_deferred(st, pos, dts, track_size, 0, AVINDEX_KEYFRAME);
+        }
 
         if ((st->discard >= AVDISCARD_NONKEY && !((flags & FLV_VIDEO_FRAMETYPE_MASK) == FLV_FRAME_KEY || stream_type == FLV_STREAM_TYPE_AUDIO)) ||
             (st->discard >= AVDISCARD_BIDIR && ((flags & FLV_VIDEO_FRAMETYPE_MASK) == FLV_FRAME_DISP_INTER && stream_type == FLV_STREAM_TYPE_VIDEO)) ||
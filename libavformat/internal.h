@@ -186,6 +186,16 @@ typedef struct FFStream {
     int nb_index_entries;
     unsigned int index_entries_allocated_size;
 
+    /**
+     * Entries added out of order by ff_add_index_entry_deferred() and not
+     * merged into index_entries yet. They are kept as sorted runs whose
+     * sizes are the bits set in nb_index_pending, largest run first, so
+     * that each insertion costs O(log n) amortized.
+     */
+    AVIndexEntry *index_pending;
+    int nb_index_pending;
+    unsigned int index_pending_allocated_size;
+
     int64_t interleaver_chunk_size;
     int64_t interleaver_chunk_duration;
 
@@ -483,6 +493,15 @@ int ff_get_line(AVIOContext *s, char *buf, int maxlen);
  */
 int ff_get_chomp_line(AVIOContext *s, char *buf, int maxlen);
 
+/**
+ * Same as av_get_packet(), but if the input can be memory mapped and
+ * codec_id is raw PCM or raw video, the packet references a mapping of the
+ * data instead of a copy. The packet data is then not writable.
+ * Demuxers must not modify the data of packets read this way.
+ */
+int ff_get_packet_mapped(AVIOContext *s, AVPacket *pkt, int size,
+                         enum AVCodecID codec_id);
+
 #define SPACE_CHARS " \t\r\n"
 
 /**
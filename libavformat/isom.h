@@ -170,6 +170,65 @@ typedef struct MOVIndexRange {
     int64_t end;
 } MOVIndexRange;
 
+/**
+ * Consecutive index entries which correspond to consecutive samples.
+ */
+typedef struct MOVIndexRun {
+    unsigned int first;   ///< first index entry of the run
+    unsigned int sample;  ///< sample of the first index entry
+    int64_t ts_offset;    ///< added to the timestamps of the samples
+    int flags;            ///< added to the flags of the samples
+} MOVIndexRun;
+
+/**
+ * Consecutive chunks with the same number of samples.
+ */
+typedef struct MOVChunkRun {
+    unsigned int chunk;   ///< first chunk of the run
+    unsigned int sample;  ///< first sample of the run
+    unsigned int count;   ///< number of samples per chunk
+} MOVChunkRun;
+
+/**
+ * Consecutive samples with the same duration.
+ */
+typedef struct MOVSampleTime {
+    unsigned int sample;  ///< first sample of the run
+    unsigned int duration;
+    int64_t dts;          ///< dts of the first sample
+} MOVSampleTime;
+
+/**
+ * Index of a stream whose entries are computed on demand from the sample
+ * tables instead of being stored in FFStream.index_entries.
+ */
+typedef struct MOVCompactIndex {
+    MOVIndexRun *runs;
+    unsigned int nb_runs;
+    unsigned int runs_allocated_size;
+    unsigned int nb_entries;
+    unsigned int run;     ///< run of the last accessed entry
+
+    MOVChunkRun *chunk_runs;
+    unsigned int nb_chunk_runs;
+    MOVSampleTime *times;
+    unsigned int nb_times;
+    unsigned int sample_size;
+    int all_keyframes;    ///< every sample is a keyframe
+    int key_tables;       ///< keyframes are listed in stss and/or stps
+    int use_stss;
+    int key_off;
+
+    /* state of the last sample position lookup */
+    unsigned int pos_sample;
+    unsigned int chunk_end;
+    int64_t pos;
+    unsigned int time;    ///< time run of the last accessed sample
+
+    AVIndexEntry entry;   ///< storage for the entry of the current sample
+    int64_t entry_index;  ///< index of entry, -1 if none
+} MOVCompactIndex;
+
 typedef struct MOVStreamContext {
     AVIOContext *pb;
     int refcount;
@@ -214,6 +273,7 @@ typedef struct MOVStreamContext {
     int64_t current_index;
     MOVIndexRange* index_ranges;
     MOVIndexRange* current_index_range;
+    MOVCompactIndex *compact_index;
     unsigned int bytes_per_frame;
     unsigned int samples_per_frame;
     int dv_audio_container;
@@ -344,6 +404,7 @@ typedef struct MOVContext {
     int use_absolute_path;
     int ignore_editlist;
     int advanced_editlist;
+    int compact_index;
     int advanced_editlist_autodisabled;
     int ignore_chapters;
     int seek_individually;
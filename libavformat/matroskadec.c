@@ -4192,8 +4192,8 @@ static int matroska_parse_block(MatroskaDemuxContext *matroska, AVBufferRef *buf
             is_keyframe = 0;  /* overlapping subtitles are not key frame */
         if (is_keyframe) {
             ff_reduce_index(matroska->ctx, st->index);
-            av_add_index_entry(st, cluster_pos, timecode, 0, 0,
-                               AVINDEX_KEYFRAME);
+            ff_add_index_entry_deferred(st, cluster_pos, timecode, 0, 0,
+                                        AVINDEX_KEYFRAME);
         }
     }
 
@@ -3950,9 +3950,301 @@ static int get_edit_list_entry(MOVContext *mov,
     return 1;
 }
 
+static unsigned int compact_sample_size(const MOVStreamContext *sc, unsigned int sample)
+{
+    const MOVCompactIndex *ci = sc->compact_index;
+    return ci->sample_size ? ci->sample_size : sc->sample_sizes[sample];
+}
+
+static int64_t compact_sample_pos(MOVStreamContext *sc, unsigned int sample)
+{
+    MOVCompactIndex *ci = sc->compact_index;
+
+    if (sample < ci->pos_sample || sample >= ci->chunk_end) {
+        const MOVChunkRun *cr;
+        unsigned int a = 0, b = ci->nb_chunk_runs, chunk;
+
+        while (b - a > 1) {
+            unsigned int m = (a + b) >> 1;
+            if (ci->chunk_runs[m].sample <= sample)
+                a = m;
+            else
+                b = m;
+        }
+        cr = &ci->chunk_runs[a];
+        chunk = (sample - cr->sample) / cr->count;
+        ci->pos_sample = cr->sample + chunk * cr->count;
+        ci->chunk_end  = ci->pos_sample + cr->count;
+        ci->pos        = sc->chunk_offsets[cr->chunk + chunk];
+    }
+    for (; ci->pos_sample < sample; ci->pos_sample++)
+        ci->pos += compact_sample_size(sc, ci->pos_sample);
+
+    return ci->pos;
+}
+
+static int64_t compact_sample_dts(MOVCompactIndex *ci, unsigned int sample)
+{
+    const MOVSampleTime *t = &ci->times[ci->time];
+
+    if (sample < t->sample ||
+        (ci->time + 1 < ci->nb_times && sample >= t[1].sample)) {
+        unsigned int a = 0, b = ci->nb_times;
+
+        while (b - a > 1) {
+            unsigned int m = (a + b) >> 1;
+            if (ci->times[m].sample <= sample)
+                a = m;
+            else
+                b = m;
+        }
+        ci->time = a;
+        t = &ci->times[a];
+    }
+
+    return t->dts + (int64_t)(sample - t->sample) * t->duration;
+}
+
+/**
+ * Return the last keyframe at or before sample, -1 if there is none.
+ */
+static int64_t compact_last_keyframe(const MOVStreamContext *sc, unsigned int sample)
+{
+    const MOVCompactIndex *ci = sc->compact_index;
+    int64_t key = -1, s = sample + (int64_t)ci->key_off;
+    unsigned int a, b;
+
+    if (ci->all_keyframes)
+        return sample;
+    if (!ci->key_tables) /* only the first sample is a keyframe */
+        return 0;
+
+    if (ci->use_stss && sc->keyframes[0] <= s) {
+        for (a = 0, b = sc->keyframe_count; b - a > 1;) {
+            unsigned int m = (a + b) >> 1;
+            if (sc->keyframes[m] <= s)
+                a = m;
+            else
+                b = m;
+        }
+        key = sc->keyframes[a];
+    }
+    if (sc->stps_count && sc->stps_data[0] <= s) {
+        for (a = 0, b = sc->stps_count; b - a > 1;) {
+            unsigned int m = (a + b) >> 1;
+            if (sc->stps_data[m] <= s)
+                a = m;
+            else
+                b = m;
+        }
+        key = FFMAX(key, sc->stps_data[a]);
+    }
+
+    return key < 0 ? -1 : key - ci->key_off;
+}
+
+static int compact_sample_flags(const MOVStreamContext *sc, unsigned int sample)
+{
+    return compact_last_keyframe(sc, sample) == sample ? AVINDEX_KEYFRAME : 0;
+}
+
+static void compact_sample_entry(MOVStreamContext *sc, unsigned int sample,
+                                 AVIndexEntry *e)
+{
+    int64_t key = compact_last_keyframe(sc, sample);
+
+    e->pos          = compact_sample_pos(sc, sample);
+    e->timestamp    = compact_sample_dts(sc->compact_index, sample);
+    e->size         = compact_sample_size(sc, sample);
+    e->min_distance = sample - FFMAX(key, 0);
+    e->flags        = key == sample ? AVINDEX_KEYFRAME : 0;
+}
+
+static const MOVIndexRun *compact_find_run(MOVCompactIndex *ci, unsigned int index)
+{
+    const MOVIndexRun *run = &ci->runs[ci->run];
+
+    if (index < run->first ||
+        (ci->run + 1 < ci->nb_runs && index >= run[1].first)) {
+        unsigned int a = 0, b = ci->nb_runs;
+
+        while (b - a > 1) {
+            unsigned int m = (a + b) >> 1;
+            if (ci->runs[m].first <= index)
+                a = m;
+            else
+                b = m;
+        }
+        ci->run = a;
+        run = &ci->runs[a];
+    }
+    return run;
+}
+
+static const AVIndexEntry *compact_index_entry(MOVStreamContext *sc, unsigned int index,
+                                               AVIndexEntry *e)
+{
+    const MOVIndexRun *run = compact_find_run(sc->compact_index, index);
+
+    compact_sample_entry(sc, run->sample + (index - run->first), e);
+    e->timestamp += run->ts_offset;
+    e->flags     |= run->flags;
+    return e;
+}
+
+static int64_t compact_index_timestamp(void *opaque, int index, int *flags)
+{
+    MOVStreamContext *sc = opaque;
+    const MOVIndexRun *run = compact_find_run(sc->compact_index, index);
+    unsigned int sample = run->sample + (index - run->first);
+
+    *flags = compact_sample_flags(sc, sample) | run->flags;
+    return compact_sample_dts(sc->compact_index, sample) + run->ts_offset;
+}
+
+static int compact_index_search_timestamp(MOVStreamContext *sc,
+                                          int64_t wanted_timestamp, int flags)
+{
+    return ff_index_search_timestamp_cb(sc, sc->compact_index->nb_entries,
+                                        compact_index_timestamp,
+                                        wanted_timestamp, flags);
+}
+
+/**
+ * Append an index entry to the runs of ci. Samples which follow each other
+ * with the same timestamp offset and flags are merged into one run.
+ */
+static int add_index_run(MOVCompactIndex *ci, unsigned int sample,
+                         int64_t ts_offset, int flags)
+{
+    MOVIndexRun *run = ci->nb_runs ? &ci->runs[ci->nb_runs - 1] : NULL;
+
+    if (ci->nb_entries >= INT_MAX)
+        return -1;
+
+    if (!run || run->sample + (ci->nb_entries - run->first) != sample ||
+        run->ts_offset != ts_offset || run->flags != flags) {
+        if (ci->nb_runs >= UINT_MAX / sizeof(*ci->runs) - 1)
+            return -1;
+        run = av_fast_realloc(ci->runs, &ci->runs_allocated_size,
+                              (ci->nb_runs + 1) * sizeof(*ci->runs));
+        if (!run)
+            return -1;
+        ci->runs = run;
+        run = &run[ci->nb_runs++];
+        run->first     = ci->nb_entries;
+        run->sample    = sample;
+        run->ts_offset = ts_offset;
+        run->flags     = flags;
+    }
+    ci->nb_entries++;
+    return 0;
+}
+
+/**
+ * Append entry index of the compact index of sc to the runs of dst, with the
+ * given timestamp and flags.
+ */
+static int add_compact_index_entry(MOVStreamContext *sc, MOVCompactIndex *dst,
+                                   unsigned int index, int64_t timestamp, int flags)
+{
+    MOVCompactIndex *ci = sc->compact_index;
+    const MOVIndexRun *run = compact_find_run(ci, index);
+    unsigned int sample = run->sample + (index - run->first);
+
+    return add_index_run(dst, sample, timestamp - compact_sample_dts(ci, sample),
+                         flags & ~compact_sample_flags(sc, sample));
+}
+
+static void mov_free_compact_index(MOVStreamContext *sc)
+{
+    MOVCompactIndex *ci = sc->compact_index;
+
+    if (!ci)
+        return;
+    av_freep(&ci->runs);
+    av_freep(&ci->chunk_runs);
+    av_freep(&ci->times);
+    av_freep(&sc->compact_index);
+}
+
+/**
+ * Replace the compact index of a stream by regular index entries.
+ */
+static int mov_expand_compact_index(AVStream *st)
+{
+    MOVStreamContext *sc = st->priv_data;
+    FFStream *const sti = ffstream(st);
+    AVIndexEntry *entries;
+    unsigned int nb_entries;
+
+    if (!sc || !sc->compact_index)
+        return 0;
+
+    nb_entries = sc->compact_index->nb_entries;
+    entries = av_malloc_array(nb_entries, sizeof(*entries));
+    if (!entries)
+        return AVERROR(ENOMEM);
+    for (unsigned int i = 0; i < nb_entries; i++)
+        compact_index_entry(sc, i, &entries[i]);
+
+    av_freep(&sti->index_entries);
+    sti->index_entries = entries;
+    sti->nb_index_entries = nb_entries;
+    sti->index_entries_allocated_size = nb_entries * sizeof(*entries);
+    mov_free_compact_index(sc);
+    av_freep(&sc->chunk_offsets);
+    av_freep(&sc->sample_sizes);
+    av_freep(&sc->keyframes);
+    av_freep(&sc->stps_data);
+    return 0;
+}
+
+static int mov_index_count(const AVStream *st)
+{
+    const MOVStreamContext *sc = st->priv_data;
+
+    return sc->compact_index ? sc->compact_index->nb_entries
+                             : cffstream(st)->nb_index_entries;
+}
+
+/**
+ * Return index entry index of a stream. buf is used as storage for the
+ * entry if the stream has a compact index.
+ */
+static const AVIndexEntry *mov_index_entry(AVStream *st, int index, AVIndexEntry *buf)
+{
+    MOVStreamContext *sc = st->priv_data;
+
+    if (sc->compact_index)
+        return compact_index_entry(sc, index, buf);
+    return &ffstream(st)->index_entries[index];
+}
+
+static int mov_index_search_timestamp(AVStream *st, int64_t wanted_timestamp, int flags)
+{
+    MOVStreamContext *sc = st->priv_data;
+    const FFStream *const sti = ffstream(st);
+
+    if (sc->compact_index)
+        return compact_index_search_timestamp(sc, wanted_timestamp, flags);
+    return ff_index_search_timestamp(sti->index_entries, sti->nb_index_entries,
+                                     wanted_timestamp, flags);
+}
+
+/**
+ * Return entry index of the index being rebuilt by mov_fix_index(), which is
+ * e_old or the compact index of the stream if e_old is NULL.
+ */
+static const AVIndexEntry *old_index_entry(MOVStreamContext *sc, const AVIndexEntry *e_old,
+                                           int64_t index, AVIndexEntry *buf)
+{
+    return e_old ? &e_old[index] : compact_index_entry(sc, index, buf);
+}
+
 /**
  * Find the closest previous frame to the timestamp_pts, in e_old index
- * entries. Searching for just any frame / just key frames can be controlled by
+ * entries, or in the compact index of the stream if e_old is NULL. Searching for just any frame / just key frames can be controlled by
  * last argument 'flag'.
  * Note that if ctts_data is not NULL, we will always search for a key frame
  * irrespective of the value of 'flag'. If we don't find any keyframe, we will
@@ -3981,9 +4273,8 @@ static int find_prev_closest_index(AVStream *st,
                                    int64_t* tts_sample)
 {
     MOVStreamContext *msc = st->priv_data;
-    FFStream *const sti = ffstream(st);
-    AVIndexEntry *e_keep = sti->index_entries;
-    int nb_keep = sti->nb_index_entries;
+    AVIndexEntry buf[2];
+    const AVIndexEntry *e, *prev;
     int64_t i = 0;
 
     av_assert0(index);
@@ -3995,16 +4286,22 @@ static int find_prev_closest_index(AVStream *st,
         timestamp_pts -= msc->dts_shift;
     }
 
-    sti->index_entries    = e_old;
-    sti->nb_index_entries = nb_old;
-    *index = av_index_search_timestamp(st, timestamp_pts, flag | AVSEEK_FLAG_BACKWARD);
+    if (e_old)
+        *index = ff_index_search_timestamp(e_old, nb_old, timestamp_pts,
+                                           flag | AVSEEK_FLAG_BACKWARD);
+    else
+        *index = compact_index_search_timestamp(msc, timestamp_pts,
+                                                flag | AVSEEK_FLAG_BACKWARD);
 
     // Keep going backwards in the index entries until the timestamp is the same.
     if (*index >= 0) {
-        for (i = *index; i > 0 && e_old[i].timestamp == e_old[i - 1].timestamp;
-             i--) {
+        for (i = *index; i > 0; i--) {
+            e    = old_index_entry(msc, e_old, i,     &buf[0]);
+            prev = old_index_entry(msc, e_old, i - 1, &buf[1]);
+            if (e->timestamp != prev->timestamp)
+                break;
             if ((flag & AVSEEK_FLAG_ANY) ||
-                (e_old[i - 1].flags & AVINDEX_KEYFRAME)) {
+                (prev->flags & AVINDEX_KEYFRAME)) {
                 *index = i - 1;
             }
         }
@@ -4032,8 +4329,9 @@ static int find_prev_closest_index(AVStream *st,
             // Find a "key frame" with PTS <= timestamp_pts (So that we can decode B-frames correctly).
             // No need to add dts_shift to the timestamp here because timestamp_pts has already been
             // compensated by dts_shift above.
-            if ((e_old[*index].timestamp + tts_data[*tts_index].offset) <= timestamp_pts &&
-                (e_old[*index].flags & AVINDEX_KEYFRAME)) {
+            e = old_index_entry(msc, e_old, *index, &buf[0]);
+            if ((e->timestamp + tts_data[*tts_index].offset) <= timestamp_pts &&
+                (e->flags & AVINDEX_KEYFRAME)) {
                 break;
             }
 
@@ -4048,9 +4346,6 @@ static int find_prev_closest_index(AVStream *st,
         }
     }
 
-    /* restore AVStream state*/
-    sti->index_entries    = e_keep;
-    sti->nb_index_entries = nb_keep;
     return *index >= 0 ? 0 : -1;
 }
 
@@ -4118,6 +4413,45 @@ static void fix_index_entry_timestamps(AVStream* st, int end_index, int64_t end_
     }
 }
 
+/**
+ * Same as fix_index_entry_timestamps() for the last entries of the runs of
+ * dst, which reference the compact index of sc.
+ */
+static int fix_compact_index_timestamps(MOVStreamContext *sc, MOVCompactIndex *dst,
+                                        int64_t end_ts, int64_t *frame_duration_buffer,
+                                        int frame_duration_buffer_size)
+{
+    unsigned int first = dst->nb_entries - frame_duration_buffer_size;
+    MOVIndexRun *entries;
+
+    av_assert0(frame_duration_buffer_size >= 0 &&
+               frame_duration_buffer_size <= dst->nb_entries);
+    entries = av_malloc_array(frame_duration_buffer_size, sizeof(*entries));
+    if (!entries)
+        return AVERROR(ENOMEM);
+
+    for (int i = 0; i < frame_duration_buffer_size; i++) {
+        const MOVIndexRun *run = compact_find_run(dst, first + i);
+        entries[i].sample = run->sample + (first + i - run->first);
+        entries[i].flags  = run->flags;
+    }
+    for (int i = frame_duration_buffer_size - 1; i >= 0; i--) {
+        end_ts -= frame_duration_buffer[i];
+        entries[i].ts_offset = end_ts - compact_sample_dts(sc->compact_index, entries[i].sample);
+    }
+
+    while (dst->nb_runs && dst->runs[dst->nb_runs - 1].first >= first)
+        dst->nb_runs--;
+    dst->nb_entries = first;
+    dst->run        = 0;
+    for (int i = 0; i < frame_duration_buffer_size; i++)
+        if (add_index_run(dst, entries[i].sample, entries[i].ts_offset, entries[i].flags) < 0)
+            break;
+
+    av_free(entries);
+    return 0;
+}
+
 static int add_tts_entry(MOVTimeToSample **tts_data, unsigned int *tts_count, unsigned int *allocated_size,
                          int count, int offset, unsigned int duration)
 {
@@ -4150,7 +4484,6 @@ static int add_tts_entry(MOVTimeToSample **tts_data, unsigned int *tts_count, un
 static void mov_estimate_video_delay(MOVContext *c, AVStream* st)
 {
     MOVStreamContext *msc = st->priv_data;
-    FFStream *const sti = ffstream(st);
     int ctts_ind = 0;
     int ctts_sample = 0;
     int64_t pts_buf[MAX_REORDER_DELAY + 1]; // Circular buffer to sort pts.
@@ -4163,14 +4496,15 @@ static void mov_estimate_video_delay(MOVContext *c, AVStream* st)
     if (st->codecpar->video_delay <= 0 && msc->ctts_count &&
         st->codecpar->codec_id == AV_CODEC_ID_H264) {
         st->codecpar->video_delay = 0;
-        for (int ind = 0; ind < sti->nb_index_entries && ctts_ind < msc->tts_count; ++ind) {
+        for (int ind = 0; ind < mov_index_count(st) && ctts_ind < msc->tts_count; ++ind) {
+            AVIndexEntry buf;
             // Point j to the last elem of the buffer and insert the current pts there.
             j = buf_start;
             buf_start = (buf_start + 1);
             if (buf_start == MAX_REORDER_DELAY + 1)
                 buf_start = 0;
 
-            pts_buf[j] = sti->index_entries[ind].timestamp + msc->tts_data[ctts_ind].offset;
+            pts_buf[j] = mov_index_entry(st, ind, &buf)->timestamp + msc->tts_data[ctts_ind].offset;
 
             // The timestamps that are already in the sorted buffer, and are greater than the
             // current pts, are exactly the timestamps that need to be buffered to output PTS
@@ -4259,9 +4593,11 @@ static void mov_fix_index(MOVContext *mov, AVStream *st)
 {
     MOVStreamContext *msc = st->priv_data;
     FFStream *const sti = ffstream(st);
+    MOVCompactIndex *ci = msc->compact_index;
+    MOVCompactIndex new_ci = { 0 };
     AVIndexEntry *e_old = sti->index_entries;
-    int nb_old = sti->nb_index_entries;
-    const AVIndexEntry *e_old_end = e_old + nb_old;
+    int nb_old = mov_index_count(st);
+    AVIndexEntry current_buf, next_buf;
     const AVIndexEntry *current = NULL;
     MOVTimeToSample *tts_data_old = msc->tts_data;
     int64_t tts_index_old = 0;
@@ -4368,7 +4704,8 @@ static void mov_fix_index(MOVContext *mov, AVStream *st)
             // Audio decoders like AAC need need a decoder delay samples previous to the current sample,
             // to correctly decode this frame. Hence for audio we seek to a frame 1 sec. before the
             // edit_list_media_time to cover the decoder delay.
-            search_timestamp = FFMAX(search_timestamp - msc->time_scale, e_old[0].timestamp);
+            search_timestamp = FFMAX(search_timestamp - msc->time_scale,
+                                     old_index_entry(msc, e_old, 0, &current_buf)->timestamp);
         }
 
         if (find_prev_closest_index(st, e_old, nb_old, tts_data_old, tts_count_old, search_timestamp, 0,
@@ -4386,16 +4723,17 @@ static void mov_fix_index(MOVContext *mov, AVStream *st)
                 tts_sample_old = 0;
             }
         }
-        current = e_old + index;
         edit_list_start_tts_sample = tts_sample_old;
 
         // Iterate over index and arrange it according to edit list
         edit_list_start_encountered = 0;
         found_keyframe_after_edit = 0;
-        for (; current < e_old_end; current++, index++) {
+        for (; index < nb_old; index++) {
+            current = old_index_entry(msc, e_old, index, &current_buf);
             // check  if frame outside edit list mark it for discard
-            frame_duration = (current + 1 <  e_old_end) ?
-                             ((current + 1)->timestamp - current->timestamp) : edit_list_duration;
+            frame_duration = (index + 1 < nb_old) ?
+                             (old_index_entry(msc, e_old, index + 1, &next_buf)->timestamp -
+                              current->timestamp) : edit_list_duration;
 
             flags = current->flags;
 
@@ -4440,8 +4778,12 @@ static void mov_fix_index(MOVContext *mov, AVStream *st)
                         // Make timestamps strictly monotonically increasing for audio, by rewriting timestamps for
                         // discarded packets.
                         if (frame_duration_buffer) {
-                            fix_index_entry_timestamps(st, sti->nb_index_entries, edit_list_dts_counter,
-                                                       frame_duration_buffer, num_discarded_begin);
+                            if (ci)
+                                fix_compact_index_timestamps(msc, &new_ci, edit_list_dts_counter,
+                                                             frame_duration_buffer, num_discarded_begin);
+                            else
+                                fix_index_entry_timestamps(st, sti->nb_index_entries, edit_list_dts_counter,
+                                                           frame_duration_buffer, num_discarded_begin);
                             av_freep(&frame_duration_buffer);
                         }
                     }
@@ -4479,15 +4821,20 @@ static void mov_fix_index(MOVContext *mov, AVStream *st)
                     // Make timestamps strictly monotonically increasing by rewriting timestamps for
                     // discarded packets.
                     if (frame_duration_buffer) {
-                        fix_index_entry_timestamps(st, sti->nb_index_entries, edit_list_dts_counter,
-                                                   frame_duration_buffer, num_discarded_begin);
+                        if (ci)
+                            fix_compact_index_timestamps(msc, &new_ci, edit_list_dts_counter,
+                                                         frame_duration_buffer, num_discarded_begin);
+                        else
+                            fix_index_entry_timestamps(st, sti->nb_index_entries, edit_list_dts_counter,
+                                                       frame_duration_buffer, num_discarded_begin);
                         av_freep(&frame_duration_buffer);
                     }
                 }
             }
 
-            if (add_index_entry(st, current->pos, edit_list_dts_counter, current->size,
-                                current->min_distance, flags) == -1) {
+            if ((ci ? add_compact_index_entry(msc, &new_ci, index, edit_list_dts_counter, flags)
+                    : add_index_entry(st, current->pos, edit_list_dts_counter, current->size,
+                                      current->min_distance, flags)) == -1) {
                 av_log(mov->fc, AV_LOG_ERROR, "Cannot add index entry\n");
                 break;
             }
@@ -4543,6 +4890,8 @@ static void mov_fix_index(MOVContext *mov, AVStream *st)
             av_log(mov->fc, AV_LOG_DEBUG, "Offset DTS by %"PRId64" to make first pts zero.\n", msc->min_corrected_pts);
             for (int i = 0; i < sti->nb_index_entries; ++i)
                 sti->index_entries[i].timestamp -= msc->min_corrected_pts;
+            for (int i = 0; i < new_ci.nb_runs; i++)
+                new_ci.runs[i].ts_offset -= msc->min_corrected_pts;
         }
     }
     // Start time should be equal to zero or the duration of any empty edits.
@@ -4557,6 +4906,16 @@ static void mov_fix_index(MOVContext *mov, AVStream *st)
     av_free(tts_data_old);
     av_freep(&frame_duration_buffer);
 
+    if (ci) {
+        av_free(ci->runs);
+        ci->runs                = new_ci.runs;
+        ci->nb_runs             = new_ci.nb_runs;
+        ci->runs_allocated_size = new_ci.runs_allocated_size;
+        ci->nb_entries          = new_ci.nb_entries;
+        ci->run                 = 0;
+        ci->entry_index         = -1;
+    }
+
     // Null terminate the index ranges array
     current_index_range = current_index_range ? current_index_range + 1
                                               : msc->index_ranges;
@@ -4706,6 +5065,210 @@ static int mov_merge_tts_data(MOVContext *mov, AVStream *st, int flags)
     return 0;
 }
 
+static int is_increasing(const unsigned int *tab, unsigned int count)
+{
+    for (unsigned int i = 1; i < count; i++)
+        if (tab[i] <= tab[i - 1])
+            return 0;
+    return 1;
+}
+
+/**
+ * Build a compact index of the samples of a stream, if the sample tables
+ * allow computing exactly the entries the loop in mov_build_index() creates.
+ *
+ * @return 1 if the compact index was built, 0 if the regular index must be
+ *         built instead, a negative AVERROR code on failure
+ */
+static int mov_build_compact_index(MOVContext *mov, AVStream *st,
+                                   int64_t current_dts, uint64_t *stream_size)
+{
+    MOVStreamContext *sc = st->priv_data;
+    MOVCompactIndex *ci;
+    MOVChunkRun *chunk_runs = NULL;
+    MOVSampleTime *times = NULL;
+    unsigned int nb_chunk_runs = 0, chunk_runs_size = 0;
+    unsigned int nb_times = 0, times_size = 0;
+    unsigned int stsz_sample_size = sc->stsz_sample_size;
+    unsigned int stsz_too_large = 0, stsz_too_small = 0;
+    unsigned int stsc_index = 0, current_sample = 0;
+    uint64_t size_sum = 0;
+    int key_off = (sc->keyframe_count && sc->keyframes[0] > 0) ||
+                  (sc->stps_count && sc->stps_data[0] > 0);
+    int all_keyframes = 0, key_tables = 0, use_stss = 0;
+    int ret = 0;
+
+    if (!mov->compact_index || sc->iamf || !sc->chunk_count || !sc->stsc_count ||
+        (st->codecpar->codec_type != AVMEDIA_TYPE_VIDEO &&
+         st->codecpar->codec_type != AVMEDIA_TYPE_AUDIO) ||
+        (sc->rap_group_count && sc->rap_group))
+        return 0;
+
+    /* the keyframe tables are walked once in order while building the
+     * regular index, so they must be sorted to be searchable */
+    if (sc->keyframe_absent && !sc->stps_count) {
+        all_keyframes = st->codecpar->codec_type == AVMEDIA_TYPE_AUDIO;
+    } else if (!sc->keyframe_absent && !sc->keyframe_count) {
+        all_keyframes = 1;
+    } else {
+        key_tables = 1;
+        use_stss   = !sc->keyframe_absent;
+        if ((use_stss && (sc->keyframes[0] < key_off ||
+                          !is_increasing((const unsigned int *)sc->keyframes,
+                                         sc->keyframe_count))) ||
+            (sc->stps_count && (sc->stps_data[0] < key_off ||
+                                !is_increasing(sc->stps_data, sc->stps_count))))
+            return 0;
+        /* a sample listed in both tables stops the walk over stps */
+        if (use_stss && sc->stps_count) {
+            for (unsigned int i = 0, j = 0; i < sc->keyframe_count && j < sc->stps_count;) {
+                if (sc->keyframes[i] == sc->stps_data[j])
+                    return 0;
+                if (sc->keyframes[i] < sc->stps_data[j])
+                    i++;
+                else
+                    j++;
+            }
+        }
+    }
+
+    for (unsigned int i = 0; i < sc->chunk_count; i++) {
+        int64_t next_offset = i + 1 < sc->chunk_count ? sc->chunk_offsets[i + 1] : INT64_MAX;
+        int64_t current_offset = sc->chunk_offsets[i];
+        const MOVStsc *stsc;
+
+        while (mov_stsc_index_valid(stsc_index, sc->stsc_count) &&
+               i + 1 == sc->stsc_data[stsc_index + 1].first)
+            stsc_index++;
+        stsc = &sc->stsc_data[stsc_index];
+
+        /* the sample size corrections must apply to the whole track */
+        if (next_offset > current_offset && sc->sample_size > 0 &&
+            sc->sample_size < stsz_sample_size &&
+            stsc->count * (int64_t)stsz_sample_size > next_offset - current_offset) {
+            if (i)
+                goto not_compact;
+            stsz_too_large   = stsz_sample_size;
+            stsz_sample_size = sc->sample_size;
+        }
+        if (stsz_sample_size > 0 && stsz_sample_size < sc->sample_size) {
+            if (i)
+                goto not_compact;
+            stsz_too_small   = stsz_sample_size;
+            stsz_sample_size = sc->sample_size;
+        }
+
+        if (!stsc->count)
+            continue;
+        if (stsc->count > sc->sample_count - current_sample ||
+            (sc->pseudo_stream_id != -1 && stsc->id - 1 != sc->pseudo_stream_id) ||
+            (!stsz_sample_size && !sc->sample_sizes))
+            goto not_compact;
+
+        for (unsigned int j = 0; j < stsc->count; j++) {
+            unsigned int sample_size = stsz_sample_size ? stsz_sample_size
+                                                        : sc->sample_sizes[current_sample + j];
+            if (current_offset > INT64_MAX - sample_size || sample_size > 0x3FFFFFFF)
+                goto not_compact;
+            current_offset += sample_size;
+            size_sum       += sample_size;
+        }
+
+        if (!nb_chunk_runs || chunk_runs[nb_chunk_runs - 1].count != stsc->count ||
+            chunk_runs[nb_chunk_runs - 1].chunk +
+            (current_sample - chunk_runs[nb_chunk_runs - 1].sample) / stsc->count != i) {
+            MOVChunkRun *cr = av_fast_realloc(chunk_runs, &chunk_runs_size,
+                                              (nb_chunk_runs + 1) * sizeof(*chunk_runs));
+            if (!cr) {
+                ret = AVERROR(ENOMEM);
+                goto not_compact;
+            }
+            chunk_runs = cr;
+            cr = &chunk_runs[nb_chunk_runs++];
+            cr->chunk  = i;
+            cr->sample = current_sample;
+            cr->count  = stsc->count;
+        }
+        current_sample += stsc->count;
+    }
+
+    /* without keyframe tables only the first sample of the first chunk is a
+     * keyframe, which must then be the first sample */
+    if (!current_sample || (!all_keyframes && !key_tables && chunk_runs[0].chunk))
+        goto not_compact;
+
+    ret = mov_merge_tts_data(mov, st, MOV_MERGE_CTTS | MOV_MERGE_STTS);
+    if (ret < 0)
+        goto not_compact;
+    if (!sc->tts_count) {
+        ret = 0;
+        goto not_compact;
+    }
+
+    for (unsigned int i = 0; i < sc->tts_count; i++) {
+        unsigned int duration = sc->tts_data[i].duration;
+
+        if (!nb_times || times[nb_times - 1].duration != duration) {
+            MOVSampleTime *t = av_fast_realloc(times, &times_size,
+                                               (nb_times + 1) * sizeof(*times));
+            if (!t) {
+                ret = AVERROR(ENOMEM);
+                goto not_compact;
+            }
+            times = t;
+            t = &times[nb_times++];
+            t->sample   = i;
+            t->duration = duration;
+            t->dts      = current_dts;
+        }
+        current_dts += duration;
+    }
+
+    ci = av_mallocz(sizeof(*ci));
+    if (!ci) {
+        ret = AVERROR(ENOMEM);
+        goto not_compact;
+    }
+    ci->runs = av_mallocz(sizeof(*ci->runs));
+    if (!ci->runs) {
+        av_free(ci);
+        ret = AVERROR(ENOMEM);
+        goto not_compact;
+    }
+    ci->nb_runs             = 1;
+    ci->runs_allocated_size = sizeof(*ci->runs);
+    ci->nb_entries          = current_sample;
+    ci->chunk_runs          = chunk_runs;
+    ci->nb_chunk_runs       = nb_chunk_runs;
+    ci->times               = times;
+    ci->nb_times            = nb_times;
+    ci->sample_size         = stsz_sample_size;
+    ci->all_keyframes       = all_keyframes;
+    ci->key_tables          = key_tables;
+    ci->use_stss            = use_stss;
+    ci->key_off             = key_off;
+    ci->entry_index         = -1;
+    sc->compact_index       = ci;
+
+    if (stsz_too_large)
+        av_log(mov->fc, AV_LOG_WARNING, "STSZ sample size %d invalid (too large), ignoring\n", stsz_too_large);
+    if (stsz_too_small)
+        av_log(mov->fc, AV_LOG_WARNING, "STSZ sample size %d invalid (too small), ignoring\n", stsz_too_small);
+    sc->stsz_sample_size = stsz_sample_size;
+
+    if (st->codecpar->codec_type == AVMEDIA_TYPE_VIDEO)
+        for (unsigned int i = 0; i < FFMIN(current_sample, 99); i++)
+            ff_rfps_add_frame(mov->fc, st, compact_sample_dts(ci, i));
+
+    *stream_size = size_sum;
+    return 1;
+
+not_compact:
+    av_free(chunk_runs);
+    av_free(times);
+    return ret;
+}
+
 static void mov_build_index(MOVContext *mov, AVStream *st)
 {
     MOVStreamContext *sc = st->priv_data;
@@ -4790,6 +5353,13 @@ static void mov_build_index(MOVContext *mov, AVStream *st)
             return;
         if (sc->sample_count >= UINT_MAX / sizeof(*sti->index_entries) - sti->nb_index_entries)
             return;
+
+        ret = mov_build_compact_index(mov, st, current_dts, &stream_size);
+        if (ret < 0)
+            return;
+        if (ret > 0)
+            goto index_built;
+
         if (av_reallocp_array(&sti->index_entries,
                               sti->nb_index_entries + sc->sample_count,
                               sizeof(*sti->index_entries)) < 0) {
@@ -4892,6 +5462,7 @@ static void mov_build_index(MOVContext *mov, AVStream *st)
                 }
             }
         }
+index_built:
         if (st->duration > 0)
             st->codecpar->bit_rate = stream_size*8*sc->time_scale/st->duration;
     } else {
@@ -5006,8 +5577,9 @@ static void mov_build_index(MOVContext *mov, AVStream *st)
     }
 
     // Update start time of the stream.
-    if (st->start_time == AV_NOPTS_VALUE && st->codecpar->codec_type == AVMEDIA_TYPE_VIDEO && sti->nb_index_entries > 0) {
-        st->start_time = sti->index_entries[0].timestamp + sc->dts_shift;
+    if (st->start_time == AV_NOPTS_VALUE && st->codecpar->codec_type == AVMEDIA_TYPE_VIDEO && mov_index_count(st) > 0) {
+        AVIndexEntry buf;
+        st->start_time = mov_index_entry(st, 0, &buf)->timestamp + sc->dts_shift;
         if (sc->tts_data) {
             st->start_time += sc->tts_data[0].offset;
         }
@@ -5332,11 +5904,13 @@ static int mov_read_trak(MOVContext *c, AVIOContext *pb, MOVAtom atom)
         if (!stts_constant)
             ffstream(st)->need_parsing = AVSTREAM_PARSE_FULL;
     }
-    /* Do not need those anymore. */
-    av_freep(&sc->chunk_offsets);
-    av_freep(&sc->sample_sizes);
-    av_freep(&sc->keyframes);
-    av_freep(&sc->stps_data);
+    /* Do not need those anymore, unless the index is computed from them. */
+    if (!sc->compact_index) {
+        av_freep(&sc->chunk_offsets);
+        av_freep(&sc->sample_sizes);
+        av_freep(&sc->keyframes);
+        av_freep(&sc->stps_data);
+    }
     av_freep(&sc->elst_data);
     av_freep(&sc->rap_group);
     av_freep(&sc->sync_group);
@@ -5818,6 +6392,7 @@ static int mov_read_trun(MOVContext *c, AVIOContext *pb, MOVAtom atom)
     int flags, distance, i;
     int64_t prev_dts = AV_NOPTS_VALUE;
     int next_frag_index = -1, index_entry_pos;
+    int ret;
     size_t requested_size;
     size_t old_allocated_size;
     AVIndexEntry *new_entries;
@@ -5844,6 +6419,11 @@ static int mov_read_trun(MOVContext *c, AVIOContext *pb, MOVAtom atom)
     if (sc->pseudo_stream_id+1 != frag->stsd_id && sc->pseudo_stream_id != -1)
         return 0;
 
+    // Fragment samples are inserted into the regular index entries.
+    ret = mov_expand_compact_index(st);
+    if (ret < 0)
+        return ret;
+
     // Find the next frag_index index that has a valid index_entry for
     // the current track_id.
     //
@@ -9876,6 +10456,8 @@ static void mov_read_chapters(AVFormatContext *s)
             av_log(s, AV_LOG_ERROR, "Referenced QT chapter track not found\n");
             continue;
         }
+        if (mov_expand_compact_index(st) < 0)
+            continue;
         sti = ffstream(st);
 
         sc = st->priv_data;
@@ -10061,6 +10643,7 @@ static void mov_free_stream_context(AVFormatContext *s, AVStream *st)
     }
 
     av_freep(&sc->tts_data);
+    mov_free_compact_index(sc);
     for (int i = 0; i < sc->drefs_count; i++) {
         av_freep(&sc->drefs[i].path);
         av_freep(&sc->drefs[i].dir);
@@ -11145,8 +11728,17 @@ static AVIndexEntry *mov_find_next_sample(AVFormatContext *s, AVStream **st)
         AVStream *avst = s->streams[i];
         FFStream *const avsti = ffstream(avst);
         MOVStreamContext *msc = avst->priv_data;
-        if (msc->pb && msc->current_sample < avsti->nb_index_entries) {
-            AVIndexEntry *current_sample = &avsti->index_entries[msc->current_sample];
+        if (msc->pb && msc->current_sample < mov_index_count(avst)) {
+            AVIndexEntry *current_sample;
+            if (msc->compact_index) {
+                MOVCompactIndex *ci = msc->compact_index;
+                if (ci->entry_index != msc->current_sample) {
+                    compact_index_entry(msc, msc->current_sample, &ci->entry);
+                    ci->entry_index = msc->current_sample;
+                }
+                current_sample = &ci->entry;
+            } else
+                current_sample = &avsti->index_entries[msc->current_sample];
             int64_t dts = av_rescale(current_sample->timestamp, AV_TIME_BASE, msc->time_scale);
             uint64_t dtsdiff = best_dts > dts ? best_dts - (uint64_t)dts : ((uint64_t)dts - best_dts);
             av_log(s, AV_LOG_TRACE, "stream %d, sample %d, dts %"PRId64"\n", i, msc->current_sample, dts);
@@ -11316,8 +11908,9 @@ static int mov_finalize_packet(AVFormatContext *s, AVStream *st, AVIndexEntry *s
         pkt->pts = av_sat_add64(pkt->dts, av_sat_add64(sc->dts_shift, sc->tts_data[sc->tts_index].offset));
     } else {
         if (pkt->duration == 0) {
-            int64_t next_dts = (sc->current_sample < ffstream(st)->nb_index_entries) ?
-                ffstream(st)->index_entries[sc->current_sample].timestamp : st->duration;
+            AVIndexEntry buf;
+            int64_t next_dts = (sc->current_sample < mov_index_count(st)) ?
+                mov_index_entry(st, sc->current_sample, &buf)->timestamp : st->duration;
             if (next_dts >= pkt->dts)
                 pkt->duration = next_dts - pkt->dts;
         }
@@ -11405,6 +11998,7 @@ static int mov_read_packet(AVFormatContext *s, AVPacket *pkt)
                 avsti->index_entries_allocated_size = 0;
                 avsti->nb_index_entries = 0;
             }
+            mov_free_compact_index(msc);
         }
 
         if ((ret = mov_switch_root(s, -1, -1)) < 0)
@@ -11482,6 +12076,10 @@ static int mov_read_packet(AVFormatContext *s, AVPacket *pkt)
         else if (st->codecpar->codec_id == AV_CODEC_ID_APV && sample->size > 4) {
             const uint32_t au_size = avio_rb32(sc->pb);
             ret = av_get_packet(sc->pb, pkt, au_size);
+        } else if (!mov->aax_mode && !mov->decryption_keys && !mov->decryption_default_key) {
+            /* the data must not be decrypted in place */
+            ret = ff_get_packet_mapped(sc->pb, pkt, sample->size,
+                                       st->codecpar->codec_id);
         } else
             ret = av_get_packet(sc->pb, pkt, sample->size);
         if (ret < 0) {
@@ -11575,7 +12173,7 @@ static int is_open_key_sample(const MOVStreamContext *sc, int sample)
 static int can_seek_to_key_sample(AVStream *st, int sample, int64_t requested_pts)
 {
     MOVStreamContext *sc = st->priv_data;
-    FFStream *const sti = ffstream(st);
+    AVIndexEntry buf;
     int64_t key_sample_dts, key_sample_pts;
 
     if (st->codecpar->codec_id != AV_CODEC_ID_HEVC)
@@ -11584,7 +12182,7 @@ static int can_seek_to_key_sample(AVStream *st, int sample, int64_t requested_pt
     if (sample >= sc->sample_offsets_count)
         return 1;
 
-    key_sample_dts = sti->index_entries[sample].timestamp;
+    key_sample_dts = mov_index_entry(st, sample, &buf)->timestamp;
     key_sample_pts = key_sample_dts + sc->sample_offsets[sample] + sc->dts_shift;
 
     /*
@@ -11601,7 +12199,7 @@ static int can_seek_to_key_sample(AVStream *st, int sample, int64_t requested_pt
 static int mov_seek_stream(AVFormatContext *s, AVStream *st, int64_t timestamp, int flags)
 {
     MOVStreamContext *sc = st->priv_data;
-    FFStream *const sti = ffstream(st);
+    AVIndexEntry buf;
     int sample, time_sample, ret, requested_sample;
     int64_t next_ts;
     unsigned int i;
@@ -11615,9 +12213,9 @@ static int mov_seek_stream(AVFormatContext *s, AVStream *st, int64_t timestamp,
         return ret;
 
     for (;;) {
-        sample = av_index_search_timestamp(st, timestamp, flags);
+        sample = mov_index_search_timestamp(st, timestamp, flags);
         av_log(s, AV_LOG_TRACE, "stream %d, timestamp %"PRId64", sample %d\n", st->index, timestamp, sample);
-        if (sample < 0 && sti->nb_index_entries && timestamp < sti->index_entries[0].timestamp)
+        if (sample < 0 && mov_index_count(st) && timestamp < mov_index_entry(st, 0, &buf)->timestamp)
             sample = 0;
         if (sample < 0) /* not sure what to do */
             return AVERROR_INVALIDDATA;
@@ -11626,7 +12224,7 @@ static int mov_seek_stream(AVFormatContext *s, AVStream *st, int64_t timestamp,
             break;
 
         next_ts = timestamp - FFMAX(sc->min_sample_duration, 1);
-        requested_sample = av_index_search_timestamp(st, next_ts, flags);
+        requested_sample = mov_index_search_timestamp(st, next_ts, flags);
 
         // If we've reached a different sample trying to find a good pts to
         // seek to, give up searching because we'll end up seeking back to
@@ -11674,9 +12272,9 @@ static int mov_seek_stream(AVFormatContext *s, AVStream *st, int64_t timestamp,
 static int64_t mov_get_skip_samples(AVStream *st, int sample)
 {
     MOVStreamContext *sc = st->priv_data;
-    FFStream *const sti = ffstream(st);
-    int64_t first_ts = sti->index_entries[0].timestamp;
-    int64_t ts = sti->index_entries[sample].timestamp;
+    AVIndexEntry buf;
+    int64_t first_ts = mov_index_entry(st, 0, &buf)->timestamp;
+    int64_t ts = mov_index_entry(st, sample, &buf)->timestamp;
     int64_t off;
 
     if (st->codecpar->codec_type != AVMEDIA_TYPE_AUDIO)
@@ -11707,7 +12305,8 @@ static int mov_read_seek(AVFormatContext *s, int stream_index, int64_t sample_ti
 
     if (mc->seek_individually) {
         /* adjust seek timestamp to found sample timestamp */
-        int64_t seek_timestamp = sti->index_entries[sample].timestamp;
+        AVIndexEntry buf;
+        int64_t seek_timestamp = mov_index_entry(st, sample, &buf)->timestamp;
         sti->skip_samples = mov_get_skip_samples(st, sample);
 
         for (i = 0; i < s->nb_streams; i++) {
@@ -11744,6 +12343,16 @@ static int mov_read_seek(AVFormatContext *s, int stream_index, int64_t sample_ti
     return 0;
 }
 
+static int mov_expand_index(AVFormatContext *s, AVStream *st)
+{
+    return mov_expand_compact_index(st);
+}
+
+static int mov_index_entries_count(const AVFormatContext *s, const AVStream *st)
+{
+    return st->priv_data ? mov_index_count(st) : cffstream(st)->nb_index_entries;
+}
+
 #define OFFSET(x) offsetof(MOVContext, x)
 #define FLAGS AV_OPT_FLAG_VIDEO_PARAM | AV_OPT_FLAG_DECODING_PARAM
 static const AVOption mov_options[] = {
@@ -11761,6 +12370,10 @@ static const AVOption mov_options[] = {
         "Modify the AVIndex according to the editlists. Use this option to decode in the order specified by the edits.",
         OFFSET(advanced_editlist), AV_OPT_TYPE_BOOL, {.i64 = 1},
         0, 1, FLAGS},
+    {"compact_index",
+        "Compute the sample index entries on demand instead of storing them",
+        OFFSET(compact_index), AV_OPT_TYPE_BOOL, {.i64 = 0},
+        0, 1, FLAGS},
     {"ignore_chapters", "", OFFSET(ignore_chapters), AV_OPT_TYPE_BOOL, {.i64 = 0},
         0, 1, FLAGS},
     {"use_mfra_for",
@@ -11820,4 +12433,6 @@ const FFInputFormat ff_mov_demuxer = {
     .read_packet    = mov_read_packet,
     .read_close     = mov_read_close,
     .read_seek      = mov_read_seek,
+    .expand_index   = mov_expand_index,
+    .index_count    = mov_index_entries_count,
 };
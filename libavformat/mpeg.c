@@ -468,8 +468,8 @@ redo:
             if (startcode == s->streams[i]->id &&
                 (s->pb->seekable & AVIO_SEEKABLE_NORMAL) /* index useless on streams anyway */) {
                 ff_reduce_index(s, i);
-                av_add_index_entry(s->streams[i], *ppos, dts, 0, 0,
-                                   AVINDEX_KEYFRAME /* FIXME keyframe? */);
+                ff_add_index_entry_deferred(s->streams[i], *ppos, dts, 0, 0,
+                                            AVINDEX_KEYFRAME /* FIXME keyframe? */);
             }
         }
     }
@@ -3640,7 +3640,7 @@ static int64_t mpegts_get_dts(AVFormatContext *s, int stream_index,
         }
         if (pkt->dts != AV_NOPTS_VALUE && pkt->pos >= 0) {
             ff_reduce_index(s, pkt->stream_index);
-            av_add_index_entry(s->streams[pkt->stream_index], pkt->pos, pkt->dts, 0, 0, AVINDEX_KEYFRAME /* FIXME keyframe? */);
+            ff_add_index_entry_deferred(s->streams[pkt->stream_index], pkt->pos, pkt->dts, 0, 0, AVINDEX_KEYFRAME /* FIXME keyframe? */);
             if (pkt->stream_index == stream_index && pkt->pos >= *ppos) {
                 int64_t dts = pkt->dts;
                 *ppos = pkt->pos;
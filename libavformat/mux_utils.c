@@ -26,6 +26,7 @@
 #include "libavutil/parseutils.h"
 #include "avformat.h"
 #include "avio.h"
+#include "avio_internal.h"
 #include "internal.h"
 #include "mux.h"
 
@@ -84,12 +85,6 @@ int ff_format_shift_data(AVFormatContext *s, int64_t read_start, int shift_size)
     int read_size[2];
     AVIOContext *read_pb;
 
-    buf = av_malloc_array(shift_size, 2);
-    if (!buf)
-        return AVERROR(ENOMEM);
-    read_buf[0] = buf;
-    read_buf[1] = buf + shift_size;
-
     /* Shift the data: the AVIO context of the output can only be used for
      * writing, so we re-open the same output, but for reading. It also avoids
      * a read/seek/write/seek back and forth. */
@@ -97,12 +92,31 @@ int ff_format_shift_data(AVFormatContext *s, int64_t read_start, int shift_size)
     ret = s->io_open(s, &read_pb, s->url, AVIO_FLAG_READ, NULL);
     if (ret < 0) {
         av_log(s, AV_LOG_ERROR, "Unable to re-open %s output file for shifting data\n", s->url);
-        goto end;
+        return ret;
     }
 
-    /* mark the end of the shift to up to the last data we wrote, and get ready
-     * for writing */
+    /* mark the end of the shift to up to the last data we wrote */
     pos_end = avio_tell(s->pb);
+
+    /* Let the protocol move the data by itself if it can, e.g. in the
+     * kernel for local files. */
+    ret = ffio_shift_data(s->pb, read_pb, read_start, pos_end, shift_size);
+    if (ret != AVERROR(ENOSYS)) {
+        if (ret >= 0)
+            avio_seek(s->pb, pos_end + shift_size, SEEK_SET);
+        ff_format_io_close(s, &read_pb);
+        return ret;
+    }
+
+    buf = av_malloc_array(shift_size, 2);
+    if (!buf) {
+        ff_format_io_close(s, &read_pb);
+        return AVERROR(ENOMEM);
+    }
+    read_buf[0] = buf;
+    read_buf[1] = buf + shift_size;
+
+    /* get ready for writing */
     avio_seek(s->pb, read_start + shift_size, SEEK_SET);
 
     avio_seek(read_pb, read_start, SEEK_SET);
@@ -126,7 +140,6 @@ int ff_format_shift_data(AVFormatContext *s, int64_t read_start, int shift_size)
     } while (pos < pos_end);
     ret = ff_format_io_close(s, &read_pb);
 
-end:
     av_free(buf);
     return ret;
 }
@@ -62,7 +62,7 @@ int ff_pcm_read_packet(AVFormatContext *s, AVPacket *pkt)
     if (size < 0)
         return size;
 
-    ret = av_get_packet(s->pb, pkt, size);
+    ret = ff_get_packet_mapped(s->pb, pkt, size, s->streams[0]->codecpar->codec_id);
 
     pkt->flags &= ~AV_PKT_FLAG_CORRUPT;
     pkt->stream_index = 0;
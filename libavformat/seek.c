@@ -53,8 +53,9 @@ void ff_reduce_index(AVFormatContext *s, int stream_index)
     FFStream *const sti = ffstream(st);
     unsigned int max_entries = s->max_index_size / sizeof(AVIndexEntry);
 
-    if ((unsigned) sti->nb_index_entries >= max_entries) {
+    if ((unsigned) sti->nb_index_entries + sti->nb_index_pending >= max_entries) {
         int i;
+        ff_flush_index_entries(st);
         for (i = 0; 2 * i < sti->nb_index_entries; i++)
             sti->index_entries[i] = sti->index_entries[2 * i];
         sti->nb_index_entries = i;
@@ -119,42 +120,202 @@ int ff_add_index_entry(AVIndexEntry **index_entries,
     return index;
 }
 
+/**
+ * Merge the sorted runs [0, n1) and [n1, n1 + n2) of entries in place,
+ * tmp must have room for n1 entries.
+ */
+static void merge_index_runs(AVIndexEntry *entries, int n1, int n2,
+                             AVIndexEntry *tmp)
+{
+    const AVIndexEntry *a = tmp, *const a_end = tmp + n1;
+    const AVIndexEntry *b = entries + n1, *const b_end = b + n2;
+    AVIndexEntry *dst = entries;
+
+    memcpy(tmp, entries, n1 * sizeof(*entries));
+    while (a < a_end && b < b_end)
+        *dst++ = b->timestamp < a->timestamp ? *b++ : *a++;
+    // what is left of the second run is already in place
+    memcpy(dst, a, (a_end - a) * sizeof(*a));
+}
+
+static AVIndexEntry *find_index_entry(AVIndexEntry *entries, int nb_entries,
+                                      int64_t timestamp)
+{
+    int index = ff_index_search_timestamp(entries, nb_entries, timestamp,
+                                          AVSEEK_FLAG_ANY);
+    if (index < 0 || entries[index].timestamp != timestamp)
+        return NULL;
+    return &entries[index];
+}
+
+int ff_add_index_entry_deferred(AVStream *st, int64_t pos, int64_t timestamp,
+                                int size, int distance, int flags)
+{
+    FFStream *const sti = ffstream(st);
+    AVIndexEntry *entries = NULL, *ie;
+    int nb = sti->nb_index_pending;
+
+    if (flags & AVINDEX_DISCARD_FRAME)
+        return av_add_index_entry(st, pos, timestamp, size, distance, flags);
+
+    timestamp = ff_wrap_timestamp(st, timestamp);
+    if (timestamp == AV_NOPTS_VALUE || size < 0 || size > 0x3FFFFFFF)
+        return AVERROR(EINVAL);
+    if (is_relative(timestamp))
+        timestamp -= RELATIVE_TS_BASE;
+
+    // Appending and updating existing entries are cheap, do it right away.
+    if (!sti->nb_index_entries ||
+        timestamp > sti->index_entries[sti->nb_index_entries - 1].timestamp)
+        return ff_add_index_entry(&sti->index_entries, &sti->nb_index_entries,
+                                  &sti->index_entries_allocated_size, pos,
+                                  timestamp, size, distance, flags);
+
+    ie = find_index_entry(sti->index_entries, sti->nb_index_entries, timestamp);
+    for (int run = 1 << 30, start = 0; !ie && run; run >>= 1) {
+        if (!(nb & run))
+            continue;
+        ie     = find_index_entry(sti->index_pending + start, run, timestamp);
+        start += run;
+    }
+
+    if (ie) {
+        if (ie->pos == pos && distance < ie->min_distance)
+            // do not reduce the distance
+            distance = ie->min_distance;
+    } else {
+        if ((unsigned)nb + sti->nb_index_entries >= INT_MAX / 2 ||
+            (unsigned)nb >= UINT_MAX / (2 * sizeof(*entries)) - 1)
+            return AVERROR(ENOMEM);
+        entries = av_fast_realloc(sti->index_pending,
+                                  &sti->index_pending_allocated_size,
+                                  (2 * nb + 2) * sizeof(*entries));
+        if (!entries)
+            return AVERROR(ENOMEM);
+        sti->index_pending = entries;
+        ie = &entries[nb];
+    }
+
+    ie->pos          = pos;
+    ie->timestamp    = timestamp;
+    ie->min_distance = distance;
+    ie->size         = size;
+    ie->flags        = flags;
+
+    if (entries) {
+        // Merge the runs of equal size like the carries of a binary
+        // addition, the space past the new entry is the scratch buffer.
+        for (int run = 1; nb & run; run <<= 1)
+            merge_index_runs(entries + nb + 1 - 2 * run, run, run,
+                             entries + nb + 1);
+        sti->nb_index_pending = nb + 1;
+    }
+
+    return 0;
+}
+
+int ff_flush_index_entries(AVStream *st)
+{
+    FFStream *const sti = ffstream(st);
+    AVIndexEntry *const pending = sti->index_pending;
+    AVIndexEntry *entries;
+    int nb = sti->nb_index_pending, n = sti->nb_index_entries;
+    unsigned merged;
+
+    if (!nb)
+        return 0;
+
+    // Merge the pending runs into one, starting from the smallest.
+    merged = nb & -nb;
+    for (unsigned run = merged << 1; run <= nb; run <<= 1) {
+        if (!(nb & run))
+            continue;
+        merge_index_runs(pending + nb - merged - run, run, merged,
+                         pending + nb);
+        merged += run;
+    }
+
+    if ((unsigned)n + nb >= UINT_MAX / sizeof(*entries))
+        return AVERROR(ENOMEM);
+    entries = av_fast_realloc(sti->index_entries,
+                              &sti->index_entries_allocated_size,
+                              (n + nb) * sizeof(*entries));
+    if (!entries)
+        return AVERROR(ENOMEM);
+    sti->index_entries = entries;
+
+    // Merge from the end so that no entry is overwritten before it is moved.
+    for (int i = n - 1, j = nb - 1, k = n + nb - 1; j >= 0; k--)
+        entries[k] = i >= 0 && entries[i].timestamp > pending[j].timestamp ?
+                     entries[i--] : pending[j--];
+
+    sti->nb_index_entries += nb;
+    sti->nb_index_pending  = 0;
+
+    return 0;
+}
+
+static int expand_index(AVStream *st)
+{
+    AVFormatContext *const s = ffstream(st)->fmtctx;
+
+    if (s && s->iformat && ffifmt(s->iformat)->expand_index) {
+        int ret = ffifmt(s->iformat)->expand_index(s, st);
+        if (ret < 0)
+            return ret;
+    }
+    return ff_flush_index_entries(st);
+}
+
+static void flush_index_entries(AVFormatContext *s)
+{
+    for (unsigned i = 0; i < s->nb_streams; i++)
+        ff_flush_index_entries(s->streams[i]);
+}
+
 int av_add_index_entry(AVStream *st, int64_t pos, int64_t timestamp,
                        int size, int distance, int flags)
 {
     FFStream *const sti = ffstream(st);
+    int ret = expand_index(st);
+    if (ret < 0)
+        return ret;
     timestamp = ff_wrap_timestamp(st, timestamp);
     return ff_add_index_entry(&sti->index_entries, &sti->nb_index_entries,
                               &sti->index_entries_allocated_size, pos,
                               timestamp, size, distance, flags);
 }
 
-int ff_index_search_timestamp(const AVIndexEntry *entries, int nb_entries,
-                              int64_t wanted_timestamp, int flags)
+static av_always_inline int index_search_timestamp(void *opaque, int nb_entries,
+                                                   int64_t (*get_entry)(void *opaque, int index,
+                                                                        int *entry_flags),
+                                                   int64_t wanted_timestamp, int flags)
 {
-    int a, b, m;
+    int a, b, m, entry_flags;
     int64_t timestamp;
 
     a = -1;
     b = nb_entries;
 
     // Optimize appending index entries at the end.
-    if (b && entries[b - 1].timestamp < wanted_timestamp)
+    if (b && get_entry(opaque, b - 1, &entry_flags) < wanted_timestamp)
         a = b - 1;
 
     while (b - a > 1) {
         m         = (a + b) >> 1;
+        timestamp = get_entry(opaque, m, &entry_flags);
 
         // Search for the next non-discarded packet.
-        while ((entries[m].flags & AVINDEX_DISCARD_FRAME) && m < b && m < nb_entries - 1) {
+        while ((entry_flags & AVINDEX_DISCARD_FRAME) && m < b && m < nb_entries - 1) {
             m++;
-            if (m == b && entries[m].timestamp >= wanted_timestamp) {
+            timestamp = get_entry(opaque, m, &entry_flags);
+            if (m == b && timestamp >= wanted_timestamp) {
                 m = b - 1;
+                timestamp = get_entry(opaque, m, &entry_flags);
                 break;
             }
         }
 
-        timestamp = entries[m].timestamp;
         if (timestamp >= wanted_timestamp)
             b = m;
         if (timestamp <= wanted_timestamp)
@@ -164,7 +325,8 @@ int ff_index_search_timestamp(const AVIndexEntry *entries, int nb_entries,
 
     if (!(flags & AVSEEK_FLAG_ANY))
         while (m >= 0 && m < nb_entries &&
-               !(entries[m].flags & AVINDEX_KEYFRAME))
+               (get_entry(opaque, m, &entry_flags),
+                !(entry_flags & AVINDEX_KEYFRAME)))
             m += (flags & AVSEEK_FLAG_BACKWARD) ? -1 : 1;
 
     if (m == nb_entries)
@@ -172,6 +334,31 @@ int ff_index_search_timestamp(const AVIndexEntry *entries, int nb_entries,
     return m;
 }
 
+static av_always_inline int64_t get_index_entry(void *opaque, int index,
+                                                int *entry_flags)
+{
+    const AVIndexEntry *entries = opaque;
+
+    *entry_flags = entries[index].flags;
+    return entries[index].timestamp;
+}
+
+int ff_index_search_timestamp(const AVIndexEntry *entries, int nb_entries,
+                              int64_t wanted_timestamp, int flags)
+{
+    return index_search_timestamp((void *)entries, nb_entries, get_index_entry,
+                                  wanted_timestamp, flags);
+}
+
+int ff_index_search_timestamp_cb(void *opaque, int nb_entries,
+                                 int64_t (*get_entry)(void *opaque, int index,
+                                                      int *entry_flags),
+                                 int64_t wanted_timestamp, int flags)
+{
+    return index_search_timestamp(opaque, nb_entries, get_entry,
+                                  wanted_timestamp, flags);
+}
+
 void ff_configure_buffers_for_index(AVFormatContext *s, int64_t time_tolerance)
 {
     int64_t pos_delta = 0;
@@ -192,6 +379,8 @@ void ff_configure_buffers_for_index(AVFormatContext *s, int64_t time_tolerance)
     if (proto && !(strcmp(proto, "file") && strcmp(proto, "pipe") && strcmp(proto, "cache")))
         return;
 
+    flush_index_entries(s);
+
     for (unsigned ist1 = 0; ist1 < s->nb_streams; ist1++) {
         AVStream *const st1  = s->streams[ist1];
         FFStream *const sti1 = ffstream(st1);
@@ -245,18 +434,29 @@ void ff_configure_buffers_for_index(AVFormatContext *s, int64_t time_tolerance)
 int av_index_search_timestamp(AVStream *st, int64_t wanted_timestamp, int flags)
 {
     const FFStream *const sti = ffstream(st);
+    int ret = expand_index(st);
+    if (ret < 0)
+        return ret;
     return ff_index_search_timestamp(sti->index_entries, sti->nb_index_entries,
                                      wanted_timestamp, flags);
 }
 
 int avformat_index_get_entries_count(const AVStream *st)
 {
-    return cffstream(st)->nb_index_entries;
+    const FFStream *const sti = cffstream(st);
+    const AVFormatContext *const s = sti->fmtctx;
+
+    // Entries are only expanded by the non-const accessors.
+    if (s && s->iformat && ffifmt(s->iformat)->index_count)
+        return ffifmt(s->iformat)->index_count(s, st) + sti->nb_index_pending;
+    return sti->nb_index_entries + sti->nb_index_pending;
 }
 
 const AVIndexEntry *avformat_index_get_entry(AVStream *st, int idx)
 {
     const FFStream *const sti = ffstream(st);
+    if (expand_index(st) < 0)
+        return NULL;
     if (idx < 0 || idx >= sti->nb_index_entries)
         return NULL;
 
@@ -268,9 +468,13 @@ const AVIndexEntry *avformat_index_get_entry_from_timestamp(AVStream *st,
                                                             int flags)
 {
     const FFStream *const sti = ffstream(st);
-    int idx = ff_index_search_timestamp(sti->index_entries,
-                                        sti->nb_index_entries,
-                                        wanted_timestamp, flags);
+    int idx;
+
+    if (expand_index(st) < 0)
+        return NULL;
+    idx = ff_index_search_timestamp(sti->index_entries,
+                                    sti->nb_index_entries,
+                                    wanted_timestamp, flags);
 
     if (idx < 0)
         return NULL;
@@ -618,6 +822,8 @@ static int seek_frame_internal(AVFormatContext *s, int stream_index,
                                AV_TIME_BASE * (int64_t) st->time_base.num);
     }
 
+    flush_index_entries(s);
+
     /* first, we try the format specific seek */
     if (ffifmt(s->iformat)->read_seek) {
         ff_read_frame_flush(s);
@@ -679,6 +885,7 @@ int avformat_seek_file(AVFormatContext *s, int stream_index, int64_t min_ts,
     if (ffifmt(s->iformat)->read_seek2) {
         int ret;
         ff_read_frame_flush(s);
+        flush_index_entries(s);
 
         if (stream_index == -1 && s->nb_streams == 1) {
             AVRational time_base = s->streams[0]->time_base;
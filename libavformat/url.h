@@ -26,6 +26,7 @@
 
 #include "avio.h"
 
+#include "libavutil/buffer.h"
 #include "libavutil/dict.h"
 #include "libavutil/log.h"
 
@@ -86,6 +87,18 @@ typedef struct URLProtocol {
     int (*url_get_multi_file_handle)(URLContext *h, int **handles,
                                      int *numhandles);
     int (*url_get_short_seek)(URLContext *h);
+    /**
+     * Return a new reference to a read-only buffer holding size bytes of
+     * the resource starting at pos, followed by AV_INPUT_BUFFER_PADDING_SIZE
+     * zeroed bytes, without copying the data.
+     */
+    int (*url_map)(URLContext *h, int64_t pos, int size, AVBufferRef **buf);
+    /**
+     * Move the bytes in [pos, end) of the resource shift bytes forward
+     * without passing them through the caller, reading them from src.
+     */
+    int (*url_shift_data)(URLContext *h, URLContext *src,
+                          int64_t pos, int64_t end, int64_t shift);
     int (*url_shutdown)(URLContext *h, int flags);
     const AVClass *priv_data_class;
     int priv_data_size;
@@ -266,6 +279,27 @@ int ffurl_get_multi_file_handle(URLContext *h, int **handles, int *numhandles);
  */
 int ffurl_get_short_seek(void *urlcontext);
 
+/**
+ * Map size bytes of the resource starting at pos into memory, if the
+ * protocol supports it. The data is followed by zeroed padding.
+ *
+ * @return 0 on success, AVERROR(ENOSYS) if the range cannot be mapped or
+ *         another negative error code
+ */
+int ffurl_map(URLContext *h, int64_t pos, int size, AVBufferRef **buf);
+
+/**
+ * Move the bytes in [pos, end) of the resource shift bytes forward, if
+ * the protocol can do it by itself.
+ *
+ * @param src the same resource, opened for reading with the same protocol
+ * @return 0 on success, AVERROR(ENOSYS) if the protocol cannot do it, in
+ *         which case the resource is unchanged, or another negative error
+ *         code
+ */
+int ffurl_shift_data(URLContext *h, URLContext *src,
+                     int64_t pos, int64_t end, int64_t shift);
+
 /**
  * Signal the URLContext that we are done reading or writing the stream.
  *
@@ -111,6 +111,30 @@ FF_ENABLE_DEPRECATION_WARNINGS
     return append_packet_chunked(s, pkt, size);
 }
 
+int ff_get_packet_mapped(AVIOContext *s, AVPacket *pkt, int size,
+                         enum AVCodecID codec_id)
+{
+    int raw = codec_id == AV_CODEC_ID_RAWVIDEO ||
+              (codec_id >= AV_CODEC_ID_FIRST_AUDIO &&
+               codec_id <  AV_CODEC_ID_ADPCM_IMA_QT);
+    int ret;
+
+    av_packet_unref(pkt);
+    pkt->pos = avio_tell(s);
+
+    if (raw && size > 0) {
+        ret = ffio_read_mapped(s, size, &pkt->buf, &pkt->data);
+        if (ret >= 0) {
+            pkt->size = size;
+            return size;
+        }
+        if (ret != AVERROR(ENOSYS))
+            return ret;
+    }
+
+    return append_packet_chunked(s, pkt, size);
+}
+
 int av_append_packet(AVIOContext *s, AVPacket *pkt, int size)
 {
     if (!pkt->size)
@@ -790,7 +790,7 @@ smv_out:
         size = (size / st->codecpar->block_align) * st->codecpar->block_align;
     }
     size = FFMIN(size, left);
-    ret  = av_get_packet(s->pb, pkt, size);
+    ret  = ff_get_packet_mapped(s->pb, pkt, size, st->codecpar->codec_id);
     if (ret < 0)
         return ret;
     pkt->stream_index = 0;
@@ -20,10 +20,13 @@
 
 #include <math.h>
 #include <stdbool.h>
+#include <string.h>
 
 #include <libavutil/attributes.h>
 #include <libavutil/avassert.h>
 #include <libavutil/mem.h>
+#include <libavutil/refstruct.h>
+#include <libavutil/thread.h>
 
 #include "filters.h"
 
@@ -180,7 +183,7 @@ static double filter_radius(const SwsFilterFunction *fun)
     return radius;
 }
 
-int ff_sws_filter_generate(void *log, const SwsFilterParams *params,
+static int generate_filter(void *log, const SwsFilterParams *params,
                            SwsFilterWeights **out)
 {
     SwsScaler scaler = params->scaler;
@@ -274,6 +277,122 @@ int ff_sws_filter_generate(void *log, const SwsFilterParams *params,
     return 0;
 }
 
+/**
+ * Process-wide cache of recently generated filter kernels, so that contexts
+ * configured with the same scaling parameters share a single copy of the
+ * weights instead of recomputing them on every (re)initialization. Kernels
+ * are only cached while at least one SwsContext references the cache.
+ */
+#define FILTER_CACHE_SIZE 16
+
+static AVMutex filter_cache_lock = AV_MUTEX_INITIALIZER;
+static struct {
+    SwsFilterParams params;
+    SwsFilterWeights *filter; /* refstruct */
+} filter_cache[FILTER_CACHE_SIZE]; /* most recently used first */
+static int filter_cache_nb;
+static int filter_cache_users;
+static unsigned filter_cache_hits, filter_cache_misses;
+
+static bool params_equal(const SwsFilterParams *a, const SwsFilterParams *b)
+{
+    if (a->scaler != b->scaler || a->src_size != b->src_size ||
+        a->dst_size != b->dst_size)
+        return false;
+    for (int i = 0; i < SWS_NUM_SCALER_PARAMS; i++) {
+        if (a->scaler_params[i] != b->scaler_params[i])
+            return false;
+    }
+    return true;
+}
+
+int ff_sws_filter_generate(void *log, const SwsFilterParams *params,
+                           SwsFilterWeights **out)
+{
+    SwsFilterWeights *filter = NULL;
+    bool cached;
+    int ret;
+
+    ff_mutex_lock(&filter_cache_lock);
+    cached = filter_cache_users > 0;
+    for (int i = 0; cached && i < filter_cache_nb; i++) {
+        if (!params_equal(&filter_cache[i].params, params))
+            continue;
+        filter = av_refstruct_ref(filter_cache[i].filter);
+        if (i) {
+            const SwsFilterParams p = filter_cache[i].params;
+            memmove(&filter_cache[1], &filter_cache[0], i * sizeof(*filter_cache));
+            filter_cache[0].params = p;
+            filter_cache[0].filter = filter;
+        }
+        break;
+    }
+    if (filter)
+        filter_cache_hits++;
+    else if (cached)
+        filter_cache_misses++;
+    const unsigned hits = filter_cache_hits, misses = filter_cache_misses;
+    ff_mutex_unlock(&filter_cache_lock);
+
+    if (filter) {
+        av_log(log, AV_LOG_DEBUG, "Reusing cached %s filter with %d taps "
+               "(hits: %u, misses: %u)\n", filter->name, filter->filter_size,
+               hits, misses);
+        *out = filter;
+        return 0;
+    } else if (cached) {
+        av_log(log, AV_LOG_DEBUG, "Filter cache miss (hits: %u, misses: %u)\n",
+               hits, misses);
+    }
+
+    ret = generate_filter(log, params, &filter);
+    if (ret < 0)
+        return ret;
+
+    if (cached) {
+        ff_mutex_lock(&filter_cache_lock);
+        if (filter_cache_users > 0) {
+            if (filter_cache_nb == FILTER_CACHE_SIZE)
+                av_refstruct_unref(&filter_cache[--filter_cache_nb].filter);
+            memmove(&filter_cache[1], &filter_cache[0],
+                    filter_cache_nb * sizeof(*filter_cache));
+            filter_cache[0].params = *params;
+            filter_cache[0].filter = av_refstruct_ref(filter);
+            filter_cache_nb++;
+        }
+        ff_mutex_unlock(&filter_cache_lock);
+    }
+
+    *out = filter;
+    return 0;
+}
+
+void ff_sws_filter_cache_ref(void)
+{
+    ff_mutex_lock(&filter_cache_lock);
+    filter_cache_users++;
+    ff_mutex_unlock(&filter_cache_lock);
+}
+
+void ff_sws_filter_cache_unref(void)
+{
+    ff_mutex_lock(&filter_cache_lock);
+    av_assert1(filter_cache_users > 0);
+    if (!--filter_cache_users) {
+        while (filter_cache_nb)
+            av_refstruct_unref(&filter_cache[--filter_cache_nb].filter);
+    }
+    ff_mutex_unlock(&filter_cache_lock);
+}
+
+void ff_sws_filter_cache_stats(unsigned *hits, unsigned *misses)
+{
+    ff_mutex_lock(&filter_cache_lock);
+    *hits   = filter_cache_hits;
+    *misses = filter_cache_misses;
+    ff_mutex_unlock(&filter_cache_lock);
+}
+
 /*
  * Some of the filter code originally derives (via libplacebo/mpv) from Glumpy:
  * # Copyright (c) 2009-2016 Nicolas P. Rougier. All rights reserved.
@@ -102,6 +102,10 @@ typedef struct SwsFilterWeights {
  * Generate a filter kernel for the given parameters. The generated filter is
  * allocated as a refstruct and must be unref'd by the caller.
  *
+ * While the process-wide filter cache is referenced, a kernel generated
+ * earlier for the same parameters is returned from it instead, and newly
+ * generated kernels are added to it.
+ *
  * Returns 0 or a negative error code. In particular, this may return:
  * - AVERROR(ENOMEM) if memory allocation fails.
  * - AVERROR(EINVAL) if the provided parameters are invalid (e.g. out of range).
@@ -110,4 +114,17 @@ typedef struct SwsFilterWeights {
 int ff_sws_filter_generate(void *log_ctx, const SwsFilterParams *params,
                            SwsFilterWeights **out);
 
+/**
+ * Add or drop a reference to the process-wide filter cache. Each SwsContext
+ * holds one for its lifetime; dropping the last one frees all cached kernels.
+ * Kernels handed out earlier remain valid.
+ */
+void ff_sws_filter_cache_ref(void);
+void ff_sws_filter_cache_unref(void);
+
+/**
+ * Get the total number of filter cache hits and misses so far.
+ */
+void ff_sws_filter_cache_stats(unsigned *hits, unsigned *misses);
+
 #endif /* SWSCALE_FILTERS_H */
@@ -833,6 +833,12 @@ static void sws_graph_worker(void *priv, int jobnr, int threadnr, int nb_jobs,
     pass->run(graph->exec.output, graph->exec.input, slice_y, slice_h, pass);
 }
 
+static int sws_graph_execute_job(void *priv, int jobnr)
+{
+    sws_graph_worker(priv, jobnr, 0, 0, 0);
+    return 0;
+}
+
 int ff_sws_graph_create(SwsContext *ctx, const SwsFormat *dst, const SwsFormat *src,
                         int field, SwsGraph **out_graph)
 {
@@ -849,6 +855,9 @@ int ff_sws_graph_create(SwsContext *ctx, const SwsFormat *dst, const SwsFormat *
 
     if (ctx->threads == 1) {
         graph->num_threads = 1;
+    } else if (ctx->execute) {
+        /* slices are run by the caller */
+        graph->num_threads = ctx->threads > 0 ? ctx->threads : av_cpu_count();
     } else {
         ret = avpriv_slicethread_create(&graph->slicethread, (void *) graph,
                                         sws_graph_worker, NULL, ctx->threads);
@@ -919,6 +928,7 @@ static int opts_equal(const SwsContext *c1, const SwsContext *c2)
            c1->intent        == c2->intent        &&
            c1->scaler        == c2->scaler        &&
            c1->scaler_sub    == c2->scaler_sub    &&
+           c1->execute       == c2->execute       &&
            !memcmp(c1->scaler_params, c2->scaler_params, sizeof(c1->scaler_params));
 
 }
@@ -996,6 +1006,11 @@ int ff_sws_graph_run(SwsGraph *graph, const AVFrame *dst, const AVFrame *src)
 
         if (pass->num_slices == 1) {
             pass->run(graph->exec.output, graph->exec.input, 0, pass->height, pass);
+        } else if (graph->ctx->execute) {
+            int ret = graph->ctx->execute(graph->ctx, sws_graph_execute_job,
+                                          graph, pass->num_slices);
+            if (ret < 0)
+                return ret;
         } else {
             avpriv_slicethread_execute(graph->slicethread, pass->num_slices, 0);
         }
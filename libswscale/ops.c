@@ -32,6 +32,7 @@
 
 extern const SwsOpBackend backend_c;
 extern const SwsOpBackend backend_murder;
+extern const SwsOpBackend backend_fused;
 extern const SwsOpBackend backend_aarch64;
 extern const SwsOpBackend backend_x86;
 #if HAVE_SPIRV_HEADERS_SPIRV_H || HAVE_SPIRV_UNIFIED1_SPIRV_H
@@ -48,6 +49,7 @@ const SwsOpBackend * const ff_sws_op_backends[] = {
 #elif ARCH_X86_64 && HAVE_X86ASM
     &backend_x86,
 #endif
+    &backend_fused,
     &backend_c,
 #if HAVE_SPIRV_HEADERS_SPIRV_H || HAVE_SPIRV_UNIFIED1_SPIRV_H
     &backend_spirv,
@@ -639,6 +641,120 @@ SwsOpList *ff_sws_op_list_duplicate(const SwsOpList *ops)
     return copy;
 }
 
+static bool filter_equal(const SwsFilterWeights *a, const SwsFilterWeights *b)
+{
+    if (a == b)
+        return true;
+    if (!a || !b)
+        return false;
+
+    return a->filter_size  == b->filter_size  &&
+           a->num_weights  == b->num_weights  &&
+           a->src_size     == b->src_size     &&
+           a->dst_size     == b->dst_size     &&
+           a->sum_positive == b->sum_positive &&
+           a->sum_negative == b->sum_negative &&
+           !memcmp(a->name, b->name, sizeof(a->name)) &&
+           !memcmp(a->offsets, b->offsets, a->dst_size * sizeof(*a->offsets)) &&
+           !memcmp(a->weights, b->weights, a->num_weights * sizeof(*a->weights));
+}
+
+static bool q4_equal(const AVRational a[4], const AVRational b[4])
+{
+    for (int i = 0; i < 4; i++) {
+        if (a[i].num != b[i].num || a[i].den != b[i].den)
+            return false;
+    }
+    return true;
+}
+
+static bool op_equal(const SwsOp *a, const SwsOp *b)
+{
+    if (a->op != b->op || a->type != b->type)
+        return false;
+
+    switch (a->op) {
+    case SWS_OP_READ:
+    case SWS_OP_WRITE:
+        return a->rw.elems  == b->rw.elems  &&
+               a->rw.frac   == b->rw.frac   &&
+               a->rw.packed == b->rw.packed &&
+               a->rw.filter == b->rw.filter &&
+               filter_equal(a->rw.kernel, b->rw.kernel);
+    case SWS_OP_SWAP_BYTES:
+        return true;
+    case SWS_OP_SWIZZLE:
+        return a->swizzle.mask == b->swizzle.mask;
+    case SWS_OP_UNPACK:
+    case SWS_OP_PACK:
+        return !memcmp(a->pack.pattern, b->pack.pattern, sizeof(a->pack.pattern));
+    case SWS_OP_LSHIFT:
+    case SWS_OP_RSHIFT:
+        return a->shift.amount == b->shift.amount;
+    case SWS_OP_CLEAR:
+        return q4_equal(a->clear.value, b->clear.value);
+    case SWS_OP_CONVERT:
+        return a->convert.to == b->convert.to &&
+               a->convert.expand == b->convert.expand;
+    case SWS_OP_MIN:
+    case SWS_OP_MAX:
+        return q4_equal(a->clamp.limit, b->clamp.limit);
+    case SWS_OP_SCALE:
+        return !av_cmp_q(a->scale.factor, b->scale.factor);
+    case SWS_OP_LINEAR:
+        if (a->lin.mask != b->lin.mask)
+            return false;
+        for (int i = 0; i < 4; i++) {
+            for (int j = 0; j < 5; j++) {
+                if (av_cmp_q(a->lin.m[i][j], b->lin.m[i][j]))
+                    return false;
+            }
+        }
+        return true;
+    case SWS_OP_DITHER: {
+        const int size = 1 << a->dither.size_log2;
+        return a->dither.size_log2 == b->dither.size_log2 &&
+               !memcmp(a->dither.y_offset, b->dither.y_offset,
+                       sizeof(a->dither.y_offset)) &&
+               (a->dither.matrix == b->dither.matrix ||
+                !memcmp(a->dither.matrix, b->dither.matrix,
+                        size * size * sizeof(*a->dither.matrix)));
+    }
+    case SWS_OP_FILTER_H:
+    case SWS_OP_FILTER_V:
+        return filter_equal(a->filter.kernel, b->filter.kernel);
+    case SWS_OP_INVALID:
+    case SWS_OP_TYPE_NB:
+        break;
+    }
+
+    return false;
+}
+
+bool ff_sws_op_list_equal(const SwsOpList *a, const SwsOpList *b)
+{
+    if (a->num_ops != b->num_ops ||
+        memcmp(a->plane_src, b->plane_src, sizeof(a->plane_src)) ||
+        memcmp(a->plane_dst, b->plane_dst, sizeof(a->plane_dst)))
+        return false;
+
+    for (int i = 0; i < 4; i++) {
+        if (a->comps_src.flags[i]  != b->comps_src.flags[i] ||
+            a->comps_src.unused[i] != b->comps_src.unused[i])
+            return false;
+    }
+    if (!q4_equal(a->comps_src.min, b->comps_src.min) ||
+        !q4_equal(a->comps_src.max, b->comps_src.max))
+        return false;
+
+    for (int i = 0; i < a->num_ops; i++) {
+        if (!op_equal(&a->ops[i], &b->ops[i]))
+            return false;
+    }
+
+    return true;
+}
+
 const SwsOp *ff_sws_op_list_input(const SwsOpList *ops)
 {
     if (!ops->num_ops)
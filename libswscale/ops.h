@@ -290,6 +290,13 @@ void ff_sws_op_list_free(SwsOpList **ops);
  */
 SwsOpList *ff_sws_op_list_duplicate(const SwsOpList *ops);
 
+/**
+ * Returns whether two op lists describe exactly the same operations, i.e.
+ * will compile to identical kernels. Filter kernels and dither matrices are
+ * compared by value. Does not compare the `src` and `dst` metadata.
+ */
+bool ff_sws_op_list_equal(const SwsOpList *a, const SwsOpList *b);
+
 /**
  * Returns the input operation for a given op list, or NULL if there is none
  * (e.g. for a pure CLEAR-only operation list).
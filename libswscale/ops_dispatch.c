@@ -23,6 +23,7 @@
 #include "libavutil/mem.h"
 #include "libavutil/mem_internal.h"
 #include "libavutil/refstruct.h"
+#include "libavutil/thread.h"
 
 #include "ops.h"
 #include "ops_internal.h"
@@ -79,8 +80,175 @@ int ff_sws_ops_compile_backend(SwsContext *ctx, const SwsOpBackend *backend,
     return ret;
 }
 
+/**
+ * Process-wide cache of compiled op lists, shared between all contexts. This
+ * avoids recompiling the same kernels every time a graph is rebuilt, e.g. on
+ * each resolution change of a stream. Only software backends are cached, and
+ * only while at least one SwsContext references the cache.
+ */
+#define OP_CACHE_SIZE 32
+
+typedef struct OpCacheEntry {
+    SwsOpList *ops;
+    unsigned sws_flags;
+    int cpu_flags;
+    const SwsOpBackend *backend; /* or NULL if no backend supports `ops` */
+    SwsCompiledOp comp;
+} OpCacheEntry;
+
+static AVMutex op_cache_lock = AV_MUTEX_INITIALIZER;
+static OpCacheEntry *op_cache[OP_CACHE_SIZE]; /* most recently used first */
+static int op_cache_nb;
+static int op_cache_users;
+static unsigned op_cache_hits, op_cache_misses;
+
+static void op_cache_entry_free(AVRefStructOpaque opaque, void *obj)
+{
+    OpCacheEntry *entry = obj;
+    ff_sws_compiled_op_unref(&entry->comp);
+    ff_sws_op_list_free(&entry->ops);
+}
+
+static SwsCompiledOp op_cache_ref(OpCacheEntry *entry)
+{
+    SwsCompiledOp comp = entry->comp;
+    comp.free      = NULL;
+    comp.cache_ref = av_refstruct_ref(entry);
+    return comp;
+}
+
+static int op_cache_get(SwsContext *ctx, const SwsOpList *ops,
+                        SwsCompiledOp *out)
+{
+    const int cpu_flags = av_get_cpu_flags();
+    OpCacheEntry *entry = NULL;
+
+    ff_mutex_lock(&op_cache_lock);
+    if (!op_cache_users) {
+        ff_mutex_unlock(&op_cache_lock);
+        return AVERROR(EAGAIN); /* cache not in use */
+    }
+
+    for (int i = 0; i < op_cache_nb; i++) {
+        entry = op_cache[i];
+        if (entry->sws_flags != ctx->flags || entry->cpu_flags != cpu_flags ||
+            !ff_sws_op_list_equal(entry->ops, ops)) {
+            entry = NULL;
+            continue;
+        }
+
+        memmove(&op_cache[1], &op_cache[0], i * sizeof(*op_cache));
+        op_cache[0] = entry;
+        if (entry->backend)
+            *out = op_cache_ref(entry);
+        break;
+    }
+    if (entry)
+        op_cache_hits++;
+    else
+        op_cache_misses++;
+    const unsigned hits = op_cache_hits, misses = op_cache_misses;
+    const SwsOpBackend *backend = entry ? entry->backend : NULL;
+    ff_mutex_unlock(&op_cache_lock);
+
+    if (!entry) {
+        av_log(ctx, AV_LOG_DEBUG, "Op cache miss (hits: %u, misses: %u)\n",
+               hits, misses);
+        return AVERROR(ENOENT);
+    }
+
+    av_log(ctx, AV_LOG_DEBUG, "Op cache hit (hits: %u, misses: %u)\n",
+           hits, misses);
+    if (!backend)
+        return AVERROR(ENOTSUP);
+
+    av_log(ctx, AV_LOG_VERBOSE, "Reusing cached operations compiled using "
+           "backend '%s'\n", backend->name);
+    return 0;
+}
+
+/**
+ * Takes over ownership of `comp`, and replaces it by a reference. A NULL
+ * `backend` records that `ops` can not be compiled.
+ */
+static void op_cache_add(SwsContext *ctx, const SwsOpList *ops,
+                         const SwsOpBackend *backend, SwsCompiledOp *comp)
+{
+    OpCacheEntry *entry = av_refstruct_alloc_ext(sizeof(*entry), 0, NULL,
+                                                 op_cache_entry_free);
+    if (!entry)
+        return; /* not fatal, just don't cache */
+
+    entry->ops = ff_sws_op_list_duplicate(ops);
+    if (!entry->ops) {
+        av_refstruct_unref(&entry);
+        return;
+    }
+
+    entry->sws_flags = ctx->flags;
+    entry->cpu_flags = av_get_cpu_flags();
+    entry->backend   = backend;
+    if (backend) {
+        entry->comp = *comp;
+        *comp = op_cache_ref(entry);
+    }
+
+    ff_mutex_lock(&op_cache_lock);
+    if (op_cache_users) {
+        if (op_cache_nb == OP_CACHE_SIZE)
+            av_refstruct_unref(&op_cache[--op_cache_nb]);
+        memmove(&op_cache[1], &op_cache[0], op_cache_nb * sizeof(*op_cache));
+        op_cache[0] = entry;
+        op_cache_nb++;
+        entry = NULL;
+    }
+    ff_mutex_unlock(&op_cache_lock);
+
+    /* Only reached with an entry left if the last user went away meanwhile */
+    av_refstruct_unref(&entry);
+}
+
+void ff_sws_op_cache_ref(void)
+{
+    ff_mutex_lock(&op_cache_lock);
+    op_cache_users++;
+    ff_mutex_unlock(&op_cache_lock);
+}
+
+void ff_sws_op_cache_unref(void)
+{
+    ff_mutex_lock(&op_cache_lock);
+    av_assert1(op_cache_users > 0);
+    if (!--op_cache_users) {
+        while (op_cache_nb)
+            av_refstruct_unref(&op_cache[--op_cache_nb]);
+    }
+    ff_mutex_unlock(&op_cache_lock);
+}
+
+void ff_sws_op_cache_stats(unsigned *hits, unsigned *misses)
+{
+    ff_mutex_lock(&op_cache_lock);
+    *hits   = op_cache_hits;
+    *misses = op_cache_misses;
+    ff_mutex_unlock(&op_cache_lock);
+}
+
 int ff_sws_ops_compile(SwsContext *ctx, const SwsOpList *ops, SwsCompiledOp *out)
 {
+    bool cacheable = ops->src.hw_format == AV_PIX_FMT_NONE &&
+                     ops->dst.hw_format == AV_PIX_FMT_NONE;
+    if (cacheable) {
+        int ret = op_cache_get(ctx, ops, out);
+        if (ret == AVERROR(EAGAIN)) {
+            cacheable = false;
+        } else if (ret != AVERROR(ENOENT)) {
+            if (ret >= 0)
+                ff_sws_op_list_print(ctx, AV_LOG_VERBOSE, AV_LOG_TRACE, ops);
+            return ret;
+        }
+    }
+
     for (int n = 0; ff_sws_op_backends[n]; n++) {
         const SwsOpBackend *backend = ff_sws_op_backends[n];
         if (ops->src.hw_format != backend->hw_format ||
@@ -95,15 +263,21 @@ int ff_sws_ops_compile(SwsContext *ctx, const SwsOpList *ops, SwsCompiledOp *out
                out->cpu_flags);
 
         ff_sws_op_list_print(ctx, AV_LOG_VERBOSE, AV_LOG_TRACE, ops);
+        if (cacheable && !out->opaque)
+            op_cache_add(ctx, ops, backend, out);
         return 0;
     }
 
+    if (cacheable)
+        op_cache_add(ctx, ops, NULL, NULL);
     return AVERROR(ENOTSUP);
 }
 
 void ff_sws_compiled_op_unref(SwsCompiledOp *comp)
 {
-    if (comp->free)
+    if (comp->cache_ref)
+        av_refstruct_unref(&comp->cache_ref);
+    else if (comp->free)
         comp->free(comp->priv);
 
     *comp = (SwsCompiledOp) {0};
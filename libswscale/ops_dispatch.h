@@ -123,8 +123,25 @@ typedef struct SwsCompiledOp {
     /* Arbitrary private data */
     void *priv;
     void (*free)(void *priv);
+
+    /* Shared cache entry owning `priv` instead of `free`, if any (refstruct) */
+    void *cache_ref;
 } SwsCompiledOp;
 
 void ff_sws_compiled_op_unref(SwsCompiledOp *comp);
 
+/**
+ * Add or drop a reference to the process-wide cache of compiled op lists used
+ * by ff_sws_ops_compile(). Each SwsContext holds one for its lifetime;
+ * dropping the last one frees all cached op lists. Compiled ops handed out
+ * earlier remain valid.
+ */
+void ff_sws_op_cache_ref(void);
+void ff_sws_op_cache_unref(void);
+
+/**
+ * Get the total number of op cache hits and misses so far.
+ */
+void ff_sws_op_cache_stats(unsigned *hits, unsigned *misses);
+
 #endif /* SWSCALE_OPS_DISPATCH_H */
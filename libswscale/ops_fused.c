@@ -0,0 +1,443 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "libavutil/avassert.h"
+#include "libavutil/mem_internal.h"
+
+#include "ops_backend.h"
+
+#if AV_GCC_VERSION_AT_LEAST(4, 4)
+#pragma GCC optimize ("finite-math-only")
+#endif
+
+/**
+ * Fused backend for the common integer -> float -> integer conversions, i.e.
+ * read, convert, (swizzle,) linear, dither, clamp, convert, (swizzle/clear,)
+ * write. The entire op list is collapsed into a single kernel per block,
+ * instantiated for the input/output pixel size and packing, which avoids the
+ * per-op indirect calls and block round trips of the reference backend.
+ *
+ * The arithmetic is performed in exactly the same order as the reference
+ * backend, so the results are bit-identical.
+ */
+
+#define FUSED_BLOCK_SIZE 32
+
+#define q2float(q) ((q).den ? (float) (q).num / (q).den : 0.0f)
+
+typedef struct FusedPriv {
+    int elems_in, elems_out;
+    int in_map[4];      /* read component for each float component, or -1 */
+    int out_map[4];     /* float component for each written component, or -1 */
+    uint16_t clear[4];  /* value for written components with out_map[i] < 0 */
+
+    bool linear, linear4;
+    float m[4][4], k[4];
+
+    bool dither;
+    int dither_size_log2;
+    int8_t dither_offset[4];
+    float *dither_matrix;
+
+    bool min[4], max[4];
+    float min_val[4], max_val[4];
+} FusedPriv;
+
+static av_always_inline void
+fused_block(const FusedPriv *restrict p, const uint8_t *const in[4],
+            uint8_t *const out[4], const int x, const int y,
+            const int in_size, const int in_packed,
+            const int out_size, const int out_packed)
+{
+    DECLARE_ALIGNED(32, float, buf)[4][FUSED_BLOCK_SIZE];
+
+    for (int c = 0; c < 4; c++) {
+        float *restrict v = buf[c];
+        const int idx = p->in_map[c];
+        if (idx < 0) {
+            for (int i = 0; i < FUSED_BLOCK_SIZE; i++)
+                v[i] = 0.0f;
+        } else if (in_size == 1) {
+            const uint8_t *restrict src = in_packed ? in[0] + idx : in[idx];
+            const int step = in_packed ? in_packed : 1;
+            SWS_LOOP
+            for (int i = 0; i < FUSED_BLOCK_SIZE; i++)
+                v[i] = src[i * step];
+        } else {
+            const uint16_t *restrict src = in_packed ? (const uint16_t *) in[0] + idx
+                                                     : (const uint16_t *) in[idx];
+            const int step = in_packed ? in_packed : 1;
+            SWS_LOOP
+            for (int i = 0; i < FUSED_BLOCK_SIZE; i++)
+                v[i] = src[i * step];
+        }
+    }
+
+    float *restrict bx = buf[0], *restrict by = buf[1];
+    float *restrict bz = buf[2], *restrict bw = buf[3];
+    if (p->linear && p->linear4) {
+        SWS_LOOP
+        for (int i = 0; i < FUSED_BLOCK_SIZE; i++) {
+            const float xx = bx[i], yy = by[i], zz = bz[i], ww = bw[i];
+            bx[i] = p->k[0] + p->m[0][0] * xx + p->m[0][1] * yy + p->m[0][2] * zz + p->m[0][3] * ww;
+            by[i] = p->k[1] + p->m[1][0] * xx + p->m[1][1] * yy + p->m[1][2] * zz + p->m[1][3] * ww;
+            bz[i] = p->k[2] + p->m[2][0] * xx + p->m[2][1] * yy + p->m[2][2] * zz + p->m[2][3] * ww;
+            bw[i] = p->k[3] + p->m[3][0] * xx + p->m[3][1] * yy + p->m[3][2] * zz + p->m[3][3] * ww;
+        }
+    } else if (p->linear) {
+        /* w is passed through untouched */
+        SWS_LOOP
+        for (int i = 0; i < FUSED_BLOCK_SIZE; i++) {
+            const float xx = bx[i], yy = by[i], zz = bz[i];
+            bx[i] = p->k[0] + p->m[0][0] * xx + p->m[0][1] * yy + p->m[0][2] * zz;
+            by[i] = p->k[1] + p->m[1][0] * xx + p->m[1][1] * yy + p->m[1][2] * zz;
+            bz[i] = p->k[2] + p->m[2][0] * xx + p->m[2][1] * yy + p->m[2][2] * zz;
+        }
+    }
+
+    if (p->dither) {
+        const int size_log2 = p->dither_size_log2;
+        const int size  = 1 << size_log2;
+        const int mask  = size - 1;
+        const int width = FFMAX(size, FUSED_BLOCK_SIZE);
+        const int base  = x & ~(FUSED_BLOCK_SIZE - 1) & mask;
+        for (int c = 0; c < 4; c++) {
+            float *restrict v = buf[c];
+            if (p->dither_offset[c] < 0)
+                continue;
+            if (size_log2) {
+                const int row = (y + p->dither_offset[c]) & mask;
+                const float *restrict matrix = &p->dither_matrix[row * width + base];
+                SWS_LOOP
+                for (int i = 0; i < FUSED_BLOCK_SIZE; i++)
+                    v[i] += matrix[i];
+            } else {
+                SWS_LOOP
+                for (int i = 0; i < FUSED_BLOCK_SIZE; i++)
+                    v[i] += 0.5f;
+            }
+        }
+    }
+
+    for (int c = 0; c < 4; c++) {
+        float *restrict v = buf[c];
+        if (p->max[c]) {
+            const float limit = p->max_val[c];
+            SWS_LOOP
+            for (int i = 0; i < FUSED_BLOCK_SIZE; i++)
+                v[i] = FFMAX(v[i], limit);
+        }
+        if (p->min[c]) {
+            const float limit = p->min_val[c];
+            SWS_LOOP
+            for (int i = 0; i < FUSED_BLOCK_SIZE; i++)
+                v[i] = FFMIN(v[i], limit);
+        }
+    }
+
+    for (int c = 0; c < p->elems_out; c++) {
+        const int idx = p->out_map[c];
+        const float *restrict v = buf[idx < 0 ? 0 : idx];
+        const int step = out_packed ? out_packed : 1;
+        if (out_size == 1) {
+            uint8_t *restrict dst = out_packed ? out[0] + c : out[c];
+            if (idx < 0) {
+                for (int i = 0; i < FUSED_BLOCK_SIZE; i++)
+                    dst[i * step] = p->clear[c];
+            } else {
+                SWS_LOOP
+                for (int i = 0; i < FUSED_BLOCK_SIZE; i++)
+                    dst[i * step] = v[i];
+            }
+        } else {
+            uint16_t *restrict dst = out_packed ? (uint16_t *) out[0] + c
+                                                : (uint16_t *) out[c];
+            if (idx < 0) {
+                for (int i = 0; i < FUSED_BLOCK_SIZE; i++)
+                    dst[i * step] = p->clear[c];
+            } else {
+                SWS_LOOP
+                for (int i = 0; i < FUSED_BLOCK_SIZE; i++)
+                    dst[i * step] = v[i];
+            }
+        }
+    }
+}
+
+static av_always_inline void
+fused_process(const SwsOpExec *exec, const FusedPriv *p,
+              const int bx_start, const int y_start,
+              const int bx_end, const int y_end,
+              const int in_size, const int in_packed,
+              const int out_size, const int out_packed)
+{
+    const uint8_t *in[4];
+    uint8_t *out[4];
+    for (int i = 0; i < 4; i++) {
+        in[i]  = exec->in[i];
+        out[i] = exec->out[i];
+    }
+
+    for (int y = y_start; y < y_end; y++) {
+        for (int block = bx_start; block < bx_end; block++) {
+            fused_block(p, in, out, block * FUSED_BLOCK_SIZE, y,
+                        in_size, in_packed, out_size, out_packed);
+            for (int i = 0; i < 4; i++) {
+                in[i]  += exec->block_size_in;
+                out[i] += exec->block_size_out;
+            }
+        }
+
+        for (int i = 0; i < 4; i++) {
+            in[i]  += exec->in_bump[i];
+            out[i] += exec->out_bump[i];
+        }
+    }
+}
+
+#define DECL_PROCESS(IN_SIZE, IN_PACKED, OUT_SIZE, OUT_PACKED)                  \
+static SWS_FUNC void                                                            \
+process_##IN_SIZE##_##IN_PACKED##_##OUT_SIZE##_##OUT_PACKED(                    \
+    const SwsOpExec *exec, const void *priv, int bx_start, int y_start,         \
+    int bx_end, int y_end)                                                      \
+{                                                                               \
+    fused_process(exec, priv, bx_start, y_start, bx_end, y_end,                 \
+                  IN_SIZE, IN_PACKED, OUT_SIZE, OUT_PACKED);                    \
+}
+
+#define DECL_PROCESS_OUT(IN_SIZE, IN_PACKED)                                    \
+    DECL_PROCESS(IN_SIZE, IN_PACKED, 1, 0)                                      \
+    DECL_PROCESS(IN_SIZE, IN_PACKED, 1, 3)                                      \
+    DECL_PROCESS(IN_SIZE, IN_PACKED, 1, 4)                                      \
+    DECL_PROCESS(IN_SIZE, IN_PACKED, 2, 0)                                      \
+    DECL_PROCESS(IN_SIZE, IN_PACKED, 2, 3)                                      \
+    DECL_PROCESS(IN_SIZE, IN_PACKED, 2, 4)
+
+DECL_PROCESS_OUT(1, 0)
+DECL_PROCESS_OUT(1, 3)
+DECL_PROCESS_OUT(1, 4)
+DECL_PROCESS_OUT(2, 0)
+DECL_PROCESS_OUT(2, 3)
+DECL_PROCESS_OUT(2, 4)
+
+#define PROCESS_OUT(IN_SIZE, IN_PACKED)                                         \
+    {                                                                           \
+        process_##IN_SIZE##_##IN_PACKED##_1_0,                                  \
+        process_##IN_SIZE##_##IN_PACKED##_1_3,                                  \
+        process_##IN_SIZE##_##IN_PACKED##_1_4,                                  \
+        process_##IN_SIZE##_##IN_PACKED##_2_0,                                  \
+        process_##IN_SIZE##_##IN_PACKED##_2_3,                                  \
+        process_##IN_SIZE##_##IN_PACKED##_2_4,                                  \
+    }
+
+/* Indexed by [in_size - 1][in_packed][out_size - 1][out_packed] */
+static const SwsOpFunc process_funcs[6][6] = {
+    PROCESS_OUT(1, 0), PROCESS_OUT(1, 3), PROCESS_OUT(1, 4),
+    PROCESS_OUT(2, 0), PROCESS_OUT(2, 3), PROCESS_OUT(2, 4),
+};
+
+static int packing_idx(const SwsOp *op)
+{
+    if (op->rw.frac || op->rw.filter)
+        return -1;
+    if (!op->rw.packed)
+        return 0;
+    switch (op->rw.elems) {
+    case 3: return 1;
+    case 4: return 2;
+    default: return -1;
+    }
+}
+
+static void free_priv(void *priv)
+{
+    FusedPriv *p = priv;
+    av_free(p->dither_matrix);
+    av_free(p);
+}
+
+static int compile(SwsContext *ctx, SwsOpList *ops, SwsCompiledOp *out)
+{
+    enum { STAGE_INT, STAGE_FLOAT, STAGE_OUT } stage = STAGE_INT;
+    const SwsOp *read = &ops->ops[0];
+    const SwsOp *write = &ops->ops[ops->num_ops - 1];
+    bool float_ops = false, clamped = false;
+    FusedPriv p = {0};
+    int in_idx, out_idx;
+
+    if (read->op != SWS_OP_READ || write->op != SWS_OP_WRITE)
+        return AVERROR(ENOTSUP);
+    if (read->type != SWS_PIXEL_U8 && read->type != SWS_PIXEL_U16)
+        return AVERROR(ENOTSUP);
+    if (write->type != SWS_PIXEL_U8 && write->type != SWS_PIXEL_U16)
+        return AVERROR(ENOTSUP);
+    if ((in_idx = packing_idx(read)) < 0 || (out_idx = packing_idx(write)) < 0)
+        return AVERROR(ENOTSUP);
+
+    p.elems_in  = read->rw.elems;
+    p.elems_out = write->rw.elems;
+    for (int i = 0; i < 4; i++) {
+        p.in_map[i]  = i < p.elems_in ? i : -1;
+        p.out_map[i] = i;
+    }
+
+    for (int n = 1; n < ops->num_ops - 1; n++) {
+        const SwsOp *op = &ops->ops[n];
+        switch (op->op) {
+        case SWS_OP_CONVERT:
+            if (op->convert.expand)
+                goto fail;
+            if (stage == STAGE_INT && op->type == read->type &&
+                op->convert.to == SWS_PIXEL_F32) {
+                stage = STAGE_FLOAT;
+            } else if (stage == STAGE_FLOAT && op->convert.to == write->type) {
+                stage = STAGE_OUT;
+            } else {
+                goto fail;
+            }
+            break;
+
+        case SWS_OP_SWIZZLE: {
+            if (stage == STAGE_OUT) {
+                const FusedPriv orig = p;
+                for (int i = 0; i < 4; i++) {
+                    p.out_map[i] = orig.out_map[op->swizzle.in[i]];
+                    p.clear[i]   = orig.clear[op->swizzle.in[i]];
+                }
+            } else if (!float_ops) {
+                const FusedPriv orig = p;
+                for (int i = 0; i < 4; i++)
+                    p.in_map[i] = orig.in_map[op->swizzle.in[i]];
+            } else {
+                goto fail;
+            }
+            break;
+        }
+
+        case SWS_OP_LINEAR:
+            if (stage != STAGE_FLOAT || float_ops)
+                goto fail;
+            p.linear  = true;
+            p.linear4 = op->lin.mask & (SWS_MASK_ROW(3) | SWS_MASK_COL(3));
+            for (int i = 0; i < 4; i++) {
+                for (int j = 0; j < 4; j++)
+                    p.m[i][j] = q2float(op->lin.m[i][j]);
+                p.k[i] = q2float(op->lin.m[i][4]);
+            }
+            float_ops = true;
+            break;
+
+        case SWS_OP_DITHER:
+            if (stage != STAGE_FLOAT || p.dither || clamped)
+                goto fail;
+            p.dither = true;
+            p.dither_size_log2 = op->dither.size_log2;
+            for (int i = 0; i < 4; i++)
+                p.dither_offset[i] = op->dither.y_offset[i];
+            if (op->dither.size_log2) {
+                const int size  = 1 << op->dither.size_log2;
+                const int width = FFMAX(size, FUSED_BLOCK_SIZE);
+                float *matrix = av_malloc_array(size * width, sizeof(*matrix));
+                if (!matrix)
+                    return AVERROR(ENOMEM);
+                for (int y = 0; y < size; y++) {
+                    for (int x = 0; x < size; x++)
+                        matrix[y * width + x] = q2float(op->dither.matrix[y * size + x]);
+                    for (int x = size; x < width; x++) /* pad to block size */
+                        matrix[y * width + x] = matrix[y * width + (x % size)];
+                }
+                p.dither_matrix = matrix;
+            }
+            float_ops = true;
+            break;
+
+        case SWS_OP_MIN:
+        case SWS_OP_MAX: {
+            bool *flags = op->op == SWS_OP_MIN ? p.min : p.max;
+            float *vals = op->op == SWS_OP_MIN ? p.min_val : p.max_val;
+            if (stage != STAGE_FLOAT)
+                goto fail;
+            for (int i = 0; i < 4; i++) {
+                if (flags[i])
+                    goto fail;
+                if (!op->clamp.limit[i].den)
+                    continue;
+                flags[i] = true;
+                vals[i]  = q2float(op->clamp.limit[i]);
+            }
+            float_ops = clamped = true;
+            break;
+        }
+
+        case SWS_OP_CLEAR:
+            if (stage != STAGE_OUT)
+                goto fail;
+            for (int i = 0; i < 4; i++) {
+                const AVRational value = op->clear.value[i];
+                if (!value.den)
+                    continue;
+                if (value.den != 1 || value.num < 0 || value.num > UINT16_MAX)
+                    goto fail;
+                p.out_map[i] = -1;
+                p.clear[i]   = value.num;
+            }
+            break;
+
+        default:
+            goto fail;
+        }
+    }
+
+    if (stage != STAGE_OUT)
+        goto fail;
+
+    /* The kernel always applies MAX before MIN, which is only equivalent to
+     * the opposite order if the limits do not overlap */
+    for (int i = 0; i < 4; i++) {
+        if (p.min[i] && p.max[i] && p.max_val[i] > p.min_val[i])
+            goto fail;
+    }
+
+    FusedPriv *priv = av_memdup(&p, sizeof(p));
+    if (!priv) {
+        av_free(p.dither_matrix);
+        return AVERROR(ENOMEM);
+    }
+
+    const int in_size  = ff_sws_pixel_type_size(read->type);
+    const int out_size = ff_sws_pixel_type_size(write->type);
+    *out = (SwsCompiledOp) {
+        .func        = process_funcs[(in_size - 1) * 3 + in_idx]
+                                    [(out_size - 1) * 3 + out_idx],
+        .slice_align = 1,
+        .block_size  = FUSED_BLOCK_SIZE,
+        .priv        = priv,
+        .free        = free_priv,
+    };
+    return 0;
+
+fail:
+    av_free(p.dither_matrix);
+    return AVERROR(ENOTSUP);
+}
+
+const SwsOpBackend backend_fused = {
+    .name       = "fused",
+    .compile    = compile,
+    .hw_format  = AV_PIX_FMT_NONE,
+};
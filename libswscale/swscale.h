@@ -280,6 +280,21 @@ typedef struct SwsContext {
      */
     SwsScaler scaler_sub;
 
+    /**
+     * Optional callback used by sws_scale_frame() to run the slices of each
+     * scaling pass, in place of an internal thread pool. This allows sharing
+     * the threads of the caller between several contexts. If set, no threads
+     * are created and `threads` is the number of slices a pass is split in.
+     *
+     * The callback must call func(priv, jobnr) for every jobnr from 0 to
+     * nb_jobs - 1, possibly concurrently, and return after all calls have
+     * completed. It returns 0 on success or a negative error code.
+     *
+     * Not used by the legacy API.
+     */
+    int (*execute)(struct SwsContext *sws, int (*func)(void *priv, int jobnr),
+                   void *priv, int nb_jobs);
+
     /* Remember to add new fields to graph.c:opts_equal() */
 } SwsContext;
 
@@ -0,0 +1,142 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/*
+ * Check that identical contexts share the process-wide compiled op list and
+ * filter kernel caches, and that the caches are flushed once the last
+ * context is freed.
+ */
+
+#include <stdio.h>
+
+#include "libavutil/error.h"
+#include "libavutil/frame.h"
+#include "libswscale/swscale.h"
+#include "libswscale/filters.h"
+#include "libswscale/ops_dispatch.h"
+
+typedef struct CacheStats {
+    unsigned op_hits, op_misses;
+    unsigned filter_hits, filter_misses;
+} CacheStats;
+
+static CacheStats get_stats(void)
+{
+    CacheStats st;
+    ff_sws_op_cache_stats(&st.op_hits, &st.op_misses);
+    ff_sws_filter_cache_stats(&st.filter_hits, &st.filter_misses);
+    return st;
+}
+
+static int scale_once(SwsContext **pctx, const AVFrame *src)
+{
+    AVFrame *dst = av_frame_alloc();
+    int ret;
+
+    if (!dst)
+        return AVERROR(ENOMEM);
+    dst->width  = 48;
+    dst->height = 32;
+    dst->format = AV_PIX_FMT_YUV444P;
+
+    *pctx = sws_alloc_context();
+    if (!*pctx) {
+        av_frame_free(&dst);
+        return AVERROR(ENOMEM);
+    }
+    (*pctx)->flags = SWS_BICUBIC | SWS_UNSTABLE;
+
+    ret = sws_scale_frame(*pctx, dst, src);
+    av_frame_free(&dst);
+    return ret;
+}
+
+static int check(const char *what, unsigned value, unsigned expected)
+{
+    if (value == expected)
+        return 0;
+    fprintf(stderr, "%s: got %u, expected %u\n", what, value, expected);
+    return 1;
+}
+
+int main(void)
+{
+    SwsContext *a = NULL, *b = NULL, *c = NULL;
+    CacheStats st0, st1, st2, st3;
+    AVFrame *src;
+    int ret, fail = 0;
+
+    src = av_frame_alloc();
+    if (!src)
+        return 1;
+    src->width  = 96;
+    src->height = 64;
+    src->format = AV_PIX_FMT_GBRP;
+    ret = av_frame_get_buffer(src, 0);
+    if (ret < 0)
+        goto end;
+    for (int p = 0; p < 3; p++) {
+        for (int y = 0; y < src->height; y++) {
+            for (int x = 0; x < src->linesize[p]; x++)
+                src->data[p][y * src->linesize[p] + x] = x * 7 + y * 3 + p * 50;
+        }
+    }
+
+    st0 = get_stats();
+    if ((ret = scale_once(&a, src)) < 0)
+        goto end;
+    st1 = get_stats();
+    if ((ret = scale_once(&b, src)) < 0)
+        goto end;
+    st2 = get_stats();
+
+    /* The first context compiles everything, the second one reuses it */
+    if (st1.op_misses == st0.op_misses || st1.filter_misses == st0.filter_misses) {
+        fprintf(stderr, "first context did not populate the caches\n");
+        fail = 1;
+    }
+    if (st2.op_hits == st1.op_hits || st2.filter_hits == st1.filter_hits) {
+        fprintf(stderr, "second context did not hit the caches\n");
+        fail = 1;
+    }
+    fail |= check("op cache misses",     st2.op_misses - st1.op_misses, 0);
+    fail |= check("filter cache misses", st2.filter_misses - st1.filter_misses, 0);
+
+    /* Freeing the last context flushes the caches */
+    sws_free_context(&a);
+    sws_free_context(&b);
+    if ((ret = scale_once(&c, src)) < 0)
+        goto end;
+    st3 = get_stats();
+    fail |= check("op cache misses after flush", st3.op_misses - st2.op_misses,
+                                                 st1.op_misses - st0.op_misses);
+    fail |= check("filter cache misses after flush",
+                  st3.filter_misses - st2.filter_misses,
+                  st1.filter_misses - st0.filter_misses);
+
+end:
+    if (ret < 0) {
+        fprintf(stderr, "scaling failed: %s\n", av_err2str(ret));
+        fail = 1;
+    }
+    sws_free_context(&a);
+    sws_free_context(&b);
+    sws_free_context(&c);
+    av_frame_free(&src);
+    return fail;
+}
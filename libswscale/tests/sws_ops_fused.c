@@ -0,0 +1,198 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/*
+ * Compile the op list of every supported format conversion with the fused
+ * backend, and check that each list it accepts produces output bit-identical
+ * to the reference C backend on random input.
+ *
+ * This complements checkasm, which only exercises single ops (rejected by
+ * the fused backend) and does not compare C-only backends against each other.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "libavutil/error.h"
+#include "libavutil/lfg.h"
+#include "libavutil/mem_internal.h"
+#include "libavutil/pixdesc.h"
+#include "libswscale/ops.h"
+#include "libswscale/ops_internal.h"
+
+enum {
+    PIXELS = 64,
+    LINES  = 16,
+    LINE_SIZE = PIXELS * 4 * sizeof(uint16_t),
+};
+
+typedef struct FusedTest {
+    const SwsOpBackend *ref, *fused;
+    AVLFG rand;
+    unsigned tested, failed;
+} FusedTest;
+
+static DECLARE_ALIGNED_64(uint8_t, src)[4][LINES][LINE_SIZE];
+static DECLARE_ALIGNED_64(uint8_t, dst_ref)[4][LINES][LINE_SIZE];
+static DECLARE_ALIGNED_64(uint8_t, dst_new)[4][LINES][LINE_SIZE];
+
+static const SwsOpBackend *find_backend(const char *name)
+{
+    for (int n = 0; ff_sws_op_backends[n]; n++) {
+        if (!strcmp(ff_sws_op_backends[n]->name, name))
+            return ff_sws_op_backends[n];
+    }
+    return NULL;
+}
+
+static int pixel_bytes(const SwsOp *op)
+{
+    const int elems = op->rw.packed ? op->rw.elems : 1;
+    return elems * ff_sws_pixel_type_size(op->type);
+}
+
+/* Fill the input with random values inside the range the op list assumes */
+static void fill_input(FusedTest *t, const SwsOpList *ops)
+{
+    const SwsOp *read = &ops->ops[0];
+    const int size   = ff_sws_pixel_type_size(read->type);
+    const int planes = read->rw.packed ? 1 : read->rw.elems;
+    const int elems  = read->rw.packed ? read->rw.elems : 1;
+
+    for (int p = 0; p < planes; p++) {
+        for (int y = 0; y < LINES; y++) {
+            for (int x = 0; x < PIXELS * elems; x++) {
+                const int idx = read->rw.packed ? x % elems : p;
+                const AVRational max = ops->comps_src.max[idx];
+                uint32_t val = av_lfg_get(&t->rand);
+                if (max.den == 1 && max.num >= 0)
+                    val %= (uint32_t) max.num + 1;
+                if (size == 1)
+                    src[p][y][x] = val;
+                else
+                    ((uint16_t *) src[p][y])[x] = val;
+            }
+        }
+    }
+}
+
+static void run(const SwsOpList *ops, const SwsCompiledOp *comp,
+                uint8_t (*dst)[LINES][LINE_SIZE])
+{
+    const SwsOp *read  = &ops->ops[0];
+    const SwsOp *write = &ops->ops[ops->num_ops - 1];
+    SwsOpExec exec = {0};
+
+    exec.width  = PIXELS;
+    exec.height = exec.slice_h = LINES;
+    exec.block_size_in  = comp->block_size * pixel_bytes(read);
+    exec.block_size_out = comp->block_size * pixel_bytes(write);
+    for (int i = 0; i < 4; i++) {
+        exec.in[i]  = src[i][0];
+        exec.out[i] = dst[i][0];
+        exec.in_stride[i]  = LINE_SIZE;
+        exec.out_stride[i] = LINE_SIZE;
+        exec.in_bump[i]  = LINE_SIZE - PIXELS * pixel_bytes(read);
+        exec.out_bump[i] = LINE_SIZE - PIXELS * pixel_bytes(write);
+    }
+
+    memset(dst, 0, sizeof(dst_ref));
+    comp->func(&exec, comp->priv, 0, 0, PIXELS / comp->block_size, LINES);
+}
+
+static int check_ops(SwsContext *ctx, void *opaque, SwsOpList *ops)
+{
+    FusedTest *t = opaque;
+    SwsCompiledOp comp_ref = {0}, comp_new = {0};
+    const SwsOp *write;
+    int ret;
+
+    ret = ff_sws_ops_compile_backend(ctx, t->fused, ops, &comp_new);
+    if (ret == AVERROR(ENOTSUP))
+        return 0;
+    else if (ret < 0)
+        return ret;
+
+    ret = ff_sws_ops_compile_backend(ctx, t->ref, ops, &comp_ref);
+    if (ret < 0)
+        goto end;
+
+    if (PIXELS % comp_ref.block_size || PIXELS % comp_new.block_size) {
+        fprintf(stderr, "%s -> %s: unexpected block size\n",
+                av_get_pix_fmt_name(ops->src.format),
+                av_get_pix_fmt_name(ops->dst.format));
+        t->failed++;
+        goto end;
+    }
+
+    fill_input(t, ops);
+    run(ops, &comp_ref, dst_ref);
+    run(ops, &comp_new, dst_new);
+
+    write = &ops->ops[ops->num_ops - 1];
+    for (int p = 0; p < (write->rw.packed ? 1 : write->rw.elems); p++) {
+        for (int y = 0; y < LINES; y++) {
+            if (memcmp(dst_ref[p][y], dst_new[p][y], PIXELS * pixel_bytes(write))) {
+                fprintf(stderr, "%s -> %s: mismatch in plane %d, line %d\n",
+                        av_get_pix_fmt_name(ops->src.format),
+                        av_get_pix_fmt_name(ops->dst.format), p, y);
+                t->failed++;
+                goto end;
+            }
+        }
+    }
+    t->tested++;
+
+end:
+    ff_sws_compiled_op_unref(&comp_new);
+    ff_sws_compiled_op_unref(&comp_ref);
+    return ret;
+}
+
+int main(void)
+{
+    FusedTest t = {
+        .ref   = find_backend("c"),
+        .fused = find_backend("fused"),
+    };
+    SwsContext *ctx;
+    int ret;
+
+    if (!t.ref || !t.fused)
+        return 1;
+    av_lfg_init(&t.rand, 1);
+
+    ctx = sws_alloc_context();
+    if (!ctx)
+        return 1;
+
+    ret = ff_sws_enum_op_lists(ctx, &t, AV_PIX_FMT_NONE, AV_PIX_FMT_NONE, check_ops);
+    sws_free_context(&ctx);
+    if (ret < 0) {
+        fprintf(stderr, "enumerating op lists failed: %s\n", av_err2str(ret));
+        return 1;
+    }
+
+    /* Guard against the fused backend silently rejecting everything */
+    if (!t.tested) {
+        fprintf(stderr, "no op list was accepted by the fused backend\n");
+        return 1;
+    }
+
+    return t.failed > 0;
+}
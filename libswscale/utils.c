@@ -62,7 +62,11 @@
 #include "rgb2rgb.h"
 #include "swscale.h"
 #include "swscale_internal.h"
+#include "filters.h"
 #include "graph.h"
+#if CONFIG_UNSTABLE
+#include "ops_dispatch.h"
+#endif
 
 #if CONFIG_VULKAN
 #include "vulkan/ops.h"
@@ -1039,6 +1043,12 @@ SwsContext *sws_alloc_context(void)
     atomic_init(&c->stride_unaligned_warned, 0);
     atomic_init(&c->data_unaligned_warned,   0);
 
+    /* Share compiled kernels with other contexts for as long as we live */
+#if CONFIG_UNSTABLE
+    ff_sws_op_cache_ref();
+#endif
+    ff_sws_filter_cache_ref();
+
     return &c->opts;
 }
 
@@ -2293,6 +2303,10 @@ void sws_freeContext(SwsContext *sws)
 
     for (i = 0; i < FF_ARRAY_ELEMS(c->graph); i++)
         ff_sws_graph_free(&c->graph[i]);
+#if CONFIG_UNSTABLE
+    ff_sws_op_cache_unref();
+#endif
+    ff_sws_filter_cache_unref();
 
     for (i = 0; i < c->nb_slice_ctx; i++)
         sws_freeContext(c->slice_ctx[i]);
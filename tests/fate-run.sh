@@ -171,6 +171,15 @@ ffmpeg(){
     run ffmpeg${PROGSUF}${EXECSUF} ${ffmpeg_args}
 }
 
+thread_budget(){
+    budget=$1
+    shift
+    run ffmpeg${PROGSUF}${EXECSUF} -nostdin -nostats -v verbose -thread_budget $budget "$@" 2>&1 |
+        sed -n 's/.*Thread budget: \([0-9]*\) thread.*/\1/p' |
+        awk -v budget=$budget '{ nodes++; if ($1 > 1) used += $1 }
+            END { print nodes " nodes, " (used <= budget ? "within budget" : "over budget") }'
+}
+
 ffprobe_demux(){
     filename=$1
     shift
@@ -156,6 +156,22 @@ FATE_AAC_CT = sbr_bc-ps_i.3gp  \
 
 FATE_AAC += $(FATE_AAC_CT:%=fate-aac-ct-%)
 
+FATE_AAC += fate-aac-slice-threads-al04_44
+fate-aac-slice-threads-al04_44: CMD = threads=4 thread_type=slice pcm -i $(TARGET_SAMPLES)/aac/al04_44.mp4
+fate-aac-slice-threads-al04_44: REF = $(SAMPLES)/aac/al04_44.s16
+
+FATE_AAC += fate-aac-slice-threads-al07_96
+fate-aac-slice-threads-al07_96: CMD = threads=4 thread_type=slice pcm -i $(TARGET_SAMPLES)/aac/al07_96.mp4
+fate-aac-slice-threads-al07_96: REF = $(SAMPLES)/aac/al07_96_reorder.s16
+
+FATE_AAC += fate-aac-slice-threads-al_sbr_hq_cm_48_5.1
+fate-aac-slice-threads-al_sbr_hq_cm_48_5.1: CMD = threads=4 thread_type=slice pcm -i $(TARGET_SAMPLES)/aac/al_sbr_cm_48_5.1.mp4
+fate-aac-slice-threads-al_sbr_hq_cm_48_5.1: REF = $(SAMPLES)/aac/al_sbr_hq_cm_48_5.1_reorder.s16
+
+FATE_AAC_FIXED += fate-aac-fixed-slice-threads-al06_44
+fate-aac-fixed-slice-threads-al06_44: CMD = threads=4 thread_type=slice pcm -c aac_fixed -i $(TARGET_SAMPLES)/aac/al06_44.mp4
+fate-aac-fixed-slice-threads-al06_44: REF = $(SAMPLES)/aac/al06_44_reorder.s16
+
 FATE_AAC_ENCODE += fate-aac-aref-encode
 fate-aac-aref-encode: ./tests/data/asynth-44100-2.wav
 fate-aac-aref-encode: CMD = enc_dec_pcm adts wav s16le $(REF) -c:a aac -aac_coder fast -aac_is 0 -aac_pns 0 -aac_ms 0 -aac_tns 0 -b:a 512k -fflags +bitexact -flags +bitexact
@@ -166,6 +182,16 @@ fate-aac-aref-encode: CMP_TARGET = 596
 fate-aac-aref-encode: SIZE_TOLERANCE = 2464
 fate-aac-aref-encode: FUZZ = 89
 
+FATE_AAC_ENCODE += fate-aac-aref-encode-threads
+fate-aac-aref-encode-threads: ./tests/data/asynth-44100-2.wav
+fate-aac-aref-encode-threads: CMD = enc_dec_pcm adts wav s16le $(REF) -c:a aac -aac_coder fast -aac_is 0 -aac_pns 0 -aac_ms 0 -aac_tns 0 -b:a 512k -threads 4 -thread_type slice -fflags +bitexact -flags +bitexact
+fate-aac-aref-encode-threads: CMP = stddev
+fate-aac-aref-encode-threads: REF = ./tests/data/asynth-44100-2.wav
+fate-aac-aref-encode-threads: CMP_SHIFT = -4096
+fate-aac-aref-encode-threads: CMP_TARGET = 596
+fate-aac-aref-encode-threads: SIZE_TOLERANCE = 2464
+fate-aac-aref-encode-threads: FUZZ = 89
+
 FATE_AAC_ENCODE += fate-aac-ln-encode
 fate-aac-ln-encode: CMD = enc_dec_pcm adts wav s16le $(TARGET_SAMPLES)/audio-reference/luckynight_2ch_44kHz_s16.wav -c:a aac -aac_coder fast -aac_is 0 -aac_pns 0 -aac_ms 0 -aac_tns 0 -b:a 512k -fflags +bitexact -flags +bitexact
 fate-aac-ln-encode: CMP = stddev
@@ -88,6 +88,16 @@ fate-unknown_layout-pcm: $(AREF)
 fate-unknown_layout-pcm: CMD = md5 \
   -guess_layout_max 0 -f s16le -ac 1 -ar 44100 -i $(TARGET_PATH)/$(AREF) -f s16le
 
+# The file size is not a multiple of the block sizes, so the last block ends
+# early; with 4099 byte blocks the demuxer reads also straddle blocks.
+FATE_FFMPEG-$(call REMUX, PCM_S16LE) += fate-file-readahead fate-file-write_behind
+fate-file-readahead fate-file-write_behind: $(AREF)
+fate-file-readahead: CMD = md5 \
+  -readahead 1 -io_block_size 4099 -f s16le -ac 1 -ar 44100 -i $(TARGET_PATH)/$(AREF) -c copy -f s16le
+fate-file-write_behind: CMD = md5 \
+  -f s16le -ac 1 -ar 44100 -i $(TARGET_PATH)/$(AREF) -c copy -write_behind 1 -io_block_size 4096 -f s16le
+fate-file-readahead fate-file-write_behind: REF = $(SRC_PATH)/tests/ref/fate/unknown_layout-pcm
+
 FATE_FFMPEG-$(call FILTERDEMDECENCMUX, ARESAMPLE, PCM_S32LE, PCM_S32LE, AC3_FIXED, AC3) += fate-unknown_layout-ac3
 fate-unknown_layout-ac3: $(AREF)
 fate-unknown_layout-ac3: CMD = md5 -auto_conversion_filters \
@@ -259,6 +269,15 @@ fate-ffmpeg-filter-in-eof: CMD = framecrc
     -filter_complex "[0][1]concat" -c:v rawvideo
 FATE_FFMPEG-$(call FRAMECRC, RAWVIDEO, RAWVIDEO, CONCAT_FILTER) += fate-ffmpeg-filter-in-eof
 
+# Same as above, but with the raw video packets mapped from the input files.
+fate-ffmpeg-filter-in-eof-mmap: tests/data/vsynth1.yuv
+fate-ffmpeg-filter-in-eof-mmap: CMD = framecrc                                                    \
+    -f rawvideo -s 352x288 -pix_fmt yuv420p -t 1 -mmap 1 -i $(TARGET_PATH)/tests/data/vsynth1.yuv  \
+    -f rawvideo -s 352x288 -pix_fmt yuv420p -t 1 -mmap 1 -i $(TARGET_PATH)/tests/data/vsynth1.yuv  \
+    -filter_complex "[0][1]concat" -c:v rawvideo
+fate-ffmpeg-filter-in-eof-mmap: REF = $(SRC_PATH)/tests/ref/fate/ffmpeg-filter-in-eof
+FATE_FFMPEG-$(call FRAMECRC, RAWVIDEO, RAWVIDEO, CONCAT_FILTER FILE_PROTOCOL) += fate-ffmpeg-filter-in-eof-mmap
+
 # Test termination on streamcopy with -t as an output option.
 fate-ffmpeg-streamcopy-t: tests/data/vsynth1.yuv
 fate-ffmpeg-streamcopy-t: CMP = null
@@ -267,6 +286,16 @@ fate-ffmpeg-streamcopy-t: CMD = ffmpeg
     -c copy -f null -t 1 -
 FATE_FFMPEG-$(call REMUX, RAWVIDEO, NULL_MUXER) += fate-ffmpeg-streamcopy-t
 
+# Test that the thread shares of all the nodes stay within -thread_budget,
+# including the decoder, which is opened before the other outputs are known.
+fate-ffmpeg-thread-budget: tests/data/vsynth1.yuv
+fate-ffmpeg-thread-budget: CMD = thread_budget 16                                           \
+    -f rawvideo -s 352x288 -pix_fmt yuv420p -i $(TARGET_PATH)/tests/data/vsynth1.yuv         \
+    -frames:v 5 -vf scale=176:144 -c:v mpeg4 -f null -                                      \
+    -frames:v 5 -vf scale=88:72   -c:v mpeg4 -f null -                                      \
+    -frames:v 5 -vf scale=44:36   -c:v mpeg4 -f null -
+FATE_FFMPEG-$(call FILTERDEMDECENCMUX, SCALE, RAWVIDEO, RAWVIDEO, MPEG4, NULL) += fate-ffmpeg-thread-budget
+
 # Test loopback decoding and passing the output to a complex graph.
 fate-ffmpeg-loopback-decoding: tests/data/vsynth1.yuv
 fate-ffmpeg-loopback-decoding: CMD = transcode \
@@ -199,6 +199,10 @@ fate-filter-colorchannelmixer: CMD = framecrc -c:v pgmyuv -i $(SRC) -vf scale,fo
 FATE_FILTER_VSYNTH_PGMYUV-$(CONFIG_DRAWBOX_FILTER) += fate-filter-drawbox
 fate-filter-drawbox: CMD = framecrc -c:v pgmyuv -i $(SRC) -vf drawbox=224:24:88:72:red@0.5
 
+FATE_FILTER_VSYNTH_PGMYUV-$(CONFIG_DRAWBOX_FILTER) += fate-filter-drawbox-frame-threads
+fate-filter-drawbox-frame-threads: CMD = framecrc -filter_thread_type frame -filter_threads 4 -c:v pgmyuv -i $(SRC) -vf drawbox=224:24:88:72:red@0.5
+fate-filter-drawbox-frame-threads: REF = $(SRC_PATH)/tests/ref/fate/filter-drawbox
+
 FATE_FILTER_VSYNTH_PGMYUV-$(CONFIG_FADE_FILTER) += fate-filter-fade
 fate-filter-fade: CMD = framecrc -c:v pgmyuv -i $(SRC) -vf fade=in:5:15,fade=out:30:15
 
@@ -230,6 +234,10 @@ fate-filter-negate: CMD = framecrc -c:v pgmyuv -i $(SRC) -vf perms=random,negate
 FATE_FILTER_VSYNTH_PGMYUV-$(CONFIG_HISTOGRAM_FILTER) += fate-filter-histogram-levels
 fate-filter-histogram-levels: CMD = framecrc -c:v pgmyuv -i $(SRC) -vf histogram -flags +bitexact -sws_flags +accurate_rnd+bitexact
 
+FATE_FILTER_VSYNTH_PGMYUV-$(CONFIG_HISTOGRAM_FILTER) += fate-filter-histogram-levels-frame-threads
+fate-filter-histogram-levels-frame-threads: CMD = framecrc -filter_thread_type frame -filter_threads 4 -c:v pgmyuv -i $(SRC) -vf histogram -flags +bitexact -sws_flags +accurate_rnd+bitexact
+fate-filter-histogram-levels-frame-threads: REF = $(SRC_PATH)/tests/ref/fate/filter-histogram-levels
+
 FATE_FILTER_VSYNTH_PGMYUV-$(CONFIG_WAVEFORM_FILTER) += fate-filter-waveform_column
 fate-filter-waveform_column: CMD = framecrc -c:v pgmyuv -i $(SRC) -vf waveform -flags +bitexact -sws_flags +accurate_rnd+bitexact
 
@@ -290,6 +298,12 @@ $(FATE_FILTER_OVERLAY): FILTERGRAPH = $(TARGET_PATH)/tests/data/filtergraphs/$(@
 $(FATE_FILTER_OVERLAY): fate-filter-%: tests/data/filtergraphs/%
 FATE_FILTER_VSYNTH-yes += $(FATE_FILTER_OVERLAY-yes)
 
+# split, scale, pad and overlay with adjacent filters activated concurrently
+FATE_FILTER_VSYNTH_PGMYUV-$(call ALLYES, SPLIT_FILTER SCALE_FILTER PAD_FILTER OVERLAY_FILTER) += fate-filter-overlay_yuv420-graph-threads
+fate-filter-overlay_yuv420-graph-threads: tests/data/filtergraphs/overlay_yuv420
+fate-filter-overlay_yuv420-graph-threads: CMD = framecrc -filter_thread_type slice+graph -filter_complex_threads 4 -c:v pgmyuv -i $(SRC) -/filter_complex $(TARGET_PATH)/tests/data/filtergraphs/overlay_yuv420
+fate-filter-overlay_yuv420-graph-threads: REF = $(SRC_PATH)/tests/ref/fate/filter-overlay_yuv420
+
 FATE_FILTER_OVERLAY_ALPHA-$(call FILTERDEMDEC, COLOR FORMAT OVERLAY SCALE, IMAGE_PNG_PIPE, PNG) := yuv420_yuva420 yuv422_yuva422 yuv444_yuva444 gbrp_gbrap yuva420_yuva420 yuva422_yuva422 yuva444_yuva444 gbrap_gbrap
 FATE_FILTER_OVERLAY_ALPHA-$(call FILTERDEMDEC, COLOR FORMAT OVERLAY, IMAGE_PNG_PIPE, PNG) += rgb_rgba rgba_rgba
 FATE_FILTER_OVERLAY_ALPHA := $(addprefix fate-filter-overlay_, $(FATE_FILTER_OVERLAY_ALPHA-yes))
@@ -340,6 +354,11 @@ FATE_FILTER-$(call FILTERFRAMECRC, SMPTEBARS SELECT, LAVFI_INDEV WRAPPED_AVFRAME
 fate-filter-select-buffering: tests/data/filtergraphs/select-buffering
 fate-filter-select-buffering: CMD = framecrc -filter_buffered_frames 1 -f lavfi -i "smptebars=d=21" -/filter_complex $(TARGET_PATH)/tests/data/filtergraphs/select-buffering -map "[o1]" -f null none -map "[o2]" -f null none -map "[o3]"
 
+FATE_FILTER-$(call FILTERFRAMECRC, SMPTEBARS SELECT, LAVFI_INDEV WRAPPED_AVFRAME_ENCODER NULL_MUXER) += fate-filter-select-buffering-graph-threads
+fate-filter-select-buffering-graph-threads: tests/data/filtergraphs/select-buffering
+fate-filter-select-buffering-graph-threads: CMD = framecrc -filter_buffered_frames 1 -filter_thread_type slice+graph -filter_complex_threads 4 -f lavfi -i "smptebars=d=21" -/filter_complex $(TARGET_PATH)/tests/data/filtergraphs/select-buffering -map "[o1]" -f null none -map "[o2]" -f null none -map "[o3]"
+fate-filter-select-buffering-graph-threads: REF = $(SRC_PATH)/tests/ref/fate/filter-select-buffering
+
 FATE_FILTER_VSYNTH_PGMYUV-$(call ALLYES, SETPTS_FILTER  SETTB_FILTER) += fate-filter-setpts
 fate-filter-setpts: tests/data/filtergraphs/setpts
 fate-filter-setpts: CMD = framecrc -c:v pgmyuv -i $(SRC) -/filter $(TARGET_PATH)/tests/data/filtergraphs/setpts
@@ -576,6 +595,10 @@ fate-filter-spp: CMD = framecrc -flags bitexact -export_side_data venc_params -i
 FATE_FILTER_VSYNTH1_MPEG4_QPRD-$(call FILTERDEMDEC, CODECVIEW, AVI, MPEG4) += codecview
 fate-filter-codecview: CMD = framecrc -flags bitexact -idct simple -flags2 +export_mvs -i $(TARGET_PATH)/tests/data/fate/vsynth1-mpeg4-qprd.avi -frames:v 5 -flags +bitexact -vf codecview=mv=pf+bf+bb
 
+FATE_FILTER_VSYNTH1_MPEG4_QPRD-$(call FILTERDEMDEC, CODECVIEW, AVI, MPEG4) += codecview-frame-threads
+fate-filter-codecview-frame-threads: CMD = framecrc -filter_thread_type frame -filter_threads 4 -flags bitexact -idct simple -flags2 +export_mvs -i $(TARGET_PATH)/tests/data/fate/vsynth1-mpeg4-qprd.avi -frames:v 5 -flags +bitexact -vf codecview=mv=pf+bf+bb
+fate-filter-codecview-frame-threads: REF = $(SRC_PATH)/tests/ref/fate/filter-codecview
+
 # The above tests use vsynth1-mpeg4-qprd.avi created by fate-vsynth1-mpeg4-qprd
 # as input. So only add them if all the requirements of fate-vsynth1-mpeg4-qprd
 # are met, add a dependency to the test and ensure that the file is kept.
@@ -203,6 +203,17 @@ FATE_H264  := $(FATE_H264:%=fate-h264-conformance-%)                    \
 FATE_H264-$(call FRAMECRC, H264, H264, H264_PARSER SCALE_FILTER) += $(FATE_H264_REINIT_TESTS:%=fate-h264-reinit-%)
 FATE_H264-$(call FRAMECRC, H264, H264, H264_PARSER) += $(FATE_H264)
 FATE_H264-$(call FRAMEMD5, H264, H264, H264_PARSER) += fate-h264-extreme-plane-pred
+
+# single-slice pictures are deblocked on a second slice thread, which must
+# match the serial output for P and B pictures too
+FATE_H264_SLICE_THREADS := ba1_sony_d                                   \
+                           caba3_toshiba_e                              \
+                           cvwp2_toshiba_e                              \
+                           frext-hpcv_brcm_a                            \
+
+FATE_H264_SLICE_THREADS := $(FATE_H264_SLICE_THREADS:%=fate-h264-slice-threads-%)
+$(FATE_H264_SLICE_THREADS): REF = $(SRC_PATH)/tests/ref/fate/h264-conformance-$(@:fate-h264-slice-threads-%=%)
+FATE_H264-$(call FRAMECRC, H264, H264, H264_PARSER) += $(FATE_H264_SLICE_THREADS)
 FATE_H264-$(call FRAMEMD5, MOV,  H264) += fate-h264-crop-to-container
 FATE_H264-$(call DEMDEC,   H264, H264, H264_PARSER)   += fate-h264-encparams
 
@@ -442,6 +453,11 @@ fate-h264-conformance-sva_nl1_b:                  CMD = framecrc -i $(TARGET_SAM
 fate-h264-conformance-sva_nl2_e:                  CMD = framecrc -i $(TARGET_SAMPLES)/h264-conformance/SVA_NL2_E.264
 fate-h264-conformance-slice2_field_aurora4:       CMD = framecrc -i $(TARGET_SAMPLES)/h264-conformance/slice2_field_aurora4.264
 
+fate-h264-slice-threads-ba1_sony_d:               CMD = threads=4 thread_type=slice framecrc -i $(TARGET_SAMPLES)/h264-conformance/BA1_Sony_D.jsv
+fate-h264-slice-threads-caba3_toshiba_e:          CMD = threads=4 thread_type=slice framecrc -i $(TARGET_SAMPLES)/h264-conformance/CABA3_TOSHIBA_E.264
+fate-h264-slice-threads-cvwp2_toshiba_e:          CMD = threads=4 thread_type=slice framecrc -i $(TARGET_SAMPLES)/h264-conformance/CVWP2_TOSHIBA_E.264
+fate-h264-slice-threads-frext-hpcv_brcm_a:        CMD = threads=4 thread_type=slice framecrc -i $(TARGET_SAMPLES)/h264-conformance/FRext/HPCV_BRCM_A.264
+
 fate-h264-bsf-mp4toannexb:                        CMD = md5 -i $(TARGET_SAMPLES)/h264/interlaced_crop.mp4 -c:v copy -f h264
 # First IDR is prefixed by SPS/PPS
 fate-h264-bsf-mp4toannexb-2:                      CMD = md5 -i $(TARGET_SAMPLES)/h264/ps_prefix_first_idr.mp4 -c:v copy -f h264
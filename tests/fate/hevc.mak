@@ -221,6 +221,31 @@ FATE_HEVC-$(call FRAMECRC, HEVC, HEVC, HEVC_PARSER SCALE_FILTER) +=         \
 
 FATE_HEVC-$(call FRAMECRC, HEVC, HEVC, HEVC_PARSER SCALE_FILTER SETPTS_FILTER) += $(HEVC_TESTS_MULTIVIEW)
 
+# hybrid frame and slice threading must match the plain conformance output,
+# -cpucount makes sure the slice pool is created on single core machines
+HEVC_SAMPLES_HYBRID_THREADS =   \
+    DBLK_A_SONY_3               \
+    WPP_B_ericsson_MAIN_2       \
+
+HEVC_TESTS_HYBRID_THREADS := $(addprefix fate-hevc-hybrid-threads-, $(HEVC_SAMPLES_HYBRID_THREADS))
+$(HEVC_TESTS_HYBRID_THREADS): CMD = threads=4 thread_type=frame+slice+hybrid framecrc -cpucount 4 -flags output_corrupt -i $(TARGET_SAMPLES)/hevc-conformance/$(subst fate-hevc-hybrid-threads-,,$(@)).bit -pix_fmt yuv420p
+$(HEVC_TESTS_HYBRID_THREADS): REF = $(SRC_PATH)/tests/ref/fate/hevc-conformance-$(subst fate-hevc-hybrid-threads-,,$(@))
+FATE_HEVC-$(call FRAMECRC, HEVC, HEVC, HEVC_PARSER) += $(HEVC_TESTS_HYBRID_THREADS)
+
+# with slice threads the loop filter runs behind the entropy decoder on
+# another thread, which must match the plain conformance output
+HEVC_SAMPLES_SLICE_THREADS =    \
+    DBLK_B_SONY_3               \
+    DBLK_E_VIXS_2               \
+    SAO_A_MediaTek_4            \
+    SAO_D_Samsung_5             \
+    WPP_A_ericsson_MAIN_2       \
+
+HEVC_TESTS_SLICE_THREADS := $(addprefix fate-hevc-slice-threads-, $(HEVC_SAMPLES_SLICE_THREADS))
+$(HEVC_TESTS_SLICE_THREADS): CMD = threads=4 thread_type=slice framecrc -cpucount 4 -flags output_corrupt -i $(TARGET_SAMPLES)/hevc-conformance/$(subst fate-hevc-slice-threads-,,$(@)).bit -pix_fmt yuv420p
+$(HEVC_TESTS_SLICE_THREADS): REF = $(SRC_PATH)/tests/ref/fate/hevc-conformance-$(subst fate-hevc-slice-threads-,,$(@))
+FATE_HEVC-$(call FRAMECRC, HEVC, HEVC, HEVC_PARSER) += $(HEVC_TESTS_SLICE_THREADS)
+
 fate-hevc-paramchange-yuv420p-yuv420p10: CMD = framecrc -i $(TARGET_SAMPLES)/hevc/paramchange_yuv420p_yuv420p10.hevc -fps_mode passthrough -sws_flags area+accurate_rnd+bitexact
 FATE_HEVC-$(call FRAMECRC, HEVC, HEVC, HEVC_PARSER SCALE_FILTER LARGE_TESTS) += fate-hevc-paramchange-yuv420p-yuv420p10
 
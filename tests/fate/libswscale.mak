@@ -36,6 +36,16 @@ FATE_LIBSWSCALE-$(CONFIG_UNSTABLE) += fate-sws-unscaled
 fate-sws-unscaled: libswscale/tests/swscale$(EXESUF)
 fate-sws-unscaled: CMD = run libswscale/tests/swscale$(EXESUF) -unscaled 1 -flags unstable -v 16
 
+FATE_LIBSWSCALE-$(CONFIG_UNSTABLE) += fate-sws-cache
+fate-sws-cache: libswscale/tests/sws_cache$(EXESUF)
+fate-sws-cache: CMD = run libswscale/tests/sws_cache$(EXESUF)
+fate-sws-cache: CMP = null
+
+FATE_LIBSWSCALE-$(CONFIG_UNSTABLE) += fate-sws-ops-fused
+fate-sws-ops-fused: libswscale/tests/sws_ops_fused$(EXESUF)
+fate-sws-ops-fused: CMD = run libswscale/tests/sws_ops_fused$(EXESUF)
+fate-sws-ops-fused: CMP = null
+
 ifneq ($(HAVE_BIGENDIAN),yes)
 # Disable on big endian because big endian platforms generate different op
 # lists for le vs be formats; this breaks the checksum otherwise
@@ -14,6 +14,9 @@ FATE_MOV-$(call FRAMEMD5, MOV, H264) += fate-mov-3elist \
            fate-mov-frag-overlap \
            fate-mov-neg-firstpts-discard-frames \
 
+FATE_MOV-$(call FRAMEMD5, MOV, H264) += fate-mov-3elist-compact-index \
+           fate-mov-2elist-elist1-ends-bframe-compact-index \
+
 FATE_MOV-$(call FRAMEMD5, MOV, H264, FPS_FILTER) += fate-mov-stream-shorter-than-movie \
 
 FATE_MOV-$(call FRAMEMD5, MOV, MPEG4) += fate-mov-invalid-elst-entry-count \
@@ -82,6 +85,12 @@ fate-mov-1elist-ends-last-bframe: CMD = framemd5 -i $(TARGET_SAMPLES)/mov/mov-1e
 # Makes sure that we handle timestamps of packets in case of multiple edit lists with one of them ending on a B-frame correctly.
 fate-mov-2elist-elist1-ends-bframe: CMD = framemd5 -i $(TARGET_SAMPLES)/mov/mov-2elist-elist1-ends-bframe.mov
 
+# The compact index must give the same packets as the regular one.
+fate-mov-3elist-compact-index: CMD = framemd5 -compact_index 1 -i $(TARGET_SAMPLES)/mov/mov-3elist.mov
+fate-mov-3elist-compact-index: REF = $(SRC_PATH)/tests/ref/fate/mov-3elist
+fate-mov-2elist-elist1-ends-bframe-compact-index: CMD = framemd5 -compact_index 1 -i $(TARGET_SAMPLES)/mov/mov-2elist-elist1-ends-bframe.mov
+fate-mov-2elist-elist1-ends-bframe-compact-index: REF = $(SRC_PATH)/tests/ref/fate/mov-2elist-elist1-ends-bframe
+
 # Makes sure that if edit list ends on a B-frame but before the I-frame, then we output the B-frame but discard the I-frame.
 fate-mov-elst-ends-betn-b-and-i: CMD = framemd5 -i $(TARGET_SAMPLES)/mov/elst_ends_betn_b_and_i.mp4
 
@@ -37,8 +37,18 @@ fate-opus-silk-lbrr:         CMP_TARGET = 0
 fate-opus-tron.6ch.tinypkts: CMP_SHIFT = 1440
 fate-opus-tron.6ch.tinypkts: CMP_TARGET = 0
 
-FATE_SAMPLES_FFMPEG += $(FATE_OPUS)
+# the streams of multistream packets are decoded on the slice threads
+FATE_OPUS_THREADS-$(call FILTERDEMDECENCMUX, ARESAMPLE, MATROSKA, OPUS, PCM_S16LE, PCM_S16LE, PIPE_PROTOCOL) := fate-opus-tron.6ch.tinypkts-threads
+fate-opus-tron.6ch.tinypkts-threads: CMD = threads=4 thread_type=slice ffmpeg -i $(TARGET_SAMPLES)/opus/tron.6ch.tinypkts.mka -f s16le -af aresample -
+fate-opus-tron.6ch.tinypkts-threads: REF = $(SAMPLES)/opus/tron.6ch.tinypkts.dec
+fate-opus-tron.6ch.tinypkts-threads: CMP = stddev
+fate-opus-tron.6ch.tinypkts-threads: CMP_UNIT = s16
+fate-opus-tron.6ch.tinypkts-threads: FUZZ = 3
+fate-opus-tron.6ch.tinypkts-threads: CMP_SHIFT = 1440
+fate-opus-tron.6ch.tinypkts-threads: CMP_TARGET = 0
+
+FATE_SAMPLES_FFMPEG += $(FATE_OPUS) $(FATE_OPUS_THREADS-yes)
 fate-opus-celt: $(FATE_OPUS_CELT-yes)
 fate-opus-hybrid: $(FATE_OPUS_HYBRID-yes)
 fate-opus-silk: $(FATE_OPUS_SILK-yes)
-fate-opus: $(FATE_OPUS)
+fate-opus: $(FATE_OPUS) $(FATE_OPUS_THREADS-yes)
@@ -151,6 +151,20 @@ FATE_SEEK_LAVF_CONTAINER := $(FATE_SEEK_LAVF_CONTAINER:%=fate-seek-lavf-%)
 FATE_SEEK_LAVF_CONTAINER := $(filter $(subst fate-,fate-seek-,$(FATE_LAVF_CONTAINER)), $(FATE_SEEK_LAVF_CONTAINER))
 FATE_SEEK += $(FATE_SEEK_LAVF_CONTAINER)
 
+# seeking with the compact mov index must match the regular one
+FATE_SEEK_COMPACT_INDEX := $(filter fate-seek-lavf-mov, $(FATE_SEEK_LAVF_CONTAINER))
+FATE_SEEK_COMPACT_INDEX := $(FATE_SEEK_COMPACT_INDEX:%=%-compact-index)
+$(FATE_SEEK_COMPACT_INDEX): fate-lavf-mov
+$(FATE_SEEK_COMPACT_INDEX): CMD = run libavformat/tests/seek$(EXESUF) $(TARGET_PATH)/tests/data/lavf/lavf.mov -compact_index 1
+$(FATE_SEEK_COMPACT_INDEX): REF = $(SRC_PATH)/tests/ref/seek/lavf-mov
+
+# seeking through the read-ahead blocks must match direct reads
+FATE_SEEK_READAHEAD := $(filter fate-seek-lavf-nut, $(FATE_SEEK_LAVF_CONTAINER))
+FATE_SEEK_READAHEAD := $(FATE_SEEK_READAHEAD:%=%-readahead)
+$(FATE_SEEK_READAHEAD): fate-lavf-nut
+$(FATE_SEEK_READAHEAD): CMD = run libavformat/tests/seek$(EXESUF) $(TARGET_PATH)/tests/data/lavf/lavf.nut -readahead 2 -io_block_size 4099
+$(FATE_SEEK_READAHEAD): REF = $(SRC_PATH)/tests/ref/seek/lavf-nut
+
 # files from fate-lavf-video
 
 FATE_SEEK_LAVF_VIDEO += gif y4m
@@ -188,24 +202,30 @@ FATE_SEEK_EXTRA-$(call ALLYES, MOV_DEMUXER) += fate-seek-extra-mp4
 FATE_SEEK_EXTRA-$(call ALLYES, MOV_DEMUXER) += fate-seek-empty-edit-mp4
 FATE_SEEK_EXTRA-$(call ALLYES, MOV_DEMUXER) += fate-seek-test-iibbibb-mp4
 FATE_SEEK_EXTRA-$(call ALLYES, MOV_DEMUXER) += fate-seek-test-iibbibb-neg-ctts-mp4
+FATE_SEEK_EXTRA-$(call ALLYES, MOV_DEMUXER) += fate-seek-empty-edit-mp4-compact-index
+FATE_SEEK_EXTRA-$(call ALLYES, MOV_DEMUXER) += fate-seek-test-iibbibb-mp4-compact-index
 
 fate-seek-extra-mp3:  CMD = run libavformat/tests/seek$(EXESUF) $(TARGET_SAMPLES)/gapless/gapless.mp3 -fastseek 1
 fate-seek-extra-mp4:  CMD = run libavformat/tests/seek$(EXESUF) $(TARGET_SAMPLES)/mov/buck480p30_na.mp4 -duration 180 -frames 4
 fate-seek-empty-edit-mp4:  CMD = run libavformat/tests/seek$(EXESUF) $(TARGET_SAMPLES)/mov/empty_edit_5s.mp4 -duration 15 -frames 4
 fate-seek-test-iibbibb-mp4:  CMD = run libavformat/tests/seek$(EXESUF) $(TARGET_SAMPLES)/mov/test_iibbibb.mp4 -duration 13 -frames 4
 fate-seek-test-iibbibb-neg-ctts-mp4:  CMD = run libavformat/tests/seek$(EXESUF) $(TARGET_SAMPLES)/mov/test_iibbibb_neg_ctts.mp4 -duration 13 -frames 4
+fate-seek-empty-edit-mp4-compact-index: CMD = run libavformat/tests/seek$(EXESUF) $(TARGET_SAMPLES)/mov/empty_edit_5s.mp4 -duration 15 -frames 4 -compact_index 1
+fate-seek-empty-edit-mp4-compact-index: REF = $(SRC_PATH)/tests/ref/seek/empty-edit-mp4
+fate-seek-test-iibbibb-mp4-compact-index: CMD = run libavformat/tests/seek$(EXESUF) $(TARGET_SAMPLES)/mov/test_iibbibb.mp4 -duration 13 -frames 4 -compact_index 1
+fate-seek-test-iibbibb-mp4-compact-index: REF = $(SRC_PATH)/tests/ref/seek/test-iibbibb-mp4
 fate-seek-cache-pipe: CMD = cat $(SAMPLES)/gapless/gapless.mp3 | run libavformat/tests/seek$(EXESUF) cache:pipe:0 -read_ahead_limit -1
 fate-seek-mkv-codec-delay:   CMD = run libavformat/tests/seek$(EXESUF) $(TARGET_SAMPLES)/mkv/codec_delay_opus.mkv
 
 FATE_SEEK_EXTRA += $(FATE_SEEK_EXTRA-yes)
 
 
-$(FATE_SEEK) $(FATE_SAMPLES_SEEK) $(FATE_SEEK_EXTRA): libavformat/tests/seek$(EXESUF)
+$(FATE_SEEK) $(FATE_SAMPLES_SEEK) $(FATE_SEEK_EXTRA) $(FATE_SEEK_COMPACT_INDEX) $(FATE_SEEK_READAHEAD): libavformat/tests/seek$(EXESUF)
 $(FATE_SEEK) $(FATE_SAMPLES_SEEK): CMD = run libavformat/tests/seek$(EXESUF) $(TARGET_PATH)/tests/data/$(SRC)
 $(FATE_SEEK) $(FATE_SAMPLES_SEEK): fate-seek-%: fate-%
 $(subst fate-seek-,fate-,$(FATE_SAMPLES_SEEK) $(FATE_SEEK)): KEEP_FILES ?= 1
 fate-seek-%: REF = $(SRC_PATH)/tests/ref/seek/$(@:fate-seek-%=%)
 
-FATE_AVCONV += $(FATE_SEEK)
+FATE_AVCONV += $(FATE_SEEK) $(FATE_SEEK_COMPACT_INDEX) $(FATE_SEEK_READAHEAD)
 FATE_SAMPLES_AVCONV += $(FATE_SAMPLES_SEEK) $(FATE_SEEK_EXTRA)
-fate-seek:     $(FATE_SEEK) $(FATE_SAMPLES_SEEK) $(FATE_SEEK_EXTRA)
+fate-seek:     $(FATE_SEEK) $(FATE_SAMPLES_SEEK) $(FATE_SEEK_EXTRA) $(FATE_SEEK_COMPACT_INDEX) $(FATE_SEEK_READAHEAD)
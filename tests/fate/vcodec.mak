@@ -130,7 +130,7 @@ fate-vsynth%-dnxhd-hr-hq-mov:   DECOPTS = -sws_flags area+accurate_rnd+bitexact
 $(FATE_VCODEC_DNXHD_MOV:%=fate-vsynth\%-%): FMT      = mov
 $(FATE_VCODEC_DNXHD_MOV:%=fate-vsynth\%-%): DECOPTS += $(DEFAULT_SIZE)
 
-FATE_VCODEC_DV := dv dv-411 dv-50 dv-hd dv-fhd
+FATE_VCODEC_DV := dv dv-411 dv-50 dv-hd dv-hd-frame-thread dv-fhd
 FATE_VCODEC_SCALE-$(call ENCDEC, DVVIDEO, DV) += $(FATE_VCODEC_DV)
 fate-vsynth%-dv:                 ENCOPTS = -dct int -s pal
 
@@ -150,6 +150,13 @@ fate-vsynth%-dv-hd:              ENCOPTS = -dct int -s 960x720 -pix_fmt yuv422p
                                            -sws_flags neighbor
 fate-vsynth%-dv-hd:              DECOPTS = -sws_flags neighbor
 
+# 720p frames alternate between two channel halves based on the frame number,
+# so frame-threaded encoding must produce the same output as dv-hd
+fate-vsynth%-dv-hd-frame-thread: ENCOPTS = -dct int -s 960x720 -pix_fmt yuv422p \
+                                           -sws_flags neighbor \
+                                           -threads 4 -thread_type frame
+fate-vsynth%-dv-hd-frame-thread: DECOPTS = -sws_flags neighbor
+
 $(FATE_VCODEC_DV:%=fate-vsynth\%-%): CODEC    = dvvideo
 $(FATE_VCODEC_DV:%=fate-vsynth\%-%): FMT      = dv
 $(FATE_VCODEC_DV:%=fate-vsynth\%-%): DECOPTS += $(DEFAULT_SIZE)
@@ -227,12 +234,22 @@ FATE_VCODEC_SCALE-$(call ENCDEC, JPEGLS, AVI) += jpegls
 fate-vsynth%-jpegls:             ENCOPTS = -sws_flags neighbor+full_chroma_int
 fate-vsynth%-jpegls:             DECOPTS = -sws_flags area
 
+FATE_VCODEC_SCALE-$(call ENCDEC, JPEGLS, AVI) += jpegls-frame-thread
+fate-vsynth%-jpegls-frame-thread: ENCOPTS = -sws_flags neighbor+full_chroma_int
+fate-vsynth%-jpegls-frame-thread: DECOPTS = -sws_flags area
+fate-vsynth%-jpegls-frame-thread: THREADS = 4
+fate-vsynth%-jpegls-frame-thread: THREAD_TYPE = frame
+
 FATE_VCODEC_SCALE-$(call ENCDEC, JPEG2000, AVI) += jpeg2000 jpeg2000-97 jpeg2000-gbrp12 jpeg2000-yuva444p16
 fate-vsynth%-jpeg2000:                ENCOPTS = -qscale 7 -pred 1 -pix_fmt rgb24
 fate-vsynth%-jpeg2000-97:             ENCOPTS = -qscale 7 -pix_fmt rgb24
 fate-vsynth%-jpeg2000-gbrp12:         ENCOPTS = -qscale 5 -pred 1 -pix_fmt gbrp12
 fate-vsynth%-jpeg2000-yuva444p16:     ENCOPTS = -qscale 8 -pred 1 -pix_fmt yuva444p16
 
+FATE_VCODEC_SCALE-$(call ENCDEC, JPEG2000, AVI) += jpeg2000-thread jpeg2000-97-thread
+fate-vsynth%-jpeg2000-thread:         ENCOPTS = -qscale 7 -pred 1 -pix_fmt rgb24 -threads 4 -thread_type slice
+fate-vsynth%-jpeg2000-97-thread:      ENCOPTS = -qscale 7 -pix_fmt rgb24 -threads 4 -thread_type slice
+
 FATE_VCODEC-$(call ENCDEC, LJPEG MJPEG, AVI) += ljpeg
 fate-vsynth%-ljpeg:              ENCOPTS = -strict -1
 
@@ -253,6 +270,17 @@ fate-vsynth%-mjpeg-trell:             ENCOPTS = -qscale 9 -pix_fmt yuvj420p -tre
 fate-vsynth%-mjpeg-huffman:           ENCOPTS = -qscale 9 -pix_fmt yuvj420p -huffman optimal
 fate-vsynth%-mjpeg-trell-huffman:     ENCOPTS = -qscale 9 -pix_fmt yuvj420p -trellis 1 -huffman optimal
 
+FATE_VCODEC_SCALE-$(call ENCDEC, MJPEG, AVI) += mjpeg-frame-thread
+fate-vsynth%-mjpeg-frame-thread:      ENCOPTS = -qscale 9 -pix_fmt yuvj420p -huffman default -threads 5 -thread_type slice
+fate-vsynth%-mjpeg-frame-thread:      THREADS = 4
+fate-vsynth%-mjpeg-frame-thread:      THREAD_TYPE = frame
+
+# the slice-threaded encoder writes restart markers, decode them in parallel
+FATE_VCODEC_SCALE-$(call ENCDEC, MJPEG, AVI) += mjpeg-slice-thread
+fate-vsynth%-mjpeg-slice-thread:      ENCOPTS = -qscale 9 -pix_fmt yuvj420p -huffman default -threads 5 -thread_type slice
+fate-vsynth%-mjpeg-slice-thread:      THREADS = 4
+fate-vsynth%-mjpeg-slice-thread:      THREAD_TYPE = slice
+
 FATE_VCODEC-$(call ENCDEC, MPEG1VIDEO, MPEG1VIDEO MPEGVIDEO) += mpeg1 mpeg1b
 fate-vsynth%-mpeg1:              FMT     = mpeg1video
 fate-vsynth%-mpeg1:              CODEC   = mpeg1video
@@ -268,7 +296,9 @@ FATE_MPEG2 := mpeg2                                                     \
              mpeg2-ilace                                                \
              mpeg2-ivlc-qprd                                            \
              mpeg2-thread                                               \
-             mpeg2-thread-ivlc
+             mpeg2-thread-ivlc                                          \
+             mpeg2-bstrategy2                                           \
+             mpeg2-bstrategy2-thread
 
 FATE_VCODEC-$(call ENCDEC, MPEG2VIDEO, MPEG2VIDEO MPEGVIDEO) += $(FATE_MPEG2)
 
@@ -297,6 +327,9 @@ fate-vsynth%-mpeg2-thread:       ENCOPTS = -qscale 10 -bf 2 -flags +ildct+ilme \
                                            -threads 2 -slices 2
 fate-vsynth%-mpeg2-thread-ivlc:  ENCOPTS = -qscale 10 -bf 2 -flags +ildct+ilme \
                                            -intra_vlc 1 -threads 2 -slices 2
+fate-vsynth%-mpeg2-bstrategy2:   ENCOPTS = -qscale 10 -bf 3 -b_strategy 2 -slices 4
+fate-vsynth%-mpeg2-bstrategy2-thread: ENCOPTS = -qscale 10 -bf 3 -b_strategy 2 -slices 4 \
+                                           -threads 4 -thread_type slice
 
 FATE_MPEG4_MP4 = mpeg4
 FATE_MPEG4_AVI = mpeg4-rc                                               \
@@ -505,7 +538,12 @@ FATE_VCODEC += $(FATE_VCODEC-yes)
 FATE_VCODEC := $(if $(call ENCDEC, RAWVIDEO, RAWVIDEO),$(FATE_VCODEC))
 FATE_VSYNTH1 = $(FATE_VCODEC:%=fate-vsynth1-%)
 FATE_VSYNTH2 = $(FATE_VCODEC:%=fate-vsynth2-%)
-FATE_VSYNTH_LENA = $(FATE_VCODEC:%=fate-vsynth_lena-%)
+# No vsynth_lena references yet
+LENA_OFF     = dv-hd-frame-thread jpeg2000-thread jpeg2000-97-thread \
+               jpegls-frame-thread mjpeg-frame-thread mjpeg-slice-thread \
+               mpeg2-bstrategy2 mpeg2-bstrategy2-thread
+FATE_VCODEC_LENA = $(filter-out $(LENA_OFF),$(FATE_VCODEC))
+FATE_VSYNTH_LENA = $(FATE_VCODEC_LENA:%=fate-vsynth_lena-%)
 # Redundant tests because they just resize the input
 RESIZE_OFF   = dnxhd-720p dnxhd-720p-rd dnxhd-720p-10bit dnxhd-1080i \
                dv dv-411 dv-50 avui snow snow-hpel snow-ll vc2-420p \